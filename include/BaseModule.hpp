@@ -12,6 +12,7 @@
 #include <vector>
 #include "Utils.hpp"
 #include "Logger.hpp"
+#include "EventHandling.hpp"
 
 namespace ModelController
 {
@@ -70,6 +71,24 @@ namespace ModelController
             //!
             static ModuleDataType GetDataTypeById(const std::type_info& typeInfo);
             //!
+            //! @brief Exposure of a port to the API (e.g. mqtt)
+            //!
+            enum class ApiExposure
+            {
+                eInherit,   //!< Exposure is taken from the parent modules
+                eNone,      //!< Port isn't connected to the API
+                eReadOnly,  //!< Value is published, inputs can't be set by the API
+                eReadWrite, //!< Value is published, inputs without source are set by the API
+                eLazy,      //!< Port is exposed read-write on first access by the API
+            };
+            //!
+            //! @brief Get ApiExposure by name
+            //!
+            //! @param name "none", "read-only", "read-write" or "lazy"
+            //! @return ApiExposure Matching exposure, eInherit if name is unknown
+            //!
+            static ApiExposure ToApiExposure(std::string name);
+            //!
             //! @brief Get the Type of the module
             //!
             //! @return ModuleType Type of the object
@@ -89,6 +108,10 @@ namespace ModelController
             //! @brief Name of the controller
             //!
             static std::string edgeName;
+            //!
+            //! @brief Event raised, if a module is destroyed (only the pointer may be used by listeners)
+            //!
+            static Event<BaseModule*> ModuleDeleted;
         private:
             //!
             //! @brief Parent of the module object
@@ -158,6 +181,22 @@ namespace ModelController
             //! @return std::vector<std::string> List with paths to all containers of type
             //!
             std::vector<std::string> GetContainers(std::string type);
+            //!
+            //! @brief Get the ports (inputs and outputs) of the object and its children
+            //!
+            //! @return std::vector<BaseModule*> List with all ports
+            //!
+            std::vector<BaseModule*> GetPorts();
+            //!
+            //! @brief Get the exposure of the object to the API from the "api" config of its parents
+            //!
+            //! "api" is either the exposure of all ports below the module or an object with
+            //! exposures of ports by relative path and "default" for the remaining ports.
+            //! The nearest parent with a matching entry wins, default is read-write.
+            //!
+            //! @return ApiExposure Exposure of the object (never eInherit)
+            //!
+            ApiExposure GetApiExposure() const;
         public:
             //!
             //! @brief Root module of the hardware configuration
@@ -194,6 +233,14 @@ namespace ModelController
             //!
             static BaseModule* GenerateModule(std::string name, JsonObject moduleConfig, BaseModule* parent = nullptr);
             //!
+            //! @brief Check config of a module and its children like GenerateModule would create them
+            //!
+            //! @param name Name of the module (prefix of error messages)
+            //! @param moduleConfig Config of the module
+            //! @return std::string Error message with the path in the config, empty if config is valid
+            //!
+            static std::string ValidateModule(std::string name, JsonObject moduleConfig);
+            //!
             //! @brief Default config file path
             //!
             static constexpr const char* defaultConfigFile = "/SmallConfig.json";
@@ -216,6 +263,13 @@ namespace ModelController
             //!
             std::string GetName() const;
             //!
+            //! @brief Connect port with lazy exposure to the API
+            //!
+            //! @return true Port was connected to the API by this call
+            //! @return false Port isn't lazy, already exposed or API isn't available
+            //!
+            virtual bool Expose();
+            //!
             //! @brief Delete module with path
             //!
             //! @param path Path to module to be deleted
@@ -230,6 +284,13 @@ namespace ModelController
             //!
             static std::string Set(std::string path, std::string config);
             //!
+            //! @brief Check if config could be set, without changing any module
+            //!
+            //! @param config Config of the module to be set
+            //! @return std::string Error message, empty if config is valid
+            //!
+            static std::string Validate(std::string config);
+            //!
             //! @brief Get a module by path
             //!
             //! @param modulePath Path of the module
@@ -303,6 +364,13 @@ namespace ModelController
             //!
             static std::vector<std::string> GetContainers(std::string path, std::string type);
             //!
+            //! @brief Get ports (inputs and outputs) at or below path
+            //!
+            //! @param path Path of module to search from
+            //! @return std::vector<BaseModule*> List with all ports
+            //!
+            static std::vector<BaseModule*> GetPorts(std::string path);
+            //!
             //! @brief Update hardware configuration
             //!
             //! @param config Json object with new hardware config
@@ -0,0 +1,40 @@
+//!
+//! @file Clock.hpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Monotonic 64 bit microsecond time base
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+#include <cstdint>
+
+namespace ModelController
+{
+    class Clock
+    {
+        private:
+            //!
+            //! @brief Source of the time, nullptr for the ESP timer
+            //!
+            static uint64_t (*source)();
+            //!
+            //! @brief Pure static class -> deleted ctor
+            //!
+            Clock() = delete;
+        public:
+            //!
+            //! @brief Get the time since boot in microseconds
+            //!
+            //! Doesn't wrap in practice (after more than 500000 years), unlike millis() after 49.7 days
+            //!
+            //! @return uint64_t Actual time in microseconds
+            //!
+            static uint64_t Now();
+            //!
+            //! @brief Replace the source of the time (e.g. to simulate a long uptime)
+            //!
+            //! @param source Function returning the time in microseconds, nullptr to use the ESP timer
+            //!
+            static void SetSource(uint64_t (*source)());
+    };
+} // namespace ModelController
@@ -7,8 +7,10 @@
 //!
 #pragma once
 
-#include "WebServer.h"
+#include "ESPAsyncWebServer.h"
 #include <string>
+#include <deque>
+#include <atomic>
 #include "ConfigFile.hpp"
 #include "BaseModule.hpp"
 
@@ -18,9 +20,9 @@ namespace ModelController
     {
         private:
             //!
-            //! @brief Webserver for API calls
+            //! @brief Asynchronous webserver for API calls (requests are handled by the TCP task, not by the loop)
             //!
-            static WebServer server;
+            static AsyncWebServer server;
             //!
             //! @brief True if API is listening
             //!
@@ -30,37 +32,132 @@ namespace ModelController
             //!
             static bool initialized;
             //!
+            //! @brief Maximum size of a request body in bytes
+            //!
+            static constexpr size_t maxBodySize = 16384;
+            //!
+            //! @brief Number of results of executed set requests kept for /SetResult
+            //!
+            static constexpr size_t maxSetResults = 8;
+            //!
+            //! @brief Id of the next set request
+            //!
+            static std::atomic<uint32_t> nextSetId;
+            //!
+            //! @brief Id of the last set request executed by the loop (0 if none, protected by the loop mutex)
+            //!
+            static uint32_t lastSetId;
+            //!
+            //! @brief Error messages (empty on success) of the last executed set requests by id (protected by the loop mutex)
+            //!
+            static std::deque<std::pair<uint32_t, std::string>> setResults;
+            //!
             //! @brief Delete default ctor for pure static object
             //!
             ConfigAPI() = delete;
             //!
             //! @brief Extract path out of args
             //!
+            //! @param request Request to get path from
             //! @return std::string Path from args
             //!
-            static std::string GetPathFromArgs();
+            static std::string GetPathFromArgs(AsyncWebServerRequest* request);
             //!
             //! @brief Extract arg value out of args
             //!
-            //! @return std::string Name of the argument
+            //! @param request Request to get arg from
+            //! @param arg Name of the argument
+            //! @return std::string Value of the argument
+            //!
+            static std::string GetFromArgs(AsyncWebServerRequest* request, std::string arg);
             //!
-            static std::string GetFromArgs(std::string arg);
+            //! @brief Get body received with request
+            //!
+            //! @param request Request to get body from
+            //! @return std::string Body of the request
+            //!
+            static std::string GetBody(AsyncWebServerRequest* request);
+            //!
+            //! @brief Check that the body of a request doesn't exceed the maximum size (answers 413 otherwise)
+            //!
+            //! @param request Request to check
+            //! @return true Body fits
+            //! @return false Body is too large and the request was answered
+            //!
+            static bool CheckBodySize(AsyncWebServerRequest* request);
+            //!
+            //! @brief Collect body chunks of a request
+            //!
+            //! @param request Request the chunk belongs to
+            //! @param data Data of the chunk
+            //! @param length Length of the chunk
+            //! @param index Position of the chunk in the body
+            //! @param total Total size of the body
+            //!
+            static void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t length, size_t index, size_t total);
             //!
             //! @brief Handle method to get parameters
             //!
-            static void handleGetParameters();
+            //! @param request Received request
+            //!
+            static void handleGetParameters(AsyncWebServerRequest* request);
             //!
             //! @brief Handle method to get containers
             //!
-            static void handleGetContainers();
+            //! @param request Received request
+            //!
+            static void handleGetContainers(AsyncWebServerRequest* request);
             //!
             //! @brief Handle POST request on path /Delete
             //!
-            static void handleDelete();
+            //! @param request Received request
+            //!
+            static void handleDelete(AsyncWebServerRequest* request);
             //!
             //! @brief Handle POST request on path /Set
             //!
-            static void handleSet();
+            //! @param request Received request
+            //!
+            static void handleSet(AsyncWebServerRequest* request);
+            //!
+            //! @brief Handle GET request on path /SetResult (result of a set request by id)
+            //!
+            //! @param request Received request
+            //!
+            static void handleGetSetResult(AsyncWebServerRequest* request);
+            //!
+            //! @brief Write value of an input or output to json
+            //!
+            //! @param module Input or output module
+            //! @param value Json variant the value is written to
+            //! @return true Value was written
+            //! @return false Module is neither input nor output
+            //!
+            static bool GetJsonValue(BaseModule* module, JsonVariant value);
+            //!
+            //! @brief Handle GET request on path /Value
+            //!
+            //! @param request Received request
+            //!
+            static void handleGetValue(AsyncWebServerRequest* request);
+            //!
+            //! @brief Handle GET request on path /Values (values of several paths or of all ports below a prefix)
+            //!
+            //! @param request Received request
+            //!
+            static void handleGetValues(AsyncWebServerRequest* request);
+            //!
+            //! @brief Handle POST request on path /Value
+            //!
+            //! @param request Received request
+            //!
+            static void handleSetValue(AsyncWebServerRequest* request);
+            //!
+            //! @brief Handle GET request on path /metrics
+            //!
+            //! @param request Received request
+            //!
+            static void handleGetMetrics(AsyncWebServerRequest* request);
             //!
             //! @brief Initialize routes
             //!
@@ -73,4 +170,4 @@ namespace ModelController
             //!
             static void Handle(bool wifiConnected);
     };
-}
\ No newline at end of file
+}
@@ -111,9 +111,9 @@ namespace ModelController
     //! @return T ConfigItem.GetValue() * value
     //!
     template <typename T>
-    T operator*(T value, ConfigItem<T> item)
+    T operator*(T value, const ConfigItem<T>& item)
     {
-        return item * value;
+        return item.GetValue() * value;
     }
 
 } // namespace ModelController
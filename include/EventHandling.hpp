@@ -9,12 +9,81 @@
 #include <list>
 #include <functional>
 #include <iterator>
+#include <atomic>
 #include "Logger.hpp"
 
 namespace ModelController
 {
+    //!
+    //! @brief Type independent part of events, all events are registered for diagnostics
+    //!
+    class EventBase
+    {
+        private:
+            //!
+            //! @brief First registered event
+            //!
+            static EventBase* first;
+            //!
+            //! @brief Next registered event
+            //!
+            EventBase* next = nullptr;
+            //!
+            //! @brief Previous registered event, nullptr for the first one
+            //!
+            EventBase* previous = nullptr;
+            //!
+            //! @brief Name of the event, nullptr if unnamed
+            //!
+            const char* name = nullptr;
+        protected:
+            //!
+            //! @brief Number of times the event was raised
+            //!
+            std::atomic<uint64_t> raiseCount;
+            //!
+            //! @brief Construct a new unnamed event and register it
+            //!
+            EventBase();
+            //!
+            //! @brief Construct a new named event and register it
+            //!
+            //! @param name Name of the event (needs to stay valid during lifetime of the event)
+            //!
+            EventBase(const char* name);
+            //!
+            //! @brief Destruction of the event, removes it from registered events
+            //!
+            ~EventBase();
+        public:
+            //!
+            //! @brief Get the first registered event
+            //!
+            //! @return EventBase* First event, nullptr if none is registered
+            //!
+            static EventBase* GetFirst();
+            //!
+            //! @brief Get the next registered event
+            //!
+            //! @return EventBase* Next event, nullptr if this is the last one
+            //!
+            EventBase* GetNext() const;
+            //!
+            //! @brief Get the name of the event
+            //!
+            //! @return const char* Name of the event, nullptr if unnamed
+            //!
+            const char* GetName() const;
+            //!
+            //! @brief Get the number of times the event was raised
+            //!
+            //! @return uint64_t Number of raises
+            //!
+            uint64_t GetRaiseCount() const;
+    };
+
     template<typename... T>
-    class Event
+    class Event : public EventBase
     {
         public:
             class Listener
@@ -28,6 +97,10 @@ namespace ModelController
                     //! @brief Callback called on event
                     //!
                     std::function<void(T...)> callback;
+                    //!
+                    //! @brief Callback called, if the event is destroyed before the listener
+                    //!
+                    std::function<void()> onDetached;
                 public:
                     //!
                     //! @brief Construct a new Listener object
@@ -36,21 +109,49 @@ namespace ModelController
                     //!
                     //! @param event Event, on which listeners callback is called
                     //! @param callback Callback called on event
+                    //! @param onDetached Callback called, if the event is destroyed before the listener (listener may be deleted in it)
                     //!
-                    Listener(Event<T...>* event, std::function<void(T...)> callback)
-                        : callback(callback),
-                        event(event)
+                    Listener(Event<T...>* event, std::function<void(T...)> callback, std::function<void()> onDetached = nullptr)
+                        : event(event),
+                        callback(callback),
+                        onDetached(onDetached)
                     {
                         (*event) += this;
                     }
                     //!
                     //! @brief Destruction of the Listener object
                     //!
-                    //! Listener is removed from event's listeners
+                    //! Listener is removed from event's listeners, if the event still exists
                     //!
                     ~Listener()
                     {
-                        (*event) -= this;
+                        if (event != nullptr)
+                        {
+                            (*event) -= this;
+                        }
+                    }
+                    //!
+                    //! @brief Called by the event on its destruction
+                    //!
+                    void Detach()
+                    {
+                        // Callback is moved out, as the listener may be deleted by it
+                        std::function<void()> detached = std::move(onDetached);
+                        event = nullptr;
+                        if (detached)
+                        {
+                            detached();
+                        }
+                    }
+                    //!
+                    //! @brief Check if the event of the listener still exists
+                    //!
+                    //! @return true Event was destroyed
+                    //! @return false Listener is attached to its event
+                    //!
+                    bool IsDetached() const
+                    {
+                        return event == nullptr;
                     }
                     //!
                     //! @brief Fuction called from Event, calls callback
@@ -77,6 +178,26 @@ namespace ModelController
             //!
             Event(){}
             //!
+            //! @brief Construct a new named Event object
+            //!
+            //! @param name Name of the event used for diagnostics
+            //!
+            Event(const char* name)
+                : EventBase(name)
+            {}
+            //!
+            //! @brief Destruction of the Event object, listeners still listening are detached
+            //!
+            ~Event()
+            {
+                while (!listeners.empty())
+                {
+                    Listener* listener = listeners.front();
+                    listeners.pop_front();
+                    listener->Detach();
+                }
+            }
+            //!
             //! @brief Add listener to listeners
             //!
             //! @param listener Listener to be added
@@ -117,12 +238,22 @@ namespace ModelController
                 Logger::trace("Callback removed from event");
             }
             //!
+            //! @brief Get the number of listeners and callbacks
+            //!
+            //! @return size_t Number of listeners and callbacks
+            //!
+            size_t GetListenerCount() const
+            {
+                return listeners.size() + callbacks.size();
+            }
+            //!
             //! @brief Raise event and call each listeners callback
             //!
             //! @param args Parameters to be passed to callback
             //!
             void Raise(T ... args)
             {
+                raiseCount.fetch_add(1, std::memory_order_relaxed);
                 for (typename std::list<Listener*>::reverse_iterator i = listeners.rbegin(); i != listeners.rend(); i++)
                 {
                     (*i)->call(args...);
@@ -10,7 +10,7 @@
 #include "EventHandling.hpp"
 
 namespace ModelController
-{ // ToDo: inform out on deletion and other way round
+{
     class IModuleIn : public BaseModule
     {
         public:
@@ -23,6 +23,10 @@ namespace ModelController
             //!
             static Event<std::string> ModuleInCreated;
             //!
+            //! @brief Event raised, if value of any ModuleIn changed
+            //!
+            static Event<IModuleIn*> ModuleInChanged;
+            //!
             //! @brief Construct a new module in object
             //!
             //! @param name Name of the module
@@ -30,5 +34,24 @@ namespace ModelController
             //! @param dataType DataType of the module
             //!
             IModuleIn(std::string name, BaseModule* parent = nullptr, BaseModule::ModuleDataType dataType = BaseModule::ModuleDataType::eUndefined);
+            //!
+            //! @brief Get actual value of the input as string
+            //!
+            //! @return std::string Actual value
+            //!
+            virtual std::string GetStringValue() const = 0;
+            //!
+            //! @brief Write actual value of the input to json
+            //!
+            //! @param value Json variant the value is written to
+            //!
+            virtual void GetJsonValue(JsonVariant value) const = 0;
+            //!
+            //! @brief Check if the input listens to an output
+            //!
+            //! @return true Input is connected to an output
+            //! @return false No output connected (or connected output was deleted)
+            //!
+            virtual bool IsConnected() const = 0;
     };
 } // namespace ModelController
@@ -8,6 +8,7 @@
 #pragma once
 #include "BaseModule.hpp"
 #include "EventHandling.hpp"
+#include "PayloadCodec.hpp"
 
 namespace ModelController
 {
@@ -23,6 +24,10 @@ namespace ModelController
             //!
             static Event<std::string> ModuleOutCreated;
             //!
+            //! @brief Event raised, if value of any ModuleOut changed
+            //!
+            static Event<IModuleOut*> ModuleOutChanged;
+            //!
             //! @brief Construct a new module out object
             //!
             //! @param name Name of the module
@@ -36,5 +41,51 @@ namespace ModelController
             //! @param value Value to be set
             //!
             virtual void SetStringValue(std::string value) = 0;
+            //!
+            //! @brief Parse value from a character buffer (not null terminated) and set it without allocating
+            //!
+            //! @param value Characters containing the value
+            //! @param length Number of characters
+            //! @return true Value was parsed and set
+            //! @return false Value could not be parsed
+            //!
+            virtual bool SetRawValue(const char* value, size_t length) = 0;
+            //!
+            //! @brief Check if a character buffer can be parsed by SetRawValue without setting it
+            //!
+            //! @param value Characters containing the value
+            //! @param length Number of characters
+            //! @return true Value can be parsed
+            //! @return false Value can't be parsed
+            //!
+            virtual bool IsValidRawValue(const char* value, size_t length) const = 0;
+            //!
+            //! @brief Decode value from a payload and set it
+            //!
+            //! @param encoding Encoding of the payload
+            //! @param value Payload containing the value
+            //! @param length Length of the payload
+            //! @return true Value was decoded and set
+            //! @return false Value could not be decoded
+            //!
+            virtual bool SetEncodedValue(PayloadCodec::Encoding encoding, const char* value, size_t length) = 0;
+            //!
+            //! @brief Get actual value of the output as string
+            //!
+            //! @return std::string Actual value
+            //!
+            virtual std::string GetStringValue() const = 0;
+            //!
+            //! @brief Write actual value of the output to json
+            //!
+            //! @param value Json variant the value is written to
+            //!
+            virtual void GetJsonValue(JsonVariant value) const = 0;
+            //!
+            //! @brief Get the number of inputs (and other listeners) listening to the output
+            //!
+            //! @return size_t Number of listeners
+            //!
+            virtual size_t GetListenerCount() const = 0;
     };
 } // namespace ModelController
@@ -9,6 +9,10 @@
 
 #include "EventHandling.hpp"
 #include "Arduino.h"
+#include "Clock.hpp"
+#include <deque>
+#include <mutex>
+#include <optional>
 
 namespace ModelController
 {
@@ -19,13 +23,25 @@ namespace ModelController
             {
                 private:
                     //!
-                    //! @brief Minimum timeout between two calls in seconds
+                    //! @brief Minimum timeout between two calls in microseconds
                     //!
-                    double timeout = 0;
+                    uint64_t timeout = 0;
                     //!
-                    //! @brief Time of the last call in seconds
+                    //! @brief Time in microseconds (Clock) of the last call, empty if never called
                     //!
-                    double lastCall = 0;
+                    std::optional<uint64_t> lastCall;
+                    //!
+                    //! @brief True if the callback isn't called until wake time (or Wake())
+                    //!
+                    bool sleeping = false;
+                    //!
+                    //! @brief True if sleeping until Wake() is called
+                    //!
+                    bool suspended = false;
+                    //!
+                    //! @brief Time in microseconds (Clock) the listener wakes up
+                    //!
+                    uint64_t wakeTime = 0;
                     //!
                     //! @brief Callback called periodically
                     //!
@@ -35,11 +51,15 @@ namespace ModelController
                     //!
                     void call()
                     {
-                        // Check if callback needs to be called (time since last call is higher oder equal timeout)
-                        if (lastCall == 0 || (millis() / 1000.0) - lastCall >= timeout)
+                        uint64_t now = Clock::Now();
+                        bool awake = !sleeping || (!suspended && now >= wakeTime);
+                        // Check if callback needs to be called (time since last call is higher oder equal timeout), Clock doesn't wrap like millis()
+                        if (awake && (!lastCall || now - *lastCall >= timeout))
                         {
+                            // Reset before calling, as the callback may sleep again
+                            sleeping = false;
                             callback();
-                            lastCall = millis() / 1000.0;
+                            lastCall = Clock::Now();
                         }
                     }
 
@@ -48,13 +68,40 @@ namespace ModelController
                     //! @brief Construct a new Loop Listener object
                     //!
                     //! @param callback Callback called periodically
-                    //! @param timeout Minimum timeout between two calls in secondsMinimum timeout between two calls in seconds
+                    //! @param timeout Minimum timeout between two calls in seconds
                     //!
                     LoopListener(std::function<void()> callback,  double timeout = 0)
                         : Listener(&loopEvent, [&](){ this->call(); }),
-                        timeout(timeout),
+                        timeout(static_cast<uint64_t>(timeout * 1000000)),
                         callback(callback)
                     { }
+                    //!
+                    //! @brief Skip calls until time is reached
+                    //!
+                    //! @param time Time in microseconds (Clock::Now()) of the next call
+                    //!
+                    void Sleep(uint64_t time)
+                    {
+                        sleeping = true;
+                        suspended = false;
+                        wakeTime = time;
+                    }
+                    //!
+                    //! @brief Skip calls until Wake() is called
+                    //!
+                    void Sleep()
+                    {
+                        sleeping = true;
+                        suspended = true;
+                    }
+                    //!
+                    //! @brief Call callback again on next loop
+                    //!
+                    void Wake()
+                    {
+                        sleeping = false;
+                        suspended = false;
+                    }
             };
         private:
             //!
@@ -62,16 +109,59 @@ namespace ModelController
             //!
             static Event<> loopEvent;
             //!
+            //! @brief Work items posted from other tasks, executed on next loop
+            //!
+            static std::deque<std::function<void()>> workItems;
+            //!
+            //! @brief Mutex protecting the work items
+            //!
+            static std::mutex workItemsMutex;
+            //!
+            //! @brief Mutex held while the loop is running
+            //!
+            static std::mutex loopMutex;
+            //!
+            //! @brief Time the last loop was started in microseconds
+            //!
+            static unsigned long lastRaise;
+            //!
+            //! @brief Function observing the period between two loops in microseconds, nullptr if not observed
+            //!
+            static void (*periodObserver)(uint32_t period);
+            //!
             //! @brief Empty ctor (pure static class)
             //!
             LoopEvent();
         public:
             //!
-            //! @brief Raise loop event (needs to be called by 'loop()')
+            //! @brief Execute posted work items and raise loop event (needs to be called by 'loop()')
             //!
-            static void Raise()
-            {
-                loopEvent.Raise();
-            }
+            static void Raise();
+            //!
+            //! @brief Post work item to be executed by the loop (may be called from other tasks)
+            //!
+            //! @param workItem Function called on next loop
+            //!
+            static void Post(std::function<void()> workItem);
+            //!
+            //! @brief Get the mutex held while the loop is running
+            //!
+            //! Lock it to access modules from other tasks without racing with the loop
+            //!
+            //! @return std::mutex& Mutex of the loop
+            //!
+            static std::mutex& GetMutex();
+            //!
+            //! @brief Set the function observing the period between two loops (e.g. the loop period histogram of the metrics)
+            //!
+            //! @param observer Function called with the period in microseconds on each loop, nullptr to stop observing
+            //!
+            static void SetPeriodObserver(void (*observer)(uint32_t period));
+            //!
+            //! @brief Get the number of loop listeners
+            //!
+            //! @return size_t Number of listeners
+            //!
+            static size_t GetListenerCount();
     };
 } // namespace ModelController
@@ -10,8 +10,16 @@
 #include "PubSubClient.h"
 #include "BaseContainer.hpp"
 #include "WiFi.h"
+#include <unordered_map>
+#include <array>
 #include <map>
+#include <vector>
+#include <type_traits>
+#include <atomic>
+#include <memory>
 #include "IModuleOut.hpp"
+#include "ModuleIn.hpp"
+#include "PayloadCodec.hpp"
 #include "LoopEvent.hpp"
 #include "ConfigItem.hpp"
 
@@ -25,9 +33,91 @@ namespace ModelController
             //!
             LoopEvent::LoopListener loopListener;
             //!
-            //! @brief List of input variables (output of the mqtt client)
+            //! @brief Input variable (output of the mqtt client) with its full topic
             //!
-            std::map<std::string, IModuleOut*> mqttInputVariables;
+            struct InputVariable
+            {
+                //!
+                //! @brief Full topic of the variable
+                //!
+                std::string topic;
+                //!
+                //! @brief Variable set on received message
+                //!
+                IModuleOut* variable;
+                //!
+                //! @brief Encoding of the payloads
+                //!
+                PayloadCodec::Encoding encoding;
+            };
+            //!
+            //! @brief Input variables by hash of their topic
+            //!
+            std::unordered_multimap<uint32_t, InputVariable> mqttInputVariables;
+            //!
+            //! @brief Add input variable to the topic table (replaces variable with same topic)
+            //!
+            //! @param topic Full topic of the variable
+            //! @param variable Variable set on received message
+            //!
+            void AddInputVariable(std::string topic, IModuleOut* variable);
+            //!
+            //! @brief Remove input variable from the topic table and unsubscribe from its topic
+            //!
+            //! @param variable Variable to remove
+            //!
+            void RemoveInputVariable(IModuleOut* variable);
+            //!
+            //! @brief Find input variable of a topic without allocating
+            //!
+            //! @param topic Topic of the message (or part of the topic after prefix)
+            //! @param length Length of the topic
+            //! @param prefix Prefix of the topic (e.g. "/<edgeName>/" for keys of batch messages)
+            //! @param prefixLength Length of the prefix
+            //! @return InputVariable* Entry of the topic, nullptr if none
+            //!
+            InputVariable* FindInputVariable(const char* topic, size_t length, const char* prefix = "", size_t prefixLength = 0);
+            //!
+            //! @brief Number of slots for hashes of unexposed topics
+            //!
+            static constexpr size_t maxUnexposedTopics = 256;
+            //!
+            //! @brief Hashes of topics, which matched no port with lazy exposure (e.g. echoes of own publishes)
+            //!
+            //! Direct mapped by hash (0 marks an empty slot), a colliding topic replaces the older one, so memory stays fixed
+            //!
+            std::array<uint32_t, maxUnexposedTopics> unexposedTopics = {};
+            //!
+            //! @brief Expose the port addressed by the topic, if its exposure is lazy
+            //!
+            //! Needs wildcard subscription, as topics of lazy ports aren't subscribed.
+            //!
+            //! @param topic Topic of the message ("/<edgeName><path of the port>")
+            //! @param length Length of the topic
+            //! @return InputVariable* Entry of the topic, if it was created for an input, else nullptr
+            //!
+            InputVariable* ExposeLazyPort(const char* topic, size_t length);
+            //!
+            //! @brief Encoding of payloads for data types without own encoding
+            //!
+            PayloadCodec::Encoding defaultEncoding = PayloadCodec::Encoding::eText;
+            //!
+            //! @brief Encoding of payloads by data type (from config object "encoding")
+            //!
+            std::map<ModuleDataType, PayloadCodec::Encoding> encodings;
+            //!
+            //! @brief Read encodings from config ("encoding" is a name or an object with "default" and data type names as keys)
+            //!
+            //! @param config Config of the client
+            //!
+            void SetEncodings(JsonObject config);
+            //!
+            //! @brief Get encoding of single value payloads of a data type (text for batch messages)
+            //!
+            //! @param dataType Data type of the value
+            //! @return PayloadCodec::Encoding Encoding of the payloads
+            //!
+            PayloadCodec::Encoding GetEncoding(ModuleDataType dataType);
             //!
             //! @brief Hostname of the MQTT broker
             //!
@@ -41,13 +131,398 @@ namespace ModelController
             //!
             ConfigItem<std::string> clientID;
             //!
-            //! @brief PubSubClient to handle MQTT messages
+            //! @brief True if a single wildcard subscription to /<edgeName>/<wildcardFilter> is used instead of one subscription per variable (opt-in)
+            //!
+            //! Outputs are published (retained) below the edge name too, so a wildcard covering them makes the broker echo every publish
+            //! back to the client, costing bandwidth and a topic lookup per publish.
+            //!
+            ConfigItem<bool> wildcardSubscription;
+            //!
+            //! @brief Filter of the wildcard subscription relative to the edge name, e.g. "in/#" to subscribe only to inputs below "in/" without echoes
+            //!
+            ConfigItem<std::string> wildcardFilter;
+            //!
+            //! @brief Full topics waiting to be subscribed
+            //!
+            std::vector<std::string> pendingSubscriptions;
+            //!
+            //! @brief Packet identifier of the next SUBSCRIBE packet
+            //!
+            uint16_t subscribePacketId = 1;
+            //!
+            //! @brief Maximum size of a SUBSCRIBE packet containing several topics
+            //!
+            static constexpr size_t maxSubscribePacketSize = 1024;
+            //!
+            //! @brief Mode of publishing values
+            //!
+            enum class PublishMode
+            {
+                eOnChange,  //!< Publish only changed values
+                ePeriodic,  //!< Publish latest value every interval, even if unchanged
+            };
+            //!
+            //! @brief Policy for publishing values of a topic
+            //!
+            struct PublishPolicy
+            {
+                //!
+                //! @brief Minimum time between two publishes in milliseconds
+                //!
+                unsigned long interval;
+                //!
+                //! @brief Minimum difference to last published value (numeric values only)
+                //!
+                double deadband;
+                //!
+                //! @brief Mode of publishing
+                //!
+                PublishMode mode;
+            };
+            //!
+            //! @brief Output variable (input of the mqtt client) with its latest value
+            //!
+            struct Publisher
+            {
+                //!
+                //! @brief Topic relative to edge name
+                //!
+                std::string topic;
+                //!
+                //! @brief Policy of the topic
+                //!
+                PublishPolicy policy;
+                //!
+                //! @brief Latest value
+                //!
+                std::string value;
+                //!
+                //! @brief Latest value as number (if numeric)
+                //!
+                double number = 0;
+                //!
+                //! @brief True if value is numeric and the deadband can be applied
+                //!
+                bool numeric = false;
+                //!
+                //! @brief Last published value as number
+                //!
+                double publishedNumber = 0;
+                //!
+                //! @brief True if a value was published already
+                //!
+                bool published = false;
+                //!
+                //! @brief True if latest value is not published yet
+                //!
+                bool pending = false;
+                //!
+                //! @brief Time of the last publish
+                //!
+                unsigned long lastPublish = 0;
+                //!
+                //! @brief True if publisher is in the outbound queue (backlog while disconnected)
+                //!
+                bool queued = false;
+                //!
+                //! @brief True if publisher is in the schedule (waiting for its interval or periodic)
+                //!
+                bool scheduled = false;
+                //!
+                //! @brief True if latest value was moved to the spill file
+                //!
+                bool spilled = false;
+                //!
+                //! @brief True if the input of the publisher was deleted (publisher is erased, when it left the queue)
+                //!
+                bool orphaned = false;
+            };
+            //!
+            //! @brief Minimum time between two publishes of a topic in milliseconds (if not set for topic)
+            //!
+            ConfigItem<uint32_t> publishInterval;
+            //!
+            //! @brief Minimum difference to last published value (if not set for topic)
+            //!
+            ConfigItem<double> publishDeadband;
+            //!
+            //! @brief Mode of publishing ("change" or "periodic", if not set for topic)
+            //!
+            ConfigItem<std::string> publishMode;
+            //!
+            //! @brief Publish policies by topic (from config object "policies")
+            //!
+            std::map<std::string, PublishPolicy> publishPolicies;
+            //!
+            //! @brief Output variables by topic (relative to edge name)
+            //!
+            std::map<std::string, Publisher> publishers;
+            //!
+            //! @brief Maximum number of topics queued while disconnected, oldest values are dropped (or spilled)
+            //!
+            ConfigItem<uint16_t> queueSize;
+            //!
+            //! @brief True if dropped values are written to a file on LittleFS and published later
+            //!
+            ConfigItem<bool> spillToFile;
+            //!
+            //! @brief Maximum publishes per second while draining the queue after reconnect (0 for unlimited)
+            //!
+            ConfigItem<uint16_t> drainRate;
+            //!
+            //! @brief Ring buffer with publishers, whose values changed while disconnected
+            //!
+            std::vector<Publisher*> queue;
+            //!
+            //! @brief Index of the oldest publisher in the queue
+            //!
+            size_t queueHead = 0;
+            //!
+            //! @brief Number of publishers in the queue
+            //!
+            size_t queueCount = 0;
+            //!
+            //! @brief Publishers waiting for their interval and periodic publishers (at most one entry per publisher, never evicted)
+            //!
+            std::vector<Publisher*> schedule;
+            //!
+            //! @brief True while the queue is drained after reconnect
+            //!
+            bool draining = false;
+            //!
+            //! @brief Publishes available while draining
+            //!
+            double drainTokens = 0;
+            //!
+            //! @brief Time the drain tokens were refilled
+            //!
+            unsigned long lastRefill = 0;
+            //!
+            //! @brief True if the spill file may contain values
+            //!
+            bool spillPending = false;
+            //!
+            //! @brief Path of the spill file
+            //!
+            std::string spillFile;
+            //!
+            //! @brief Maximum size of the spill file in bytes
+            //!
+            static constexpr size_t maxSpillSize = 16384;
+            //!
+            //! @brief Topic (relative to edge name) for batch messages, empty if each value is published to its own topic
+            //!
+            ConfigItem<std::string> batchTopic;
+            //!
+            //! @brief Format of batch messages ("json" or "msgpack")
+            //!
+            ConfigItem<std::string> batchFormat;
+            //!
+            //! @brief Maximum size of a batch message in bytes
+            //!
+            ConfigItem<uint16_t> batchSize;
+            //!
+            //! @brief Full topic of inbound batch messages ("/<edgeName>/<batchTopic>/set")
+            //!
+            std::string batchSetTopic;
+            //!
+            //! @brief Values of the actual outbound batch message by relative path
+            //!
+            JsonDocument batch;
+            //!
+            //! @brief Publishers, whose values are in the actual batch message
+            //!
+            std::vector<Publisher*> batchPublishers;
+            //!
+            //! @brief Serialized size of the members of the actual batch in bytes (without the map around them)
+            //!
+            size_t batchMembersSize = 0;
+            //!
+            //! @brief Check if batch messages are used
+            //!
+            //! @return true Values are published in batch messages
+            //! @return false Each value is published to its own topic
+            //!
+            bool IsBatched();
+            //!
+            //! @brief Serialize batch in the configured format
+            //!
+            //! @param payload String the batch is written to
             //!
-            PubSubClient client;
+            void SerializeBatch(std::string& payload);
             //!
-            //! @brief WiFiClient needed for PubSubClient
+            //! @brief Add value of a publisher to the batch, publish the batch if it exceeds batchSize
             //!
-            WiFiClient wifiClient;
+            //! @param publisher Publisher, whose value is added
+            //! @return true Value was added
+            //! @return false Full batch could not be published
+            //!
+            bool AddToBatch(Publisher& publisher);
+            //!
+            //! @brief Publish the batch (values are committed on success and scheduled again on failure)
+            //!
+            //! @return true Batch was published or is empty
+            //! @return false Batch could not be published
+            //!
+            bool FlushBatch();
+            //!
+            //! @brief Set input variables from a batch message
+            //!
+            //! @param message Payload of the message
+            //! @param length Length of the message
+            //!
+            void OnBatchMessage(const char* message, size_t length);
+            //!
+            //! @brief Add publisher to the end of the queue, drop the oldest if the queue is full
+            //!
+            //! @param publisher Publisher to add
+            //!
+            void Push(Publisher& publisher);
+            //!
+            //! @brief Remove oldest publisher from the queue
+            //!
+            //! @return Publisher* Removed publisher
+            //!
+            Publisher* Pop();
+            //!
+            //! @brief Drop value of a publisher removed from the full queue (spill to file, if enabled)
+            //!
+            //! @param publisher Publisher, whose value is dropped
+            //!
+            void Drop(Publisher& publisher);
+            //!
+            //! @brief Add publisher to the schedule, if it isn't queued or scheduled already
+            //!
+            //! @param publisher Publisher to add
+            //!
+            void Schedule(Publisher& publisher);
+            //!
+            //! @brief Append value of a publisher to the spill file
+            //!
+            //! @param publisher Publisher, whose value is spilled
+            //! @return true Value was written
+            //! @return false Spill file could not be written or is full
+            //!
+            bool Spill(Publisher& publisher);
+            //!
+            //! @brief Move values from the spill file back to the queue (latest value per topic, values of deleted inputs are dropped)
+            //!
+            void LoadSpill();
+            //!
+            //! @brief Parse publish mode from config
+            //!
+            //! @param mode "change" or "periodic"
+            //! @return PublishMode Parsed mode, eOnChange if unknown
+            //!
+            static PublishMode ToPublishMode(std::string mode);
+            //!
+            //! @brief Get the publisher of a topic, created with the policy of the topic
+            //!
+            //! @param topic Topic relative to edge name
+            //! @return Publisher& Publisher of the topic
+            //!
+            Publisher& GetPublisher(std::string topic);
+            //!
+            //! @brief Store latest value of a publisher, published with the next flush
+            //!
+            //! @param publisher Publisher of the value
+            //! @param value Value as string
+            //! @param number Value as number (if numeric)
+            //! @param numeric True if value is numeric
+            //!
+            void Enqueue(Publisher& publisher, std::string value, double number, bool numeric);
+            //!
+            //! @brief Mark the value of a publisher as published
+            //!
+            //! @param publisher Publisher, whose value was published
+            //! @param now Time of the publish in milliseconds
+            //!
+            void Commit(Publisher& publisher, unsigned long now);
+            //!
+            //! @brief Publish the value of a publisher, if its interval elapsed and it's outside of the deadband
+            //!
+            //! @param publisher Publisher to publish
+            //! @param now Actual time in milliseconds
+            //! @param failed Set to true, if publishing failed
+            //! @return true Publisher needs to stay scheduled (value is pending or publisher is periodic)
+            //! @return false Publisher can leave the schedule
+            //!
+            bool Publish(Publisher& publisher, unsigned long now, bool& failed);
+            //!
+            //! @brief Publish pending values according to the policies of their topics
+            //!
+            void FlushPublishers();
+            //!
+            //! @brief Create input, whose changes are published
+            //!
+            //! @tparam T Data type of the input
+            //! @param modulePath Path of the input relative to the client
+            //! @return BaseModule* Created input
+            //!
+            template<typename T>
+            BaseModule* CreatePublisher(std::string modulePath)
+            {
+                Publisher* publisher = &GetPublisher("/" + modulePath);
+                PayloadCodec::Encoding encoding = GetEncoding(GetDataTypeById(typeid(T)));
+                return new ModuleIn<T>(modulePath, "none", [this, publisher, encoding](T value)
+                {
+                    std::string payload;
+                    PayloadCodec::Encode(encoding, value, payload);
+                    if constexpr (std::is_arithmetic<T>::value)
+                    {
+                        this->Enqueue(*publisher, std::move(payload), static_cast<double>(value), true);
+                    }
+                    else
+                    {
+                        this->Enqueue(*publisher, std::move(payload), 0, false);
+                    }
+                }, this);
+            }
+            //!
+            //! @brief Connection to the broker, shared with the connect task (which may outlive the client)
+            //!
+            struct Connection
+            {
+                //!
+                //! @brief WiFiClient needed for PubSubClient
+                //!
+                WiFiClient wifiClient;
+                //!
+                //! @brief PubSubClient to handle MQTT messages
+                //!
+                PubSubClient client;
+                //!
+                //! @brief Hostname of the broker, kept as PubSubClient only stores the pointer
+                //!
+                std::string hostname;
+                //!
+                //! @brief ClientID used by the connect task
+                //!
+                std::string clientID;
+                //!
+                //! @brief Set by the connect task, when the connection attempt finished
+                //!
+                std::atomic<bool> finished;
+                //!
+                //! @brief Result of the connection attempt (valid after finished is set)
+                //!
+                bool succeeded = false;
+                //!
+                //! @brief Construct a new Connection object
+                //!
+                Connection()
+                    : client(wifiClient),
+                    finished(true)
+                { }
+            };
+            //!
+            //! @brief Connection to the broker, freed by its last owner (client or connect task)
+            //!
+            std::shared_ptr<Connection> connection;
+            //!
+            //! @brief PubSubClient of the connection
+            //!
+            PubSubClient& client;
             //!
             //! @brief Callback on sent subscribed topic
             //!
@@ -61,17 +536,95 @@ namespace ModelController
             //!
             Event<>::Listener OnSTAConnected;
             //!
-            //! @brief Reconnect to MQTT broker
+            //! @brief State of the connection to the broker
+            //!
+            enum class ConnectionState
+            {
+                eDisconnected,  //!< Not connected, waiting for next attempt
+                eConnecting,    //!< Connect task is running
+                eConnected,     //!< Connected to broker
+            };
+            //!
+            //! @brief Actual state of the connection (only changed by the loop)
+            //!
+            ConnectionState state = ConnectionState::eDisconnected;
+            //!
+            //! @brief Minimum delay between two connection attempts in milliseconds
+            //!
+            ConfigItem<uint32_t> backoffMin;
+            //!
+            //! @brief Maximum delay between two connection attempts in milliseconds
+            //!
+            ConfigItem<uint32_t> backoffMax;
+            //!
+            //! @brief Actual delay between connection attempts, doubled on each failure (0 after success)
+            //!
+            unsigned long backoff = 0;
+            //!
+            //! @brief Time of the next connection attempt
+            //!
+            unsigned long nextAttempt = 0;
+            //!
+            //! @brief Time the actual connection attempt started (micros)
+            //!
+            unsigned long connectStart = 0;
+            //!
+            //! @brief Start connection attempt in a separate task
+            //!
+            void StartConnect();
+            //!
+            //! @brief Task connecting to the broker, blocking calls of PubSubClient don't block the loop
+            //!
+            //! @param parameter Heap allocated std::shared_ptr<Connection> owned by the task
+            //!
+            static void ConnectTask(void* parameter);
             //!
-            void reconnect();
+            //! @brief Schedule next connection attempt with jittered exponential backoff
             //!
-            //! @brief Subscribe to topic
+            void ScheduleReconnect();
             //!
-            //! @param topic Topic to subscribe to
-            //! @return true Success
-            //! @return false Failure
+            //! @brief Subscribe to input topics and start draining the queue after connection was established
             //!
-            bool subscribe(std::string topic);
+            void OnConnected();
+            //!
+            //! @brief Queue subscription to topic (sent with the next SUBSCRIBE packet)
+            //!
+            //! @param topic Topic to subscribe to (relative to edge name)
+            //!
+            void subscribe(std::string topic);
+            //!
+            //! @brief Remove topic from pending subscriptions or unsubscribe from it
+            //!
+            //! @param topic Full topic
+            //!
+            void unsubscribe(std::string topic);
+            //!
+            //! @brief Listener called, if any module was deleted
+            //!
+            Event<BaseModule*>::Listener OnModuleDeleted;
+            //!
+            //! @brief Listener called, if the config changed (new modules may have lazy ports)
+            //!
+            Event<std::string>::Listener OnConfigChanged;
+            //!
+            //! @brief True if inputs and outputs of the client need to be checked for orphans
+            //!
+            bool collectGarbage = false;
+            //!
+            //! @brief Delete outputs without listeners and inputs without connected output, erase their topics and publishers
+            //!
+            void CollectGarbage();
+            //!
+            //! @brief Send queued subscriptions, as many topics as fit in one SUBSCRIBE packet
+            //!
+            //! @return true All subscriptions were sent
+            //! @return false Client is not connected or sending failed
+            //!
+            bool FlushSubscriptions();
+            //!
+            //! @brief Periodic task driving the connection, handling incoming messages, queued subscriptions and pending publishes
+            //!
+            void Loop();
         protected:
             //!
             //! @brief Get child of the object
@@ -97,6 +650,10 @@ namespace ModelController
             //!
             MQTTClient(std::string name, JsonObject config, BaseModule* parent = nullptr);
             //!
+            //! @brief Destruction of the MQTTClient object
+            //!
+            virtual ~MQTTClient();
+            //!
             //! @brief Publish topic to mqtt broker
             //!
             //! @param topic Topic to be published
@@ -0,0 +1,249 @@
+//!
+//! @file Metrics.hpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Counters and histograms of the runtime, exported in Prometheus text format
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+namespace ModelController
+{
+    class Metrics
+    {
+        public:
+            //!
+            //! @brief Monotonic counter (64 bit, doesn't wrap in practice)
+            //!
+            class Counter
+            {
+                private:
+                    //!
+                    //! @brief Actual value of the counter
+                    //!
+                    std::atomic<uint64_t> value;
+                public:
+                    //!
+                    //! @brief Construct a new Counter object
+                    //!
+                    Counter();
+                    //!
+                    //! @brief Increment the counter
+                    //!
+                    //! @param increment Value added to the counter
+                    //!
+                    void Increment(uint32_t increment = 1);
+                    //!
+                    //! @brief Get the value of the counter
+                    //!
+                    //! @return uint64_t Actual value
+                    //!
+                    uint64_t Get() const;
+            };
+            //!
+            //! @brief Value, which can go up and down
+            //!
+            class Gauge
+            {
+                private:
+                    //!
+                    //! @brief Actual value of the gauge
+                    //!
+                    std::atomic<uint32_t> value;
+                public:
+                    //!
+                    //! @brief Construct a new Gauge object
+                    //!
+                    Gauge();
+                    //!
+                    //! @brief Set the value of the gauge
+                    //!
+                    //! @param value New value
+                    //!
+                    void Set(uint32_t value);
+                    //!
+                    //! @brief Add to the value of the gauge
+                    //!
+                    //! @param delta Value added (negative to subtract)
+                    //!
+                    void Add(int32_t delta);
+                    //!
+                    //! @brief Get the value of the gauge
+                    //!
+                    //! @return uint32_t Actual value
+                    //!
+                    uint32_t Get() const;
+            };
+            //!
+            //! @brief Histogram of durations in microseconds with fixed buckets, exported in seconds
+            //!
+            class Histogram
+            {
+                private:
+                    //!
+                    //! @brief Number of buckets (without +Inf)
+                    //!
+                    static constexpr size_t numberBuckets = 10;
+                    //!
+                    //! @brief Upper bounds of the buckets in microseconds
+                    //!
+                    static constexpr uint32_t bounds[numberBuckets] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000, 1000000};
+                    //!
+                    //! @brief Number of observations per bucket (not cumulative, last one is +Inf)
+                    //!
+                    std::atomic<uint64_t> buckets[numberBuckets + 1];
+                    //!
+                    //! @brief Sum of observed values in microseconds (64 bit, a sum of 32 bit would wrap after 71 minutes of loop periods)
+                    //!
+                    std::atomic<uint64_t> sum;
+                    //!
+                    //! @brief Number of observations
+                    //!
+                    std::atomic<uint64_t> count;
+                public:
+                    //!
+                    //! @brief Construct a new Histogram object
+                    //!
+                    Histogram();
+                    //!
+                    //! @brief Add an observation
+                    //!
+                    //! @param value Observed duration in microseconds
+                    //!
+                    void Observe(uint32_t value);
+                    //!
+                    //! @brief Serialize histogram in Prometheus text format (bounds and sum in seconds)
+                    //!
+                    //! @param name Name of the metric (with unit seconds)
+                    //! @param help Description of the metric
+                    //! @return std::string Serialized histogram
+                    //!
+                    std::string Serialize(std::string name, std::string help) const;
+            };
+            //!
+            //! @brief Period between two loops
+            //!
+            static Histogram loopPeriod;
+            //!
+            //! @brief Number of MQTT messages published successfully
+            //!
+            static Counter mqttPublished;
+            //!
+            //! @brief Number of MQTT messages, which could not be published
+            //!
+            static Counter mqttPublishFailed;
+            //!
+            //! @brief Duration of publishing a MQTT message
+            //!
+            static Histogram mqttPublishLatency;
+            //!
+            //! @brief Number of values replaced by a newer value before they were published
+            //!
+            static Counter mqttPublishCoalesced;
+            //!
+            //! @brief Number of values not published, because they were inside the deadband
+            //!
+            static Counter mqttPublishSuppressed;
+            //!
+            //! @brief Number of topics waiting in the outbound queues
+            //!
+            static Gauge mqttQueueDepth;
+            //!
+            //! @brief Number of values dropped, because the outbound queue was full
+            //!
+            static Counter mqttQueueDropped;
+            //!
+            //! @brief Number of values moved from the full outbound queue to the spill file
+            //!
+            static Counter mqttQueueSpilled;
+            //!
+            //! @brief Number of MQTT messages received
+            //!
+            static Counter mqttReceived;
+            //!
+            //! @brief Duration of handling a received MQTT message
+            //!
+            static Histogram mqttReceiveLatency;
+            //!
+            //! @brief Number of connection attempts to MQTT brokers
+            //!
+            static Counter mqttConnectAttempts;
+            //!
+            //! @brief Number of failed connection attempts to MQTT brokers
+            //!
+            static Counter mqttConnectFailed;
+            //!
+            //! @brief Duration of connection attempts to MQTT brokers
+            //!
+            static Histogram mqttConnectLatency;
+            //!
+            //! @brief Time from the last connection attempt until all subscriptions were sent in milliseconds
+            //!
+            static Gauge mqttReadyTime;
+            //!
+            //! @brief Time from starting or losing the WiFi connection until the station got an IP in milliseconds
+            //!
+            static Gauge wifiConnectTime;
+            //!
+            //! @brief Number of times the WiFi station lost the connection
+            //!
+            static Counter wifiDisconnects;
+            //!
+            //! @brief Number of WiFi connection attempts (fast and with scan)
+            //!
+            static Counter wifiConnectAttempts;
+            //!
+            //! @brief Number of attempts to the cached access point, which timed out
+            //!
+            static Counter wifiFastConnectFailed;
+            //!
+            //! @brief Duration of the last successful WiFi connection attempt in milliseconds
+            //!
+            static Gauge wifiAttemptTime;
+            //!
+            //! @brief Number of times a sequence processor calculated its output
+            //!
+            static Counter sequenceEvaluations;
+            //!
+            //! @brief Number of times the config was saved
+            //!
+            static Counter configSaves;
+            //!
+            //! @brief Duration of saving the config
+            //!
+            static Histogram configSaveDuration;
+            //!
+            //! @brief Serialize all metrics in Prometheus text format
+            //!
+            //! Walks the module tree, so it needs to be called from the loop or with the loop mutex locked
+            //!
+            //! @return std::string Serialized metrics
+            //!
+            static std::string Serialize();
+        private:
+            //!
+            //! @brief Delete ctor for pure static class
+            //!
+            Metrics() = delete;
+            //!
+            //! @brief Serialize a single value in Prometheus text format
+            //!
+            //! @param name Name of the metric
+            //! @param help Description of the metric
+            //! @param type Type of the metric (counter or gauge)
+            //! @param value Value of the metric
+            //! @return std::string Serialized value
+            //!
+            static std::string Serialize(std::string name, std::string help, std::string type, uint64_t value);
+            //!
+            //! @brief Convert microseconds to seconds without rounding
+            //!
+            //! @param microseconds Time in microseconds
+            //! @return std::string Time in seconds (e.g. "0.0025")
+            //!
+            static std::string ToSeconds(uint64_t microseconds);
+    };
+} // namespace ModelController
@@ -23,7 +23,7 @@ namespace ModelController
             //!
             //! @brief Actual value of the input
             //!
-            T actualValue;  // ToDo: initialize type dependent
+            T actualValue = T();
             //!
             //! @brief Listener called, if value of connected output changed
             //!
@@ -32,6 +32,19 @@ namespace ModelController
             //! @brief Listener called, if new output module was created
             //!
             Event<std::string>::Listener* OnModuleOutCreated = nullptr;
+            //!
+            //! @brief Exposure of the input to the API (only used for inputs without source)
+            //!
+            ApiExposure apiExposure = ApiExposure::eNone;
+            //!
+            //! @brief Connect to the API variable, which is set by the API
+            //!
+            void ConnectApi()
+            {
+                pathConnectedModuleOut = apiPath + GetPath();
+                Logger::trace("Creating connection to default connector for " + this->GetPath());
+                OnOutputCreated(pathConnectedModuleOut);
+            }
 
         protected:
             //!
@@ -92,6 +105,20 @@ namespace ModelController
                 }
             }
             //!
+            //! @brief Callback called, if connected output was deleted, to wait for it to be created again
+            //!
+            void OnOutputDeleted()
+            {
+                Logger::trace("ModuleIn::OnOutputDeleted() - Module: " + this->GetPath());
+                delete OnOutputChanged;
+                OnOutputChanged = nullptr;
+                //! Inputs without path are connected by the output (SetOutputChangedEvent) again
+                if (!pathConnectedModuleOut.empty() && pathConnectedModuleOut != "none" && OnModuleOutCreated == nullptr)
+                {
+                    OnModuleOutCreated = new Event<std::string>::Listener(&IModuleOut::ModuleOutCreated, [&](std::string path){ this->OnOutputCreated(path); } );
+                }
+            }
+            //!
             //! @brief Get the Path Connected Module Out object out of the config
             //!
             //! @param name Name of the actual object (ModuleIn)
@@ -149,9 +176,21 @@ namespace ModelController
                 }
                 if (this->pathConnectedModuleOut.empty() && !Utils::StartsWith(GetPath(), apiPath))
                 {
-                    this->pathConnectedModuleOut = apiPath + GetPath();
-                    Logger::trace("Creating connection to default connector for " + this->GetPath());
-                    this->OnOutputCreated(this->pathConnectedModuleOut);
+                    apiExposure = GetApiExposure();
+                    if (apiExposure == ApiExposure::eReadWrite)
+                    {
+                        ConnectApi();
+                    }
+                    else if (apiExposure == ApiExposure::eReadOnly)
+                    {
+                        // Only publish the value, the input keeps its default value
+                        Logger::trace("Creating read-only connection to default connector for " + this->GetPath());
+                        ModuleIn<T>* connectedAPIVariable = ModuleIn<T>::GetModuleInput(apiPath + this->GetPath());
+                        if (connectedAPIVariable != nullptr)
+                        {
+                            connectedAPIVariable->SetOutputChangedEvent(&(this->ValueChangedEvent));
+                        }
+                    }
                 }
             }
             //!
@@ -200,7 +239,7 @@ namespace ModelController
                 //! Prevent, that OnOuputChanged is set by output, while object is waiting for creation of connected output
                 if (OnOutputChanged == nullptr && OnModuleOutCreated == nullptr)
                 {
-                    OnOutputChanged = new typename Event<T>::Listener(event, [&](T value){ this->SetValue(value); } );
+                    OnOutputChanged = new typename Event<T>::Listener(event, [&](T value){ this->SetValue(value); }, [&](){ this->OnOutputDeleted(); } );
                     retVal = true;
                     Logger::trace("OnOutputChanged set");
                 }
@@ -217,6 +256,7 @@ namespace ModelController
                 {
                     actualValue = value;
                     ValueChangedEvent(GetValue());
+                    ModuleInChanged(this);
                 }
             }
             //!
@@ -229,6 +269,50 @@ namespace ModelController
                 return actualValue;
             }
             //!
+            //! @brief Get the actual value converted to string
+            //!
+            //! @return std::string Actual value
+            //!
+            virtual std::string GetStringValue() const override
+            {
+                return Utils::ToString(GetValue());
+            }
+            //!
+            //! @brief Write the actual value to json
+            //!
+            //! @param value Json variant the value is written to
+            //!
+            virtual void GetJsonValue(JsonVariant value) const override
+            {
+                value.set(GetValue());
+            }
+            //!
+            //! @brief Check if the input listens to an output
+            //!
+            //! @return true Input is connected to an output
+            //! @return false No output connected (or connected output was deleted)
+            //!
+            virtual bool IsConnected() const override
+            {
+                return OnOutputChanged != nullptr;
+            }
+            //!
+            //! @brief Connect to the API variable, if the input is lazy and not connected yet
+            //!
+            //! @return true Input was connected to the API by this call
+            //! @return false Input isn't lazy, already connected or API isn't available
+            //!
+            virtual bool Expose() override
+            {
+                bool connected = false;
+                if (apiExposure == ApiExposure::eLazy && pathConnectedModuleOut.empty())
+                {
+                    ConnectApi();
+                    connected = IsConnected();
+                }
+                return connected;
+            }
+            //!
             //! @brief Get the module input by path
             //!
             //! @param connectorPath Path of the input connector
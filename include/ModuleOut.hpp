@@ -25,11 +25,31 @@ namespace ModelController
             //!
             //! @brief Actual value of the output
             //!
-            T actualValue; // ToDo: initialize type dependent
+            T actualValue = T();
             //!
             //! @brief Listener called, if new output module was created
             //!
             Event<std::string>::Listener* OnModuleInCreated = nullptr;
+            //!
+            //! @brief Exposure of the output to the API
+            //!
+            ApiExposure apiExposure = ApiExposure::eNone;
+            //!
+            //! @brief True if the API variable listens to the output
+            //!
+            bool exposed = false;
+            //!
+            //! @brief Create and set event to write changes to API variable
+            //!
+            void ConnectApi()
+            {
+                Logger::trace("Creating connection to default connector for " + this->GetPath());
+                ModuleIn<T>* connectedAPIVariable = ModuleIn<T>::GetModuleInput(apiPath + this->GetPath());
+                if (connectedAPIVariable != nullptr)
+                {
+                    exposed = connectedAPIVariable->SetOutputChangedEvent(&(this->ValueChangedEvent));
+                }
+            }
         protected:
             //!
             //! @brief Path to the connected output module
@@ -54,41 +74,42 @@ namespace ModelController
                 ModuleOutCreated(this->GetPath());
                 if (!Utils::StartsWith(GetPath(), apiPath))
                 {
-                    Logger::trace("Creating connection to default connector for " + this->GetPath());
-                    // Create and set event to write changes to API variable
-                    ModuleIn<T>* connectedAPIVariable = ModuleIn<T>::GetModuleInput(apiPath + this->GetPath());
-                    if (connectedAPIVariable != nullptr)
+                    // Outputs can't be set by the API, so read-only and read-write are the same
+                    apiExposure = GetApiExposure();
+                    if (apiExposure == ApiExposure::eReadOnly || apiExposure == ApiExposure::eReadWrite)
                     {
-                        connectedAPIVariable->SetOutputChangedEvent(&(this->ValueChangedEvent));
+                        ConnectApi();
                     }
                 }
             }
             //!
+            //! @brief Start publishing the output, if it is lazy and not exposed yet
+            //!
+            //! @return true Output was connected to the API by this call
+            //! @return false Output isn't lazy, already exposed or API isn't available
+            //!
+            virtual bool Expose() override
+            {
+                bool connected = false;
+                if (apiExposure == ApiExposure::eLazy && !exposed)
+                {
+                    ConnectApi();
+                    connected = exposed;
+                }
+                return connected;
+            }
+            //!
             //! @brief Set the target value for the output
             //!
             //! @param value Target value for output
             //!
             void SetValue(T value)
             {
-                std::string strValue;
-                std::string strActualValue;
-                if constexpr (std::is_same<T, std::string>::value)
-                {
-                    strValue = value;
-                    strActualValue = actualValue;
-                }
-                else
-                {
-                    strValue = std::to_string(value);
-                    strActualValue = std::to_string(actualValue);
-                }
-                Logger::trace("ModuleOut::SetValue(" + strValue + ")");
-                Logger::trace("actualValue" + strActualValue);
                 if (actualValue != value)
                 {
-                    Logger::trace("Changing value");
                     actualValue = value;
                     ValueChangedEvent(GetValue());
+                    ModuleOutChanged(this);
                 }
             }
             //!
@@ -107,7 +128,66 @@ namespace ModelController
             //!
             virtual void SetStringValue(std::string value) override
             {
-                this->SetValue(Utils::FromString<T>(value));
+                SetRawValue(value.c_str(), value.size());
+            }
+            //!
+            //! @brief Parse incoming characters to T and set to variable
+            //!
+            //! @param value Characters containing the value
+            //! @param length Number of characters
+            //! @return true Value was parsed and set
+            //! @return false Value could not be parsed
+            //!
+            virtual bool SetRawValue(const char* value, size_t length) override
+            {
+                T parsed;
+                bool success = Utils::FromChars(value, length, parsed);
+                if (success)
+                {
+                    this->SetValue(parsed);
+                }
+                return success;
+            }
+            //!
+            //! @brief Parse incoming characters to T without setting the variable
+            //!
+            //! @param value Characters containing the value
+            //! @param length Number of characters
+            //! @return true Value can be parsed
+            //! @return false Value can't be parsed
+            //!
+            virtual bool IsValidRawValue(const char* value, size_t length) const override
+            {
+                T parsed;
+                return Utils::FromChars(value, length, parsed);
+            }
+            //!
+            //! @brief Decode payload to T and set to variable
+            //!
+            //! @param encoding Encoding of the payload
+            //! @param value Payload containing the value
+            //! @param length Length of the payload
+            //! @return true Value was decoded and set
+            //! @return false Value could not be decoded
+            //!
+            virtual bool SetEncodedValue(PayloadCodec::Encoding encoding, const char* value, size_t length) override
+            {
+                T decoded = T();
+                bool success = PayloadCodec::Decode(encoding, value, length, decoded);
+                if (success)
+                {
+                    this->SetValue(decoded);
+                }
+                return success;
+            }
+            //!
+            //! @brief Get the number of listeners to the value changed event
+            //!
+            //! @return size_t Number of listeners
+            //!
+            virtual size_t GetListenerCount() const override
+            {
+                return ValueChangedEvent.GetListenerCount();
             }
             //!
             //! @brief Get the actual value set to output
@@ -119,6 +199,24 @@ namespace ModelController
                 return actualValue;
             }
             //!
+            //! @brief Get the actual value converted to string
+            //!
+            //! @return std::string Actual value
+            //!
+            virtual std::string GetStringValue() const override
+            {
+                return Utils::ToString(GetValue());
+            }
+            //!
+            //! @brief Write the actual value to json
+            //!
+            //! @param value Json variant the value is written to
+            //!
+            virtual void GetJsonValue(JsonVariant value) const override
+            {
+                value.set(GetValue());
+            }
+            //!
             //! @brief Operator T to return value
             //!
             //! @return T Value of the item
@@ -27,9 +27,9 @@ namespace ModelController
         //!
         static constexpr uint8_t numberChannels = 16;
         //!
-        //! @brief Number of the channel
+        //! @brief Number of the channel, -1 if no channel is free
         //!
-        uint8_t channel;
+        int channel;
         //!
         //! @brief Resolution of the channel
         //!
@@ -39,6 +39,18 @@ namespace ModelController
         //!
         ConfigItem<uint32_t> frequency;
         //!
+        //! @brief Exponent mapping the percent to the duty (1 for linear, e.g. 2.2 for LEDs)
+        //!
+        ConfigItem<double> gamma;
+        //!
+        //! @brief Number of intervals of the gamma table
+        //!
+        static constexpr size_t gammaIntervals = 64;
+        //!
+        //! @brief Duty at the borders of the intervals, generated with the resolution (empty if gamma is 1)
+        //!
+        std::vector<uint32_t> gammaTable;
+        //!
         //! @brief Pins attached to the channel
         //!
         std::vector<uint8_t> pins;  // ToDo: Config Item for Array
@@ -49,7 +61,7 @@ namespace ModelController
         //!
         static int GetFreeChannel();
         //!
-        //! @brief Reset the channels parameters
+        //! @brief Reset the channels parameters and generate the gamma table for the resolution
         //!
         //! @param frequency   Cycle Frequency of the channel
         //! @param resolution  Resolution of the channel
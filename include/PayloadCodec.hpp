@@ -0,0 +1,233 @@
+//!
+//! @file PayloadCodec.hpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Encoding and decoding of values in message payloads (text, raw, CBOR)
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include "Utils.hpp"
+
+namespace ModelController
+{
+    class PayloadCodec
+    {
+        public:
+            //!
+            //! @brief Encoding of a value in a payload
+            //!
+            enum class Encoding
+            {
+                eText,  //!< Value as text (e.g. "1.5")
+                eRaw,   //!< Bytes of the value in little-endian (strings as is)
+                eCbor,  //!< Value as single CBOR data item (RFC 8949)
+            };
+            //!
+            //! @brief Get encoding by name
+            //!
+            //! @param name "text", "raw" or "cbor"
+            //! @param encoding Parsed encoding
+            //! @return true Name is known
+            //! @return false Name is unknown, encoding is unchanged
+            //!
+            static bool ToEncoding(std::string name, Encoding& encoding);
+            //!
+            //! @brief Encode value to payload
+            //!
+            //! @tparam T Type of the value
+            //! @param encoding Encoding to use
+            //! @param value Value to encode
+            //! @param payload String the encoded value is written to (replaced)
+            //!
+            template<typename T>
+            static void Encode(Encoding encoding, const T& value, std::string& payload)
+            {
+                payload.clear();
+                if (encoding == Encoding::eRaw)
+                {
+                    if constexpr (std::is_arithmetic<T>::value)
+                    {
+                        // ESP32 (Xtensa) is little-endian, bytes are copied as they are
+                        payload.append(reinterpret_cast<const char*>(&value), sizeof(T));
+                    }
+                    else
+                    {
+                        payload.append(value);
+                    }
+                }
+                else if (encoding == Encoding::eCbor)
+                {
+                    if constexpr (std::is_same<T, bool>::value)
+                    {
+                        payload.push_back(static_cast<char>(value ? 0xF5 : 0xF4));
+                    }
+                    else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value)
+                    {
+                        EncodeCborHead(value < 0 ? 1 : 0, value < 0 ? static_cast<uint64_t>(-1 - static_cast<int64_t>(value)) : static_cast<uint64_t>(value), payload);
+                    }
+                    else if constexpr (std::is_integral<T>::value)
+                    {
+                        EncodeCborHead(0, value, payload);
+                    }
+                    else if constexpr (std::is_floating_point<T>::value)
+                    {
+                        EncodeCborFloat(value, sizeof(T) == sizeof(float), payload);
+                    }
+                    else
+                    {
+                        EncodeCborHead(3, value.size(), payload);
+                        payload.append(value);
+                    }
+                }
+                else
+                {
+                    Utils::AppendChars(value, payload);
+                }
+            }
+            //!
+            //! @brief Decode value from payload
+            //!
+            //! @tparam T Type of the value
+            //! @param encoding Encoding of the payload
+            //! @param data Payload (not null terminated)
+            //! @param length Length of the payload
+            //! @param value Decoded value (only changed on success)
+            //! @return true Payload was decoded
+            //! @return false Payload doesn't match encoding or type
+            //!
+            template<typename T>
+            static bool Decode(Encoding encoding, const char* data, size_t length, T& value)
+            {
+                bool success = false;
+                if (encoding == Encoding::eRaw)
+                {
+                    if constexpr (std::is_same<T, bool>::value)
+                    {
+                        success = length == 1;
+                        value = success ? data[0] != 0 : value;
+                    }
+                    else if constexpr (std::is_arithmetic<T>::value)
+                    {
+                        success = length == sizeof(T);
+                        if (success)
+                        {
+                            memcpy(&value, data, sizeof(T));
+                        }
+                    }
+                    else
+                    {
+                        value.assign(data, length);
+                        success = true;
+                    }
+                }
+                else if (encoding == Encoding::eCbor)
+                {
+                    CborItem item;
+                    if (DecodeCbor(reinterpret_cast<const uint8_t*>(data), length, item))
+                    {
+                        if constexpr (std::is_arithmetic<T>::value)
+                        {
+                            success = item.type != CborItem::Type::eString;
+                            if (item.type == CborItem::Type::eUnsigned)
+                            {
+                                value = static_cast<T>(item.integer);
+                            }
+                            else if (item.type == CborItem::Type::eNegative)
+                            {
+                                value = static_cast<T>(-1 - static_cast<int64_t>(item.integer));
+                            }
+                            else if (item.type == CborItem::Type::eFloat)
+                            {
+                                value = static_cast<T>(item.number);
+                            }
+                            else if (item.type == CborItem::Type::eBool)
+                            {
+                                value = static_cast<T>(item.integer);
+                            }
+                        }
+                        else
+                        {
+                            success = item.type == CborItem::Type::eString;
+                            if (success)
+                            {
+                                value.assign(item.string, item.integer);
+                            }
+                        }
+                    }
+                }
+                else
+                {
+                    success = Utils::FromChars(data, length, value);
+                }
+                return success;
+            }
+        private:
+            //!
+            //! @brief Pure static class -> deleted ctor
+            //!
+            PayloadCodec() = delete;
+            //!
+            //! @brief Decoded CBOR data item (only the types used for values)
+            //!
+            struct CborItem
+            {
+                //!
+                //! @brief Type of the item
+                //!
+                enum class Type
+                {
+                    eUnsigned,  //!< Unsigned integer (major type 0)
+                    eNegative,  //!< Negative integer -1 - integer (major type 1)
+                    eString,    //!< Text or byte string (major type 2 and 3)
+                    eFloat,     //!< Half, single or double precision float (major type 7)
+                    eBool,      //!< false or true (major type 7), integer is 0 or 1
+                };
+                //!
+                //! @brief Type of the item
+                //!
+                Type type = Type::eUnsigned;
+                //!
+                //! @brief Argument of integers and booleans, length of strings
+                //!
+                uint64_t integer = 0;
+                //!
+                //! @brief Value of floats
+                //!
+                double number = 0;
+                //!
+                //! @brief First character of strings (points into the payload)
+                //!
+                const char* string = nullptr;
+            };
+            //!
+            //! @brief Append CBOR head with shortest argument
+            //!
+            //! @param majorType Major type (0 - 7)
+            //! @param argument Argument (value or length)
+            //! @param payload String the head is appended to
+            //!
+            static void EncodeCborHead(uint8_t majorType, uint64_t argument, std::string& payload);
+            //!
+            //! @brief Append CBOR float
+            //!
+            //! @param value Value to append
+            //! @param single True for single precision, false for double precision
+            //! @param payload String the float is appended to
+            //!
+            static void EncodeCborFloat(double value, bool single, std::string& payload);
+            //!
+            //! @brief Decode a single CBOR data item filling the whole payload
+            //!
+            //! @param data Payload
+            //! @param length Length of the payload
+            //! @param item Decoded item
+            //! @return true Item was decoded
+            //! @return false Payload is no supported item or has trailing bytes
+            //!
+            static bool DecodeCbor(const uint8_t* data, size_t length, CborItem& item);
+    };
+} // namespace ModelController
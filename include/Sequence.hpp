@@ -8,6 +8,11 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
 
 namespace ModelController
 {
@@ -17,6 +22,107 @@ namespace ModelController
     class Sequence
     {
     public:
+        //!
+        //! @brief Number type the values are interpolated with
+        //!
+        enum class Precision
+        {
+            eDouble,    //!< Double (software emulated on the ESP32)
+            eFloat,     //!< Single precision float (hardware FPU on the ESP32)
+            eFixed,     //!< Fixed point Q16.16 in 32 bit integers with 64 bit intermediate product
+        };
+        //!
+        //! @brief Number of fractional bits of fixed point values
+        //!
+        static constexpr int fixedBits = 16;
+        //!
+        //! @brief Get precision by name
+        //!
+        //! @param name "double", "float" or "fixed"
+        //! @param precision Parsed precision
+        //! @return true Name is known
+        //! @return false Name is unknown, precision is unchanged
+        //!
+        static bool ToPrecision(std::string name, Precision& precision);
+        //!
+        //! @brief Shape of the ramp of an element between start and end value
+        //!
+        enum class Curve : uint8_t
+        {
+            eLinear,        //!< Constant change (default)
+            eEaseIn,        //!< Slow start, x^2
+            eEaseOut,       //!< Slow end, 1 - (1 - x)^2
+            eEaseInOut,     //!< S-curve with slow start and end, 3x^2 - 2x^3
+            eExponential,   //!< Exponential change, (64^x - 1) / 63
+        };
+        //!
+        //! @brief Get curve by name
+        //!
+        //! @param name "linear", "in", "out", "inout" or "exp"
+        //! @param curve Parsed curve
+        //! @return true Name is known
+        //! @return false Name is unknown, curve is unchanged
+        //!
+        static bool ToCurve(std::string name, Curve& curve);
+        //!
+        //! @brief Get the name of a curve used in sequence strings
+        //!
+        //! @param curve Curve
+        //! @return const char* Name of the curve
+        //!
+        static const char* CurveToString(Curve curve);
+        //!
+        //! @brief Position of an evaluation in the table, kept by the evaluator to continue from the last element
+        //!
+        struct Cursor
+        {
+            //!
+            //! @brief True if the cursor points to an element
+            //!
+            bool valid = false;
+            //!
+            //! @brief Index of the element in the table
+            //!
+            uint32_t index = 0;
+            //!
+            //! @brief End of the children of the element's parent (index after the last sibling)
+            //!
+            uint32_t last = 0;
+            //!
+            //! @brief Time the actual iteration of the element started in microseconds
+            //!
+            uint64_t start = 0;
+            //!
+            //! @brief Time from start the element is active in microseconds (infinite if maximum)
+            //!
+            uint64_t length = 0;
+            //!
+            //! @brief Time from start the actual iteration of the parent is active in microseconds (infinite if maximum)
+            //!
+            uint64_t blockLength = 0;
+        };
+        //!
+        //! @brief Linear piece of the value, value = from + slope * (time - start) for start <= time < end
+        //!
+        struct Piece
+        {
+            //!
+            //! @brief Time the piece starts in microseconds
+            //!
+            uint64_t start = 0;
+            //!
+            //! @brief Time the piece ends in microseconds (never if maximum, which is more than 500000 years)
+            //!
+            uint64_t end = 0;
+            //!
+            //! @brief Value at start
+            //!
+            double from = 0;
+            //!
+            //! @brief Change of the value per microsecond
+            //!
+            double slope = 0;
+        };
         //!
         //! @brief Subsequences of the sequence
         //!
@@ -28,27 +134,279 @@ namespace ModelController
 
     protected:
         //!
-        //! @brief Get the actual value with relative time (time between now and start)
+        //! @brief Sequence or element compiled into the flat table
         //!
-        //! @param time Relative time since start of element
+        struct Segment
+        {
+            //!
+            //! @brief Start relative to the start of an iteration of the parent in microseconds
+            //!
+            int64_t start = 0;
+            //!
+            //! @brief Duration with repetitions in microseconds (negative if infinite)
+            //!
+            int64_t duration = 0;
+            //!
+            //! @brief Duration of one iteration in microseconds (not positive if infinite or empty)
+            //!
+            int64_t period = 0;
+            //!
+            //! @brief Start value (elements only)
+            //!
+            double from = 0;
+            //!
+            //! @brief End value (elements only)
+            //!
+            double to = 0;
+            //!
+            //! @brief Start value in fixed point (elements only, saturated to 32 bit)
+            //!
+            int32_t fromFixed = 0;
+            //!
+            //! @brief Change over one iteration in fixed point (elements only, saturated to 32 bit)
+            //!
+            int32_t deltaFixed = 0;
+            //!
+            //! @brief Start value as float (elements only)
+            //!
+            float fromFloat = 0;
+            //!
+            //! @brief Change over one iteration as float (elements only)
+            //!
+            float deltaFloat = 0;
+            //!
+            //! @brief Shape of the ramp (elements only)
+            //!
+            Curve curve = Curve::eLinear;
+            //!
+            //! @brief Index of the first child in the table
+            //!
+            uint32_t first = 0;
+            //!
+            //! @brief Number of reachable children (0 for elements)
+            //!
+            uint32_t count = 0;
+        };
         //!
-        //! @return double Actual value
+        //! @brief Flat table of the sequence tree, first entry is the sequence itself, children of an entry are contiguous
+        //!
+        //! Only filled for the root sequence
+        //!
+        std::vector<Segment> segments;
+        //!
+        //! @brief Write the sequence into the table and append its children
+        //!
+        //! @param segments Table to write to
+        //! @param index Index of the entry of the sequence
+        //!
+        virtual void Compile(std::vector<Segment>& segments, size_t index) const;
+        //!
+        //! @brief Search active element from the root, wrapping the time by the period of each level
+        //!
+        //! @param time Actual time in microseconds
+        //! @param cursor Cursor set to the active element (invalid, if no element is active)
+        //!
+        void Find(uint64_t time, Cursor& cursor) const;
+        //!
+        //! @brief Move the cursor to the element active at time
+        //!
+        //! @param time Actual time in microseconds
+        //! @param cursor Cursor of the evaluator (updated)
+        //!
+        void Advance(uint64_t time, Cursor& cursor) const;
+        //!
+        //! @brief Convert value to fixed point, saturating at the limits of 32 bit
+        //!
+        //! @param value Value to convert
+        //! @return int32_t Value in fixed point
+        //!
+        static int32_t ToFixed(double value);
+        //!
+        //! @brief Number of curves
+        //!
+        static constexpr size_t curveCount = 5;
+        //!
+        //! @brief Names of the curves in sequence strings
+        //!
+        static constexpr const char* curveNames[curveCount] = {"linear", "in", "out", "inout", "exp"};
+        //!
+        //! @brief Number of bits of the progress selecting the interval of the curve tables (64 intervals)
+        //!
+        static constexpr int curveBits = 6;
+        //!
+        //! @brief Shaped progress in fixed point at the borders of the intervals, generated when a curve is compiled first
+        //!
+        static std::vector<int32_t> curveTables[curveCount];
+        //!
+        //! @brief Maximum slope of each curve in fixed point (1 for linear), used to schedule changes of ramps
+        //!
+        static int32_t curveSlopes[curveCount];
+        //!
+        //! @brief Generate the table and slope of a curve, if it isn't generated yet
+        //!
+        //! @param curve Curve to generate
+        //!
+        static void PrepareCurve(Curve curve);
+        //!
+        //! @brief Get the progress of a ramp in fixed point
+        //!
+        //! @param relativeTime Time since the start of the iteration in microseconds
+        //! @param period Duration of the iteration in microseconds
+        //! @return uint32_t Progress in fixed point (0 <= progress < 1)
+        //!
+        static uint32_t GetProgress(uint64_t relativeTime, uint64_t period);
+        //!
+        //! @brief Shape the progress by interpolating the table of the curve
+        //!
+        //! @param curve Curve of the ramp (table needs to be prepared)
+        //! @param progress Progress in fixed point (0 <= progress < 1)
+        //! @return int32_t Shaped progress in fixed point
+        //!
+        static int32_t Shape(Curve curve, uint32_t progress);
+        //!
+        //! @brief Maximum nesting of sequences (limits the recursion of the parser)
+        //!
+        static constexpr int maxDepth = 16;
+        //!
+        //! @brief Parse a complete sequence string, the tree is only built if a sequence is passed
+        //!
+        //! Grammar (spaces are allowed between tokens):
+        //!   sequence := [repeat] '{' { sequence | element } '}'
+        //!   repeat   := 'inf' | unsigned integer
+        //!   element  := number [';' duration [';' number [';' curve]]]
+        //!   curve    := 'linear' | 'in' | 'out' | 'inout' | 'exp'
+        //!
+        //! @param text Sequence string
+        //! @param sequence Sequence the repetitions and subsequences are set to, nullptr to validate only
+        //! @param error Error message with position, if parsing failed
+        //! @return true Sequence string is valid
+        //! @return false Sequence string is invalid, sequence contains the items parsed before the error
+        //!
+        static bool Parse(std::string_view text, Sequence* sequence, std::string& error);
+        //!
+        //! @brief Parse a sequence with its repetitions at position
         //!
-        virtual double GetValueRelativeTime(long time);
+        //! @param text Sequence string
+        //! @param position Position of the sequence, moved behind the closing bracket
+        //! @param sequence Sequence the repetitions and subsequences are set to, nullptr to validate only
+        //! @param depth Nesting of the sequence
+        //! @param duration Duration of the sequence with repetitions in microseconds, -1 if infinite
+        //! @param error Error message with position, if parsing failed
+        //! @return true Sequence was parsed
+        //! @return false Sequence is invalid or its duration doesn't fit into 64 bit
+        //!
+        static bool ParseSequence(std::string_view text, size_t& position, Sequence* sequence, int depth, int64_t& duration, std::string& error);
+        //!
+        //! @brief Parse an element at position
+        //!
+        //! @param text Sequence string
+        //! @param position Position of the element, moved behind the element
+        //! @param sequence Sequence the element is added to, nullptr to validate only
+        //! @param elementDuration Duration of the element in microseconds, -1 if infinite
+        //! @param error Error message with position, if parsing failed
+        //! @return true Element was parsed
+        //! @return false Element is invalid
+        //!
+        static bool ParseElement(std::string_view text, size_t& position, Sequence* sequence, int64_t& elementDuration, std::string& error);
+        //!
+        //! @brief Parse a number at position (without copying to the heap)
+        //!
+        //! @param text Sequence string
+        //! @param position Position of the number, moved behind the number
+        //! @param value Parsed number
+        //! @return true Number was parsed
+        //! @return false No valid number at position
+        //!
+        static bool ParseNumber(std::string_view text, size_t& position, double& value);
+        //!
+        //! @brief Parse an unsigned integer at position
+        //!
+        //! @param text Sequence string
+        //! @param position Position of the integer, moved behind the integer
+        //! @param value Parsed integer
+        //! @return true Integer was parsed
+        //! @return false No digits at position or integer is out of range
+        //!
+        static bool ParseInteger(std::string_view text, size_t& position, long& value);
+        //!
+        //! @brief Parse a duration in milliseconds (fractions down to microseconds) at position
+        //!
+        //! @param text Sequence string
+        //! @param position Position of the duration, moved behind the duration
+        //! @param value Parsed duration in microseconds
+        //! @return true Duration was parsed
+        //! @return false No valid number at position or duration is negative
+        //!
+        static bool ParseDuration(std::string_view text, size_t& position, int64_t& value);
+        //!
+        //! @brief Parse the name of a curve at position
+        //!
+        //! @param text Sequence string
+        //! @param position Position of the name, moved behind the name
+        //! @param curve Parsed curve
+        //! @return true Curve was parsed
+        //! @return false No known curve at position
+        //!
+        static bool ParseCurve(std::string_view text, size_t& position, Curve& curve);
+        //!
+        //! @brief Move position behind spaces
+        //!
+        //! @param text Sequence string
+        //! @param position Position moved to the next character, which isn't a space
+        //!
+        static void SkipSpaces(std::string_view text, size_t& position);
+        //!
+        //! @brief Build error message with position
+        //!
+        //! @param position Position of the error in the sequence string
+        //! @param message Description of the error
+        //! @return std::string Error message
+        //!
+        static std::string Error(size_t position, const char* message);
         //!
         //! @brief Initialize sequence with repetition
         //!
         //! @param repeat Number of repetitions of the sequence
         //!
         Sequence(int repeat = 1);
+        //!
+        //! @brief Parsed sequences by their canonical sequence string (entries expire with the last user)
+        //!
+        static std::map<std::string, std::weak_ptr<const Sequence>, std::less<>> cache;
 
     public:
         //!
         //! @brief Construct a new Sequence object
         //!
+        //! Invalid sequence strings result in an empty sequence (value 0), use Validate to get the error
+        //!
+        //! @param sequenceString Configuration of the sequence
+        //!
+        Sequence(std::string_view sequenceString);
+        //!
+        //! @brief Check sequence string without building a sequence
+        //!
+        //! @param sequenceString Configuration of the sequence
+        //! @return std::string Error message with position, empty if the sequence string is valid
+        //!
+        static std::string Validate(std::string_view sequenceString);
+        //!
+        //! @brief Get a shared sequence for a sequence string, parsed only if no identical sequence is in use
+        //!
+        //! Sequences are immutable after parsing and evaluated with the cursor of the caller,
+        //! so equal sequence strings (compared in canonical form) share one tree and table.
+        //! Must be called from the loop (the cache isn't locked).
+        //!
         //! @param sequenceString Configuration of the sequence
+        //! @return std::shared_ptr<const Sequence> Shared sequence
         //!
-        Sequence(std::string sequenceString);
+        static std::shared_ptr<const Sequence> Get(std::string_view sequenceString);
+        //!
+        //! @brief Get the number of sequences in use by the cache
+        //!
+        //! @return size_t Number of distinct sequences
+        //!
+        static size_t GetCacheSize();
         //!
         //! @brief Destruction of the Sequence object
         //!
@@ -56,11 +414,13 @@ namespace ModelController
         //!
         //! @brief Get the duration of the sequence execution
         //!
+        //! Taken from the table for compiled sequences, else calculated from the subsequences
+        //!
         //! @param withRepeat True if duration is calculated with repetition
         //!
-        //! @return long Duration of the sequence
+        //! @return std::optional<uint64_t> Duration of the sequence in microseconds, empty if infinite
         //!
-        virtual long GetDuration(bool withRepeat = true) const;
+        virtual std::optional<uint64_t> GetDuration(bool withRepeat = true) const;
         //!
         //! @brief Get the number of repetitions of the sequence
         //!
@@ -72,14 +432,64 @@ namespace ModelController
         //!
         //! @return string Configuration of the sequence
         //!
-        virtual std::string GetSequenceString();
+        virtual std::string GetSequenceString() const;
         //!
         //! @brief Get the value by actual absolute time
         //!
-        //! @param time Acutal time
+        //! Walks down the table with a binary search per level (no recursion)
+        //!
+        //! @param time Actual time in microseconds
+        //!
+        //! @return double Actual value
+        //!
+        double GetValue(uint64_t time) const;
+        //!
+        //! @brief Get the value by actual absolute time, starting from the element of the last evaluation
+        //!
+        //! If time moved forward, the cursor stays on its element or steps to the following siblings.
+        //! The table is only searched on wraparound, jumps over nested sequences or backwards.
+        //!
+        //! The interpolation of ramps is done with the given precision, only the result is converted to double.
+        //! Curved ramps are shaped by the table of their curve in fixed point before.
+        //!
+        //! @param time Actual time in microseconds
+        //! @param cursor Cursor of the evaluator (updated)
+        //! @param precision Number type used for interpolation
         //!
         //! @return double Actual value
         //!
-        double GetValue(unsigned long time);
+        double GetValue(uint64_t time, Cursor& cursor, Precision precision = Precision::eDouble) const;
+        //!
+        //! @brief Get the value by actual absolute time in fixed point without any floating point operation
+        //!
+        //! @param time Actual time in microseconds
+        //! @param cursor Cursor of the evaluator (updated)
+        //!
+        //! @return int32_t Actual value in fixed point (Q16.16)
+        //!
+        int32_t GetFixedValue(uint64_t time, Cursor& cursor) const;
+        //!
+        //! @brief Get the linear piece of the value around time
+        //!
+        //! Constant elements are one piece, linear ramps one piece per iteration, curved ramps one piece per interval of the curve table.
+        //!
+        //! @param time Actual time in microseconds
+        //! @param cursor Cursor of the evaluator (updated)
+        //!
+        //! @return Piece Piece containing time, constant 0 forever if no element is active
+        //!
+        Piece GetPiece(uint64_t time, Cursor& cursor) const;
+        //!
+        //! @brief Get the next time the value may change
+        //!
+        //! Constant elements change at their end, ramps after the time they need to change by resolution (at the maximum slope of their curve).
+        //!
+        //! @param time Actual time in microseconds (the cursor needs to be positioned by GetValue with the same time)
+        //! @param cursor Cursor of the evaluator
+        //! @param resolution Minimum change of ramps, 0 for every microsecond
+        //!
+        //! @return std::optional<uint64_t> Time of the next change in microseconds, empty if the value stays constant
+        //!
+        std::optional<uint64_t> GetNextChange(uint64_t time, const Cursor& cursor, double resolution) const;
     };
 } // namespace ModelController
@@ -1,7 +1,7 @@
 //!
 //! @file SequenceElement.hpp
 //! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
-//! @brief Class calculating double value lineary depending on start value, end value and duration of change
+//! @brief Class calculating double value depending on start value, end value, duration and curve of change
 //!
 //! @copyright Copyright (c) 2023
 //!
@@ -22,42 +22,46 @@ namespace ModelController
         //!
         double start;
         //!
-        //! @brief Duration of the element
+        //! @brief Duration of the element in microseconds (negative if infinite)
         //!
-        long duration;
+        int64_t duration;
         //!
         //! @brief End value of the element
         //!
         double end;
+        //!
+        //! @brief Shape of the ramp from start to end value
+        //!
+        Curve curve;
 
     protected:
         //!
-        //! @brief Get the actual value with relative time (time between now and start)
-        //!
-        //! @param time Relative time since start of element
+        //! @brief Write values and duration of the element into the table
         //!
-        //! @return double Actual value
+        //! @param segments Table to write to
+        //! @param index Index of the entry of the element
         //!
-        virtual double GetValueRelativeTime(long time) override;
+        virtual void Compile(std::vector<Segment>& segments, size_t index) const override;
 
     public:
         //!
         //! @brief Construct a new SequenceElement object
         //!
         //! @param start Start value of the element
-        //! @param duration Duration of the element
+        //! @param duration Duration of the element in microseconds
         //! @param end End value of the element
         //! @param repeat Number of repetitions
+        //! @param curve Shape of the ramp from start to end value
         //!
-        SequenceElement(double start, long duration, double end, int repeat = 1);
+        SequenceElement(double start, int64_t duration, double end, int repeat = 1, Curve curve = Curve::eLinear);
         //!
         //! @brief Construct a new SequenceElement object
         //!
         //! @param start Start value of the element
-        //! @param duration Duration of the element
+        //! @param duration Duration of the element in microseconds
         //! @param repeat Number of repetitions
         //!
-        SequenceElement(double start, long duration, int repeat = 1);
+        SequenceElement(double start, int64_t duration, int repeat = 1);
         //!
         //! @brief Construct a new SequenceElement object
         //!
@@ -73,15 +77,15 @@ namespace ModelController
         //!
         //! @param withRepeat True if duration is calculated with repetition
         //!
-        //! @return long Duration of the element
+        //! @return std::optional<uint64_t> Duration of the element in microseconds, empty if infinite
         //!
-        virtual long GetDuration(bool withRepeat = true) const override;
+        virtual std::optional<uint64_t> GetDuration(bool withRepeat = true) const override;
         //!
         //! @brief Get the string of the sequence
         //!
         //! @return string String describing the sequence
         //!
-        virtual std::string GetSequenceString() override;
+        virtual std::string GetSequenceString() const override;
 
     };
 } // namespace ModelController
\ No newline at end of file
@@ -0,0 +1,88 @@
+//!
+//! @file SequenceEngine.hpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Batch evaluation of sequence processors in a structure-of-arrays layout
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "LoopEvent.hpp"
+
+namespace ModelController
+{
+    class SequenceProcessor;
+
+    class SequenceEngine
+    {
+        private:
+            //!
+            //! @brief Processors in the batch, one lane per processor
+            //!
+            static std::vector<SequenceProcessor*> processors;
+            //!
+            //! @brief Start of the actual piece of each lane in microseconds
+            //!
+            static std::vector<uint64_t> starts;
+            //!
+            //! @brief End of the actual piece of each lane in microseconds, the lane is refreshed when it is reached (0 to refresh on next pass)
+            //!
+            static std::vector<uint64_t> ends;
+            //!
+            //! @brief Value at the start of the actual piece of each lane
+            //!
+            static std::vector<double> offsets;
+            //!
+            //! @brief Change of the value per microsecond of each lane
+            //!
+            static std::vector<double> slopes;
+            //!
+            //! @brief Value of each lane calculated by the last pass
+            //!
+            static std::vector<double> values;
+            //!
+            //! @brief Listener evaluating all lanes, only exists while processors are in the batch
+            //!
+            static LoopEvent::LoopListener* loopListener;
+            //!
+            //! @brief Pure static class -> deleted ctor
+            //!
+            SequenceEngine() = delete;
+        public:
+            //!
+            //! @brief Add processor to the batch (evaluated from the next pass)
+            //!
+            //! @param processor Processor to add
+            //!
+            static void Add(SequenceProcessor* processor);
+            //!
+            //! @brief Remove processor from the batch
+            //!
+            //! @param processor Processor to remove
+            //!
+            static void Remove(SequenceProcessor* processor);
+            //!
+            //! @brief Refresh the lane of the processor on the next pass (after its inputs changed)
+            //!
+            //! @param processor Processor to refresh
+            //!
+            static void Invalidate(SequenceProcessor* processor);
+            //!
+            //! @brief Evaluate all lanes for a timestamp and set the outputs
+            //!
+            //! Lanes reaching the end of their piece are refreshed by their processor, then a single
+            //! branch-free pass over the arrays calculates all values. Without ramping lanes the listener
+            //! sleeps until the first piece ends (Add and Invalidate wake it).
+            //!
+            //! @param time Actual time in microseconds
+            //!
+            static void Evaluate(uint64_t time);
+            //!
+            //! @brief Get the number of processors in the batch
+            //!
+            //! @return size_t Number of lanes
+            //!
+            static size_t GetSize();
+    };
+} // namespace ModelController
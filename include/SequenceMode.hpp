@@ -20,7 +20,11 @@ namespace ModelController
         //!
         //! @brief Sequence of the mode
         //!
-        Sequence sequence;
+        std::shared_ptr<const Sequence> sequence;
+        //!
+        //! @brief Position of the last evaluation of the sequence
+        //!
+        Sequence::Cursor cursor;
         //!
         //! @brief On-Sequence is executed on start
         //!
@@ -30,9 +34,9 @@ namespace ModelController
         //!
         bool off = false;
         //!
-        //! @brief Sequence is syncronized
+        //! @brief Period in microseconds the start and end of the mode are aligned to, empty if not synchronized
         //!
-        long syncTime = 0;
+        std::optional<uint64_t> syncTime;
 
     public:
         //!
@@ -46,18 +50,23 @@ namespace ModelController
         //!
         ~SequenceMode();
         //!
-        //! @brief Get the actual value of the mode depending on time
+        //! @brief Get the sequence of the mode
+        //!
+        //! @return const Sequence& Sequence of the mode
+        //!
+        const Sequence& GetSequence() const;
+        //!
+        //! @brief Get the position of the last evaluation of the sequence
         //!
-        //! @param time Time for which value is needed
-        //! @return double Actual value
+        //! @return Sequence::Cursor& Cursor of the mode
         //!
-        double GetValue(unsigned long time);
+        Sequence::Cursor& GetCursor();
         //!
         //! @brief Get sync time of the mode
         //!
-        //! @return long Sync time of the mode
+        //! @return std::optional<uint64_t> Sync period in microseconds, empty if not synchronized
         //!
-        long GetSyncTime() const;
+        std::optional<uint64_t> GetSyncTime() const;
         //!
         //! @brief Get flag if on sequence is used by mode
         //!
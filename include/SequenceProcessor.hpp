@@ -11,6 +11,7 @@
 #include "ModuleOut.hpp"
 #include "Sequence.hpp"
 #include <map>
+#include <vector>
 #include "SequenceMode.hpp"
 #include "LoopEvent.hpp"
 #include "ConfigItem.hpp"
@@ -77,31 +78,39 @@ namespace ModelController
             //!
             //! @brief Sequence on turning mode off
             //!
-            Sequence off;   // ToDo: ConfigItem
+            std::shared_ptr<const Sequence> off;   // ToDo: ConfigItem
             //!
             //! @brief Sequence on turning mode on
             //!
-            Sequence on;
+            std::shared_ptr<const Sequence> on;
             //!
-            //! @brief Time where mode was started
+            //! @brief Position of the last evaluation of the off-sequence
             //!
-            long timeStartMode = -1;
+            Sequence::Cursor offCursor;
+            //!
+            //! @brief Position of the last evaluation of the on-sequence
+            //!
+            Sequence::Cursor onCursor;
+            //!
+            //! @brief Time in microseconds where mode was started, empty if not started
+            //!
+            std::optional<uint64_t> timeStartMode;
             //!
             //! @brief Get the time where on sequence is started
             //!
-            //! @return long Time where on sequence is started
+            //! @return std::optional<uint64_t> Time in microseconds where on sequence is started, empty if mode isn't started
             //!
-            long GetTimeStartOn() const;
+            std::optional<uint64_t> GetTimeStartOn() const;
             //!
-            //! @brief Time where mode was set to end
+            //! @brief Time in microseconds where mode was set to end, empty if not ending
             //!
-            long timeEndMode = -1;
+            std::optional<uint64_t> timeEndMode;
             //!
             //! @brief Get the time where off sequence is ended
             //!
-            //! @return long Time where off sequence is ended
+            //! @return std::optional<uint64_t> Time in microseconds where off sequence is ended, empty if mode isn't ending
             //!
-            long GetTimeEndOff() const;
+            std::optional<uint64_t> GetTimeEndOff() const;
             //!
             //! @brief True if mode is active
             //!
@@ -122,9 +131,74 @@ namespace ModelController
             //!
             double manualSetpoint = -1;
             //!
-            //! @brief Execute channel logic to calculate output
+            //! @brief Default of the resolution in percent, a step of a 10 bit PWM
+            //!
+            static constexpr double defaultResolution = 0.1;
+            //!
+            //! @brief Minimum change of the output during ramps before it is updated (0 updates every microsecond)
+            //!
+            ConfigItem<double> resolution;
+            //!
+            //! @brief Number type the sequences are interpolated with (config "precision": "double", "float" or "fixed")
+            //!
+            Sequence::Precision precision = Sequence::Precision::eDouble;
+            //!
+            //! @brief True if the processor is evaluated by the SequenceEngine instead of its own listener (config "batch")
+            //!
+            bool batch = false;
+            //!
+            //! @brief Additional output following the timeline of the processor (config "channels")
+            //!
+            struct Channel
+            {
+                //!
+                //! @brief Output of the channel, named like the channel
+                //!
+                ModuleOut<double>* out = nullptr;
+                //!
+                //! @brief Time in microseconds the channel runs ahead in the mode sequence (config "phase" in milliseconds, on- and off-sequences aren't shifted)
+                //!
+                uint64_t phase = 0;
+                //!
+                //! @brief Factor applied to the value of the running sequence after inverting (config "gain")
+                //!
+                double gain = 1;
+                //!
+                //! @brief True if the value of the running sequence is inverted to 100 - value (config "invert")
+                //!
+                bool invert = false;
+                //!
+                //! @brief Sequence the cursor belongs to, only compared to detect a change of the running sequence
+                //!
+                const Sequence* sequence = nullptr;
+                //!
+                //! @brief Position of the last evaluation of the channel
+                //!
+                Sequence::Cursor cursor;
+            };
+            //!
+            //! @brief Channels sharing the state and listener of the processor
+            //!
+            std::vector<Channel> channels;
+            //!
+            //! @brief Update the state of on-sequence, mode and off-sequence and select the running sequence
+            //!
+            //! @param actualTime Actual time in microseconds
+            //! @param running Sequence running at actual time, nullptr if none is running
+            //! @param cursor Cursor of the running sequence
+            //! @param sequenceStart Time in microseconds the running sequence was started
+            //! @param nextChange Time in microseconds of the next transition between the sequences, empty if none is scheduled
+            //! @return double Output value, if no sequence is running
+            //!
+            double Update(uint64_t actualTime, const Sequence*& running, Sequence::Cursor*& cursor, uint64_t& sequenceStart, std::optional<uint64_t>& nextChange);
+            //!
+            //! @brief Execute channel logic to calculate output and sleep until the output may change
             //!
             void Execute();
+            //!
+            //! @brief Evaluate the processor on the next loop after an input changed
+            //!
+            void Wake();
 
         public:
             //!
@@ -143,5 +217,25 @@ namespace ModelController
             //! @brief Destruction of the Sequence Processor object
             //!
             ~SequenceProcessor();
+            //!
+            //! @brief Check the sequences and settings of a config without creating a processor
+            //!
+            //! @param config Config of the processor
+            //! @return std::string Error message with the key and position of the error, empty if config is valid
+            //!
+            static std::string Validate(JsonObject config);
+            //!
+            //! @brief Update the state and get the linear piece of the output (used by the SequenceEngine)
+            //!
+            //! @param time Actual time in microseconds
+            //! @return Sequence::Piece Piece of the output in absolute time, ending at the next change of the sequence or transition
+            //!
+            Sequence::Piece Refresh(uint64_t time);
+            //!
+            //! @brief Set the output to a value calculated by the SequenceEngine
+            //!
+            //! @param value Value of the output
+            //!
+            void SetOutput(double value);
     };
 } // namespace ModelController
@@ -8,6 +8,12 @@
 #pragma once
 #include <string>
 #include <sstream>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
 
 namespace ModelController
 {
@@ -60,6 +66,15 @@ namespace ModelController
                 return strVal.str();
             }
             //!
+            //! @brief Convert double to the shortest string, which is parsed back to the same value
+            //!
+            //! At least 6 significant digits are used (like streams), up to 17 if needed for an exact round trip
+            //!
+            //! @param value Value to be converted
+            //! @return std::string String representation of the value
+            //!
+            static std::string ToExactString(double value);
+            //!
             //! @brief Convert string to value
             //!
             //! @tparam T Type to convert string to
@@ -75,6 +90,146 @@ namespace ModelController
                 return val;
             }
             //!
+            //! @brief Check if character is whitespace (space, tab or line break)
+            //!
+            //! @param character Character to be checked
+            //! @return true Character is whitespace
+            //! @return false Character is no whitespace
+            //!
+            static bool IsSpace(char character)
+            {
+                return character == ' ' || character == '\t' || character == '\r' || character == '\n';
+            }
+            //!
+            //! @brief Parse value in place from a character buffer (not null terminated) without allocating
+            //!
+            //! Integers are parsed with std::from_chars, floating point values with strtod on a stack copy
+            //! (the toolchain has no floating point from_chars), bools accept 1/0 and true/false.
+            //! Numbers and bools need to consume all characters, only surrounding whitespace is allowed.
+            //!
+            //! @tparam T Type to convert to
+            //! @param data Characters to be parsed
+            //! @param length Number of characters
+            //! @param value Parsed value, unchanged if parsing failed
+            //! @return true Value was parsed
+            //! @return false Characters do not contain a value of type T
+            //!
+            template<typename T>
+            static bool FromChars(const char* data, size_t length, T& value)
+            {
+                bool success = false;
+                const char* end = data + length;
+                while (!std::is_same<T, std::string>::value && data < end && IsSpace(*data))
+                {
+                    data++;
+                }
+                while (!std::is_same<T, std::string>::value && end > data && IsSpace(*(end - 1)))
+                {
+                    end--;
+                }
+                if constexpr (std::is_same<T, std::string>::value)
+                {
+                    value.assign(data, end - data);
+                    success = true;
+                }
+                else if constexpr (std::is_same<T, bool>::value)
+                {
+                    if ((end - data == 1 && *data == '1') || (end - data == 4 && strncmp(data, "true", 4) == 0))
+                    {
+                        value = true;
+                        success = true;
+                    }
+                    else if ((end - data == 1 && *data == '0') || (end - data == 5 && strncmp(data, "false", 5) == 0))
+                    {
+                        value = false;
+                        success = true;
+                    }
+                }
+                else if constexpr (std::is_integral<T>::value)
+                {
+                    T parsed;
+                    std::from_chars_result result = std::from_chars(data, end, parsed);
+                    success = result.ec == std::errc() && result.ptr == end;
+                    if (success)
+                    {
+                        value = parsed;
+                    }
+                }
+                else if constexpr (std::is_floating_point<T>::value)
+                {
+                    char buffer[32];
+                    size_t size = end - data;
+                    if (size > 0 && size < sizeof(buffer))
+                    {
+                        memcpy(buffer, data, size);
+                        buffer[size] = '\0';
+                        char* parsedEnd = nullptr;
+                        double parsed = strtod(buffer, &parsedEnd);
+                        success = parsedEnd == buffer + size;
+                        if (success)
+                        {
+                            value = static_cast<T>(parsed);
+                        }
+                    }
+                }
+                return success;
+            }
+            //!
+            //! @brief Append value as text to a string without streams (counterpart of FromChars)
+            //!
+            //! Integers (also int8_t and uint8_t) are written as numbers with std::to_chars, floating point values
+            //! with snprintf "%g" on the stack (same text as streams with their default precision of 6), bools as 1/0.
+            //!
+            //! @tparam T Type of the value
+            //! @param value Value to be appended
+            //! @param text String the value is appended to
+            //!
+            template<typename T>
+            static void AppendChars(const T& value, std::string& text)
+            {
+                if constexpr (std::is_same<T, std::string>::value)
+                {
+                    text.append(value);
+                }
+                else if constexpr (std::is_same<T, bool>::value)
+                {
+                    text.push_back(value ? '1' : '0');
+                }
+                else if constexpr (std::is_integral<T>::value)
+                {
+                    char buffer[24];
+                    std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+                    text.append(buffer, result.ptr - buffer);
+                }
+                else
+                {
+                    char buffer[32];
+                    int length = snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(value));
+                    text.append(buffer, length);
+                }
+            }
+            //!
+            //! @brief Seed of the FNV-1a hash
+            //!
+            static constexpr uint32_t hashSeed = 2166136261u;
+            //!
+            //! @brief Calculate FNV-1a hash of a character buffer
+            //!
+            //! @param data Characters to be hashed
+            //! @param length Number of characters
+            //! @param hash Hash to continue from (to hash concatenated buffers)
+            //! @return uint32_t Hash of the characters
+            //!
+            static uint32_t Hash(const char* data, size_t length, uint32_t hash = hashSeed)
+            {
+                for (size_t i = 0; i < length; i++)
+                {
+                    hash ^= static_cast<uint8_t>(data[i]);
+                    hash *= 16777619u;
+                }
+                return hash;
+            }
+            //!
             //! @brief Check if string (value) starts with other string (check)
             //!
             //! @param value String to be checked
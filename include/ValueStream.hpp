@@ -0,0 +1,188 @@
+//!
+//! @file ValueStream.hpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief WebSocket streaming value changes of subscribed ports
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+
+#include "ESPAsyncWebServer.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <mutex>
+#include "IModuleIn.hpp"
+#include "IModuleOut.hpp"
+#include "LoopEvent.hpp"
+
+namespace ModelController
+{
+    class ValueStream
+    {
+        private:
+            //!
+            //! @brief Client subscribed to value changes
+            //!
+            struct Subscriber
+            {
+                //!
+                //! @brief Prefixes of the paths the client is subscribed to
+                //!
+                std::vector<std::string> prefixes;
+                //!
+                //! @brief Minimum time between two frames in milliseconds
+                //!
+                unsigned long interval = defaultInterval;
+                //!
+                //! @brief Time the last frame was created
+                //!
+                unsigned long lastFrame = 0;
+                //!
+                //! @brief Changed values (path -> serialized json value) not yet put into a frame
+                //!
+                std::map<std::string, std::string> pending;
+                //!
+                //! @brief Frames (path -> serialized json value) waiting to be sent
+                //!
+                std::deque<std::map<std::string, std::string>> frames;
+                //!
+                //! @brief Number of frames merged into the following frame, because the client was too slow
+                //!
+                uint32_t coalesced = 0;
+            };
+            //!
+            //! @brief WebSocket the subscribers are connected to
+            //!
+            static AsyncWebSocket socket;
+            //!
+            //! @brief Subscribers by WebSocket client id
+            //!
+            static std::map<uint32_t, Subscriber> subscribers;
+            //!
+            //! @brief Latest value of a port
+            //!
+            struct Value
+            {
+                //!
+                //! @brief Serialized json value, keeps its capacity for the next change
+                //!
+                std::string serialized;
+                //!
+                //! @brief True if the value changed in the actual loop tick
+                //!
+                bool changed = false;
+            };
+            //!
+            //! @brief Latest values of the changed ports by path
+            //!
+            static std::map<std::string, Value> values;
+            //!
+            //! @brief Values changed in the actual loop tick
+            //!
+            static std::vector<std::map<std::string, Value>::iterator> changes;
+            //!
+            //! @brief Document the changed values are read into, reused for every change
+            //!
+            static JsonDocument valueDocument;
+            //!
+            //! @brief Serialized frame of each client waiting to be sent, empty if none (the strings keep their capacity)
+            //!
+            static std::map<uint32_t, std::string> outbox;
+            //!
+            //! @brief Lock of the outbox, taken by the loop and by the TCP task (which removes clients after their disconnect event)
+            //!
+            static std::mutex outboxMutex;
+            //!
+            //! @brief Listener called periodically, only set while clients are subscribed
+            //!
+            static LoopEvent::LoopListener* loopListener;
+            //!
+            //! @brief Listener to changed outputs, only set while clients are subscribed
+            //!
+            static Event<IModuleOut*>::Listener* onModuleOutChanged;
+            //!
+            //! @brief Listener to changed inputs, only set while clients are subscribed
+            //!
+            static Event<IModuleIn*>::Listener* onModuleInChanged;
+            //!
+            //! @brief Default minimum time between two frames in milliseconds
+            //!
+            static constexpr unsigned long defaultInterval = 100;
+            //!
+            //! @brief Lowest minimum time between two frames a client may request in milliseconds
+            //!
+            static constexpr unsigned long minInterval = 20;
+            //!
+            //! @brief Maximum number of frames queued per subscriber, the oldest frame is merged into the next one (keeping the latest value of each path)
+            //!
+            static constexpr size_t maxFrames = 8;
+            //!
+            //! @brief Delete default ctor for pure static object
+            //!
+            ValueStream() = delete;
+            //!
+            //! @brief Handle events of the WebSocket (called by the TCP task)
+            //!
+            //! @param server WebSocket
+            //! @param client Client of the event
+            //! @param type Type of the event
+            //! @param arg Frame info for data events
+            //! @param data Received data
+            //! @param length Length of received data
+            //!
+            static void OnEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t length);
+            //!
+            //! @brief Apply subscription message of a client
+            //!
+            //! @param id Id of the client
+            //! @param message Json message with subscribe, unsubscribe and interval
+            //!
+            static void OnMessage(uint32_t id, std::string message);
+            //!
+            //! @brief Create or delete listeners to changed values and the loop depending on subscribers
+            //!
+            static void UpdateListeners();
+            //!
+            //! @brief Check if a path is the prefix or below it (prefix ends at a '/' of the path)
+            //!
+            //! @param path Path of the port
+            //! @param prefix Prefix the client subscribed to
+            //! @return true Path matches the prefix
+            //! @return false Path doesn't match the prefix
+            //!
+            static bool Matches(const std::string& path, const std::string& prefix);
+            //!
+            //! @brief Store changed value of a port
+            //!
+            //! @param path Path of the port
+            //! @param value Json variant containing the value
+            //!
+            static void OnValueChanged(const std::string& path, JsonVariant value);
+            //!
+            //! @brief Append text as json string
+            //!
+            //! @param buffer Buffer to append to
+            //! @param text Text to quote and escape
+            //!
+            static void AppendString(std::string& buffer, const std::string& text);
+            //!
+            //! @brief Distribute changes of the actual tick to subscribers and put their next frames into the outbox
+            //!
+            static void Process();
+            //!
+            //! @brief Pass the frames in the outbox to the socket, if the clients' queues have space
+            //!
+            //! Called by the loop after Process() and by the TCP task on events of the clients
+            //!
+            static void Flush();
+        public:
+            //!
+            //! @brief Add WebSocket to webserver
+            //!
+            //! @param server Webserver to add WebSocket to
+            //!
+            static void Initialize(AsyncWebServer& server);
+    };
+} // namespace ModelController
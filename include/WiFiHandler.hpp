@@ -9,15 +9,162 @@
 #include "WiFi.h"
 #include "ArduinoJson.h"
 #include "EventHandling.hpp"
+#include <atomic>
+#include <cstring>
 
 class WiFiHandler
 {
+public:
+    //!
+    //! @brief State of the WiFi connection
+    //!
+    enum class State
+    {
+        eDisconnected,  //!< Neither STA nor AP started
+        eConnecting,    //!< STA started, waiting for IP
+        eConnected,     //!< STA connected and got IP
+        eAccessPoint,   //!< AP started
+    };
 private:
     //!
     //! @brief Time where WiFi connection was started
     //!
     static unsigned long timeStarted;
     //!
+    //! @brief Actual state (only changed by the loop)
+    //!
+    static State state;
+    //!
+    //! @brief Time of the last state transition in milliseconds
+    //!
+    static unsigned long stateChanged;
+    //!
+    //! @brief True if STA got an IP (written by the WiFi event task)
+    //!
+    static std::atomic<bool> linkUp;
+    //!
+    //! @brief Time the link went up or down in milliseconds (written by the WiFi event task)
+    //!
+    static std::atomic<unsigned long> linkChanged;
+    //!
+    //! @brief True if the WiFi event callback is registered
+    //!
+    static bool eventsRegistered;
+    //!
+    //! @brief Callback of the WiFi events, only stores the link state (called by the WiFi event task)
+    //!
+    //! @param event Id of the event
+    //! @param info Info of the event
+    //!
+    static void OnWiFiEvent(arduino_event_id_t event, arduino_event_info_t info);
+    //!
+    //! @brief Change state and timestamp transition
+    //!
+    //! @param newState State to change to
+    //! @param time Time of the transition in milliseconds
+    //!
+    static void SetState(State newState, unsigned long time);
+    //!
+    //! @brief Parameters of the last successful connection, persisted to skip scan (and DHCP) on reconnect
+    //!
+    struct ConnectionCache
+    {
+        //!
+        //! @brief SSID the parameters belong to (null terminated)
+        //!
+        char ssid[33] = {};
+        //!
+        //! @brief BSSID of the access point
+        //!
+        uint8_t bssid[6] = {};
+        //!
+        //! @brief Channel of the access point
+        //!
+        int32_t channel = 0;
+        //!
+        //! @brief IP of the lease
+        //!
+        uint32_t ip = 0;
+        //!
+        //! @brief Gateway of the lease
+        //!
+        uint32_t gateway = 0;
+        //!
+        //! @brief Subnet mask of the lease
+        //!
+        uint32_t subnet = 0;
+        //!
+        //! @brief DNS server of the lease
+        //!
+        uint32_t dns = 0;
+        //!
+        //! @brief Compare field by field (padding after bssid isn't initialized)
+        //!
+        //! @param other Cache to compare with
+        //! @return true All fields are equal
+        //! @return false At least one field differs
+        //!
+        bool operator==(const ConnectionCache& other) const
+        {
+            return strncmp(ssid, other.ssid, sizeof(ssid)) == 0 && memcmp(bssid, other.bssid, sizeof(bssid)) == 0 && channel == other.channel
+                && ip == other.ip && gateway == other.gateway && subnet == other.subnet && dns == other.dns;
+        }
+    };
+    //!
+    //! @brief Path of the cache file in LittleFS
+    //!
+    static constexpr const char* cacheFile = "/wifi.cache";
+    //!
+    //! @brief Cached parameters of the last successful connection
+    //!
+    static ConnectionCache cache;
+    //!
+    //! @brief True if the cache was read from LittleFS (or written)
+    //!
+    static bool cacheLoaded;
+    //!
+    //! @brief True if the actual attempt uses the cached BSSID and channel
+    //!
+    static bool fastAttempt;
+    //!
+    //! @brief True if the cached BSSID and channel are tried first (config "fastConnect")
+    //!
+    static bool fastConnect;
+    //!
+    //! @brief True if the cached lease is reused by the fast attempt instead of DHCP (config "reuseLease")
+    //!
+    static bool reuseLease;
+    //!
+    //! @brief Static IP (config "ip"), DHCP is used if not set
+    //!
+    static IPAddress staticIP;
+    //!
+    //! @brief Gateway of the static IP (config "gateway")
+    //!
+    static IPAddress staticGateway;
+    //!
+    //! @brief Subnet mask of the static IP (config "subnet")
+    //!
+    static IPAddress staticSubnet;
+    //!
+    //! @brief DNS server of the static IP (config "dns")
+    //!
+    static IPAddress staticDNS;
+    //!
+    //! @brief Read cache file, if not done yet
+    //!
+    static void LoadCache();
+    //!
+    //! @brief Write parameters of the actual connection to the cache file, if they changed
+    //!
+    static void SaveCache();
+    //!
+    //! @brief Start an attempt to connect the STA
+    //!
+    //! @param fast Try cached BSSID and channel (falls back to a full scan, if the cache doesn't match the SSID)
+    //!
+    static void Connect(bool fast);
+    //!
     //! @brief Not used (class is static)
     //!
     WiFiHandler();
@@ -38,10 +185,6 @@ private:
     //!
     static int reconnects;
     //!
-    //! @brief True if AP is active
-    //!
-    static bool activeAP;
-    //!
     //! @brief SSID of the wifi station
     //!
     static std::string ssid;
@@ -50,16 +193,9 @@ private:
     //!
     static std::string password;
     //!
-    //! @brief True if WiFi-Station is connected
-    //!
-    static bool staConnected;
+    //! @brief Connect to STA with the actual SSID and password
     //!
-    //! @brief Connect to STA
-    //!
-    //! @param ssid SSID of the WiFi-Station
-    //! @param password Password of the WiFi-Station
-    //!
-    static void BeginSTA(const char* ssid, const char* password);
+    static void BeginSTA();
     //!
     //! @brief Start AP
     //!
@@ -88,13 +224,40 @@ public:
     //!
     static ModelController::Event<> STAConnected;
     //!
-    //! @brief Check if WiFi is connected
+    //! @brief Handle link changes reported by the WiFi events, reconnect or start AP on timeout
     //!
-    //! @return true WiFi is connected
+    //! @return true WiFi is connected or AP is active
     //! @return false WiFi is not connected
     //!
     static bool Check();
     //!
+    //! @brief Check if STA is connected without accessing the WiFi driver
+    //!
+    //! @return true STA is connected and got IP
+    //! @return false STA is not connected
+    //!
+    static bool IsConnected();
+    //!
+    //! @brief Get the actual state
+    //!
+    //! @return State Actual state
+    //!
+    static State GetState();
+    //!
+    //! @brief Get the time of the last state transition
+    //!
+    //! @return unsigned long Time in milliseconds (millis())
+    //!
+    static unsigned long GetStateChanged();
+    //!
+    //! @brief Set ssid, password, static IP and fast connect options from the wifi config
+    //!
+    //! Restarts the STA, if the SSID, password or static IP changed
+    //!
+    //! @param config Object with "ssid", "password" and optional "ip", "gateway", "subnet", "dns", "fastConnect" and "reuseLease"
+    //!
+    static void SetConfig(JsonObject config);
+    //!
     //! @brief Set ssid and password for WiFi-Connection
     //!
     //! @param ssid SSID of the WiFi-Station
@@ -12,7 +12,7 @@ namespace ModelController
     //!
     //! @brief Override and do nothing to ensure, that BaseContainer won't contain BaseContainers as children
     //!
-    void BaseContainer::SetConfig(JsonObject config)
+    void BaseContainer::SetConfig(JsonObject)
     {}
     //!
     //! @brief Delete config and object
@@ -10,6 +10,7 @@
 #include <sstream>
 #include "LittleFS.h"
 #include "Logger.hpp"
+#include "ConfigFile.hpp"
 
 #include "Gain.hpp"
 #include "SequenceProcessor.hpp"
@@ -27,6 +28,10 @@ namespace ModelController
     //!
     std::string BaseModule::edgeName = "undefined";
     //!
+    //! @brief Event raised, if a module is destroyed
+    //!
+    Event<BaseModule*> BaseModule::ModuleDeleted("module_deleted");
+    //!
     //! @brief Root module
     //!
     BaseModule* BaseModule::rootModule = nullptr;
@@ -111,6 +116,30 @@ namespace ModelController
         return name;
     }
     //!
+    //! @brief Compare name with names used in config
+    //!
+    BaseModule::ApiExposure BaseModule::ToApiExposure(std::string name)
+    {
+        ApiExposure exposure = ApiExposure::eInherit;
+        if (name == "none")
+        {
+            exposure = ApiExposure::eNone;
+        }
+        else if (name == "read-only")
+        {
+            exposure = ApiExposure::eReadOnly;
+        }
+        else if (name == "read-write")
+        {
+            exposure = ApiExposure::eReadWrite;
+        }
+        else if (name == "lazy")
+        {
+            exposure = ApiExposure::eLazy;
+        }
+        return exposure;
+    }
+    //!
     //! @brief Check possible type infos and return corresponding data type
     //!
     BaseModule::ModuleDataType BaseModule::GetDataTypeById(const std::type_info& typeInfo)
@@ -334,6 +363,49 @@ namespace ModelController
         return containers;
     }
     //!
+    //! @brief Add object, if it is input or output, and ports of children to list
+    //!
+    std::vector<BaseModule*> BaseModule::GetPorts()
+    {
+        std::vector<BaseModule*> ports;
+        if (moduleType == ModuleType::eInput || moduleType == ModuleType::eOutput)
+        {
+            ports.push_back(this);
+        }
+        for (BaseModule* child : children)
+        {
+            std::vector<BaseModule*> childPorts = child->GetPorts();
+            ports.insert(ports.end(), childPorts.begin(), childPorts.end());
+        }
+        return ports;
+    }
+    //!
+    //! @brief Walk up the parents and check their "api" config for the relative path of the object, its default or a plain exposure
+    //!
+    BaseModule::ApiExposure BaseModule::GetApiExposure() const
+    {
+        ApiExposure exposure = ApiExposure::eInherit;
+        std::string relativePath = name;
+        for (const BaseModule* module = parent; module != nullptr && exposure == ApiExposure::eInherit; module = module->parent)
+        {
+            JsonVariant api = ConfigFile::GetConfig(module->path)["api"];
+            if (api.is<JsonObject>())
+            {
+                exposure = ToApiExposure(api[relativePath] | "");
+                if (exposure == ApiExposure::eInherit)
+                {
+                    exposure = ToApiExposure(api["default"] | "");
+                }
+            }
+            else
+            {
+                exposure = ToApiExposure(api | "");
+            }
+            relativePath = module->name + "/" + relativePath;
+        }
+        return exposure == ApiExposure::eInherit ? ApiExposure::eReadWrite : exposure;
+    }
+    //!
     //! @brief Construct a new Module object
     //!
     BaseModule::BaseModule(std::string name, BaseModule* parent, ModuleType type, ModuleDataType dataType)
@@ -369,6 +441,7 @@ namespace ModelController
         {
             parent->children.erase(remove(parent->children.begin(), parent->children.end(), this), parent->children.end());
         }
+        ModuleDeleted(this);
     }
     //!
     //! @brief Generates module from json
@@ -411,6 +484,30 @@ namespace ModelController
         return module;
     }
     //!
+    //! @brief Validate modules of known types, search children of others
+    //!
+    std::string BaseModule::ValidateModule(std::string name, JsonObject moduleConfig)
+    {
+        std::string errorMessage = "";
+        std::string type = moduleConfig["type"].is<std::string>() ? moduleConfig["type"].as<std::string>() : "";
+        if (type == SequenceProcessor::type)
+        {
+            std::string error = SequenceProcessor::Validate(moduleConfig);
+            errorMessage = error.empty() ? "" : name + "/" + error;
+        }
+        else if (type != Gain::type && type != OnboardPWM::type && type != MQTTClient::type)
+        {
+            for (JsonPair child : moduleConfig)
+            {
+                if (errorMessage.empty() && child.value().is<JsonObject>())
+                {
+                    errorMessage = ValidateModule(name + "/" + child.key().c_str(), child.value());
+                }
+            }
+        }
+        return errorMessage;
+    }
+    //!
     //! @brief Returns parent of the actual object
     //!
     BaseModule* BaseModule::GetParent() const
@@ -432,6 +529,13 @@ namespace ModelController
         return name;
     }
     //!
+    //! @brief Modules without ports have nothing to expose
+    //!
+    bool BaseModule::Expose()
+    {
+        return false;
+    }
+    //!
     //! @brief Get module with path and call delete on this module
     //!
     void BaseModule::Delete(std::string path)
@@ -442,6 +546,28 @@ namespace ModelController
             module->Delete();
         }
     }
+    //!
+    //! @brief Deserialize config, check if it is an object and validate the modules in it
+    //!
+    std::string BaseModule::Validate(std::string config)
+    {
+        std::string errorMessage = "";
+        JsonDocument configDoc;
+        ArduinoJson::DeserializationError error = deserializeJson(configDoc, config);
+        if (error)
+        {
+            errorMessage = error.c_str();
+        }
+        else if (!configDoc.is<JsonObject>())
+        {
+            errorMessage = "NoObjectType";
+        }
+        else
+        {
+            errorMessage = ValidateModule("", configDoc.as<JsonObject>());
+        }
+        return errorMessage;
+    }
     std::string BaseModule::Set(std::string path, std::string config)
     {
         Logger::trace("BaseModule::Set(" + path + ", " + config + ")");
@@ -451,7 +577,8 @@ namespace ModelController
 
         if (!error)
         {
-            if (configDoc.is<JsonObject>())
+            errorMessage = configDoc.is<JsonObject>() ? ValidateModule("", configDoc.as<JsonObject>()) : "NoObjectType";
+            if (errorMessage.empty())
             {
                 // Remove '/' at beginning of the path
                 path = Utils::TrimStart(path, "/");
@@ -476,10 +603,6 @@ namespace ModelController
                 ConfigFile::SetConfig(path, configDoc.as<JsonObject>());
                 BaseModule::GenerateModule(childName, configDoc.as<JsonObject>(), parent);
             }
-            else
-            {
-                errorMessage = "NoObjectType";
-            }
         }
         else
         {
@@ -525,6 +648,35 @@ namespace ModelController
         return containers;
     }
     //!
+    //! @brief Get ports of module with path or of modules starting with path
+    //!
+    std::vector<BaseModule*> BaseModule::GetPorts(std::string path)
+    {
+        BaseModule* module = GetFinalMatchingModule<BaseModule>(path);
+        std::vector<BaseModule*> ports;
+        if (module != nullptr)
+        {
+            path = '/' + Utils::Trim(path, "/");
+            if (module->GetPath() == path)
+            {
+                ports = module->GetPorts();
+            }
+            else
+            {
+                path = path + '/';
+                for (BaseModule* child : module->children)
+                {
+                    if (Utils::StartsWith(child->GetPath(), path))
+                    {
+                        std::vector<BaseModule*> childPorts = child->GetPorts();
+                        ports.insert(ports.end(), childPorts.begin(), childPorts.end());
+                    }
+                }
+            }
+        }
+        return ports;
+    }
+    //!
     //! @brief Update config of the controller
     //!
     void BaseModule::UpdateConfig(JsonObject config)
@@ -540,7 +692,7 @@ namespace ModelController
             config["wifi"]["password"] = WiFiHandler::GetPassword();
         }
 
-        WiFiHandler::SetSSIDPassword(config["wifi"]["ssid"], config["wifi"]["password"]);
+        WiFiHandler::SetConfig(config["wifi"].as<JsonObject>());
 
         if (!config["APIPath"].is<std::string>())
         {
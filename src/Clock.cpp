@@ -0,0 +1,31 @@
+//!
+//! @file Clock.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Implementation of the Clock
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include "Clock.hpp"
+#include <esp_timer.h>
+
+namespace ModelController
+{
+    //!
+    //! @brief Source of the time
+    //!
+    uint64_t (*Clock::source)() = nullptr;
+    //!
+    //! @brief Read the source or the 64 bit ESP timer
+    //!
+    uint64_t Clock::Now()
+    {
+        return source != nullptr ? source() : static_cast<uint64_t>(esp_timer_get_time());
+    }
+    //!
+    //! @brief Set source of the time
+    //!
+    void Clock::SetSource(uint64_t (*source)())
+    {
+        Clock::source = source;
+    }
+} // namespace ModelController
@@ -7,13 +7,19 @@
 //!
 #include "ConfigAPI.hpp"
 #include "Logger.hpp"
+#include "LoopEvent.hpp"
+#include "IModuleIn.hpp"
+#include "IModuleOut.hpp"
+#include "ValueStream.hpp"
+#include "Metrics.hpp"
+#include "Utils.hpp"
 
 namespace ModelController
 {
     //!
     //! @brief Webserver for API calls
     //!
-    WebServer ConfigAPI::server(80);
+    AsyncWebServer ConfigAPI::server(80);
     //!
     //! @brief True if API is listening
     //!
@@ -23,40 +29,102 @@ namespace ModelController
     //!
     bool ConfigAPI::initialized = false;
     //!
-    //! @brief Iterate through args until arg with name path was found
+    //! @brief Id of the next set request (ids start with 1)
     //!
-    std::string ConfigAPI::GetPathFromArgs()
+    std::atomic<uint32_t> ConfigAPI::nextSetId(1);
+    //!
+    //! @brief Id of the last executed set request
+    //!
+    uint32_t ConfigAPI::lastSetId = 0;
+    //!
+    //! @brief Results of the last executed set requests
+    //!
+    std::deque<std::pair<uint32_t, std::string>> ConfigAPI::setResults;
+    //!
+    //! @brief Get arg with name path
+    //!
+    std::string ConfigAPI::GetPathFromArgs(AsyncWebServerRequest* request)
+    {
+        return GetFromArgs(request, "path");
+    }
+    //!
+    //! @brief Get value of query arg, empty if not found
+    //!
+    std::string ConfigAPI::GetFromArgs(AsyncWebServerRequest* request, std::string arg)
+    {
+        std::string value;
+        if (request->hasParam(arg.c_str()))
+        {
+            value = request->getParam(arg.c_str())->value().c_str();
+        }
+        return value;
+    }
+    //!
+    //! @brief Body is collected in temp object of the request (freed by the request)
+    //!
+    std::string ConfigAPI::GetBody(AsyncWebServerRequest* request)
     {
-        return GetFromArgs("path");
+        return request->_tempObject != nullptr ? static_cast<const char*>(request->_tempObject) : "";
     }
     //!
-    //! @brief Iterate through args until arg with name path was found
+    //! @brief Check length of the body and answer with 413, if it exceeds the maximum size
     //!
-    std::string ConfigAPI::GetFromArgs(std::string arg)
+    bool ConfigAPI::CheckBodySize(AsyncWebServerRequest* request)
     {
-        return server.arg(arg.c_str()).c_str();
+        bool valid = request->contentLength() <= maxBodySize;
+        if (!valid)
+        {
+            request->send(413, "text/plain", "PayloadTooLarge");
+        }
+        return valid;
+    }
+    //!
+    //! @brief Copy chunk to temp object of the request, chunks of oversized bodies are dropped (request is answered with 413)
+    //!
+    void ConfigAPI::handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t length, size_t index, size_t total)
+    {
+        if (total <= maxBodySize)
+        {
+            if (index == 0)
+            {
+                request->_tempObject = malloc(total + 1);
+            }
+            if (request->_tempObject != nullptr && index + length <= total)
+            {
+                char* body = static_cast<char*>(request->_tempObject);
+                memcpy(body + index, data, length);
+                body[index + length] = '\0';
+            }
+        }
     }
     //!
     //! @brief Send parameters on specified path
     //!
-    void ConfigAPI::handleGetParameters()
+    void ConfigAPI::handleGetParameters(AsyncWebServerRequest* request)
     {
-        std::string path = GetPathFromArgs();
+        std::string path = GetPathFromArgs(request);
         Logger::debug("ConfigAPI: Received GetParameters for path " + path);
         std::string message;
-        message = ModelController::ConfigFile::GetConfig(path).as<std::string>();
+        {
+            std::lock_guard<std::mutex> lock(LoopEvent::GetMutex());
+            message = ModelController::ConfigFile::GetConfig(path).as<std::string>();
+        }
         // ToDo: Maybe handle this later via BaseModule::GetParameters (or similary)
-        server.send(200, "text/json", message.c_str());
+        request->send(200, "text/json", message.c_str());
     }
     //!
     //! @brief Send parameters on specified path
     //!
-    void ConfigAPI::handleGetContainers()
+    void ConfigAPI::handleGetContainers(AsyncWebServerRequest* request)
     {
-        std::string path = GetPathFromArgs();
-        std::string type = GetFromArgs("type");
+        std::string path = GetPathFromArgs(request);
+        std::string type = GetFromArgs(request, "type");
         Logger::debug("ConfigAPI: Received GetContainers for path " + path + " with type '" + type + "'");
-        std::vector<std::string> containers = BaseModule::GetContainers(path, type);
+        std::vector<std::string> containers;
+        {
+            std::lock_guard<std::mutex> lock(LoopEvent::GetMutex());
+            containers = BaseModule::GetContainers(path, type);
+        }
         JsonDocument doc;
         JsonArray arr = doc.to<JsonArray>();
         for (std::string container : containers)
@@ -65,35 +133,225 @@ namespace ModelController
         }
 
         std::string message = doc.as<std::string>();
-        server.send(200, "text/json", message.c_str());
+        request->send(200, "text/json", message.c_str());
     }
     //!
-    //! @brief Delete module on specified path
+    //! @brief Post deletion of module on specified path to the loop
     //!
-    void ConfigAPI::handleDelete()
+    void ConfigAPI::handleDelete(AsyncWebServerRequest* request)
     {
-        std::string path = GetPathFromArgs();
+        std::string path = GetPathFromArgs(request);
         Logger::debug("ConfigAPI: Received Delete for path " + path);
-        BaseModule::Delete(path);
-        server.send(200, "text/plain");
+        LoopEvent::Post([path](){ BaseModule::Delete(path); });
+        request->send(200, "text/plain");
+    }
+    //!
+    //! @brief Validate config, post setting of module on specified path to the loop and answer with the id of the set request
+    //!
+    //! The TCP task doesn't wait for the loop, the result is available from /SetResult?id=<id> after the loop executed the set
+    //!
+    void ConfigAPI::handleSet(AsyncWebServerRequest* request)
+    {
+        if (CheckBodySize(request))
+        {
+            std::string path = GetPathFromArgs(request);
+            std::string content = GetBody(request);
+            Logger::debug("ConfigAPI: Received Set for path " + path + " with content\n" + content);
+            std::string message = BaseModule::Validate(content);
+            if (message.empty())
+            {
+                uint32_t id = nextSetId.fetch_add(1, std::memory_order_relaxed);
+                LoopEvent::Post([id, path, content]()
+                {
+                    std::string error = BaseModule::Set(path, content);
+                    if (!error.empty())
+                    {
+                        Logger::warning("ConfigAPI: Set " + std::to_string(id) + " for path " + path + " failed: " + error);
+                    }
+                    setResults.emplace_back(id, error);
+                    if (setResults.size() > maxSetResults)
+                    {
+                        setResults.pop_front();
+                    }
+                    lastSetId = id;
+                });
+                std::string location = "/SetResult?id=" + std::to_string(id);
+                AsyncWebServerResponse* response = request->beginResponse(202, "text/plain", std::to_string(id).c_str());
+                response->addHeader("Location", location.c_str());
+                request->send(response);
+            }
+            else
+            {
+                request->send(400, "text/plain", message.c_str());
+            }
+        }
+    }
+    //!
+    //! @brief Answer 200 if the set succeeded, 400 with the error if it failed, 202 while pending and 404 for unknown ids
+    //!
+    void ConfigAPI::handleGetSetResult(AsyncWebServerRequest* request)
+    {
+        uint32_t id = 0;
+        std::string idArg = GetFromArgs(request, "id");
+        Utils::FromChars(idArg.c_str(), idArg.size(), id);
+        int status = 404;
+        std::string message = "NotFound";
+        {
+            std::lock_guard<std::mutex> lock(LoopEvent::GetMutex());
+            for (std::pair<uint32_t, std::string>& result : setResults)
+            {
+                if (result.first == id)
+                {
+                    status = result.second.empty() ? 200 : 400;
+                    message = result.second;
+                }
+            }
+            if (status == 404 && id > lastSetId && id < nextSetId.load(std::memory_order_relaxed))
+            {
+                status = 202;
+                message = "Pending";
+            }
+        }
+        request->send(status, "text/plain", message.c_str());
     }
     //!
-    //! @brief Set module on specified path
+    //! @brief Cast module to output or input and write its value
     //!
-    void ConfigAPI::handleSet()
+    bool ConfigAPI::GetJsonValue(BaseModule* module, JsonVariant value)
     {
-        std::string path = GetPathFromArgs();
-        std::string content = server.arg("plain").c_str();
-        Logger::debug("ConfigAPI: Received Set for path " + path + " with content\n" + content);
-        std::string message = BaseModule::Set(path, content).c_str();
-        if (message.empty())
+        bool retVal = false;
+        if (IModuleOut* output = dynamic_cast<IModuleOut*>(module))
+        {
+            output->GetJsonValue(value);
+            retVal = true;
+        }
+        else if (IModuleIn* input = dynamic_cast<IModuleIn*>(module))
+        {
+            input->GetJsonValue(value);
+            retVal = true;
+        }
+        return retVal;
+    }
+    //!
+    //! @brief Send value of the input/output on specified path
+    //!
+    void ConfigAPI::handleGetValue(AsyncWebServerRequest* request)
+    {
+        std::string path = GetPathFromArgs(request);
+        Logger::debug("ConfigAPI: Received GetValue for path " + path);
+        JsonDocument doc;
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(LoopEvent::GetMutex());
+            BaseModule* module = BaseModule::GetModule<IModuleOut>(path);
+            if (module == nullptr)
+            {
+                module = BaseModule::GetModule<IModuleIn>(path);
+            }
+            found = GetJsonValue(module, doc.to<JsonVariant>());
+        }
+        if (found)
         {
-            server.send(201);
+            std::string message = doc.as<std::string>();
+            request->send(200, "text/json", message.c_str());
         }
         else
         {
-            server.send(400, "text/plain", message.c_str());
+            request->send(404, "text/plain", "NotFound");
+        }
+    }
+    //!
+    //! @brief Send values of all ports with the given paths (arg path, may be repeated) or below prefix (arg prefix) as one object
+    //!
+    void ConfigAPI::handleGetValues(AsyncWebServerRequest* request)
+    {
+        std::vector<std::string> paths;
+        std::string prefix = GetFromArgs(request, "prefix");
+        for (size_t i = 0; i < request->params(); i++)
+        {
+            AsyncWebParameter* param = request->getParam(i);
+            if (!param->isPost() && !param->isFile() && param->name() == "path")
+            {
+                paths.push_back(param->value().c_str());
+            }
+        }
+        Logger::debug("ConfigAPI: Received GetValues for " + std::to_string(paths.size()) + " paths and prefix '" + prefix + "'");
+        JsonDocument doc;
+        JsonObject values = doc.to<JsonObject>();
+        {
+            std::lock_guard<std::mutex> lock(LoopEvent::GetMutex());
+            for (std::string path : paths)
+            {
+                BaseModule* module = BaseModule::GetModule<BaseModule>(path);
+                if (module != nullptr)
+                {
+                    GetJsonValue(module, values[module->GetPath()].to<JsonVariant>());
+                }
+            }
+            if (!prefix.empty())
+            {
+                for (BaseModule* module : BaseModule::GetPorts(prefix))
+                {
+                    GetJsonValue(module, values[module->GetPath()].to<JsonVariant>());
+                }
+            }
+        }
+        std::string message = doc.as<std::string>();
+        request->send(200, "text/json", message.c_str());
+    }
+    //!
+    //! @brief Check if output exists and post setting the value (body) to the loop
+    //!
+    void ConfigAPI::handleSetValue(AsyncWebServerRequest* request)
+    {
+        if (CheckBodySize(request))
+        {
+            std::string path = GetPathFromArgs(request);
+            std::string content = GetBody(request);
+            Logger::debug("ConfigAPI: Received SetValue for path " + path + " with value " + content);
+            bool found = false;
+            bool valid = false;
+            {
+                std::lock_guard<std::mutex> lock(LoopEvent::GetMutex());
+                if (IModuleOut* output = BaseModule::GetModule<IModuleOut>(path))
+                {
+                    found = true;
+                    valid = output->IsValidRawValue(content.c_str(), content.size());
+                }
+            }
+            if (!found)
+            {
+                request->send(404, "text/plain", "NotFound");
+            }
+            else if (!valid)
+            {
+                std::string message = "Value '" + content + "' can't be converted to the type of " + path;
+                request->send(400, "text/plain", message.c_str());
+            }
+            else
+            {
+                LoopEvent::Post([path, content]()
+                {
+                    if (IModuleOut* output = BaseModule::GetModule<IModuleOut>(path))
+                    {
+                        output->SetRawValue(content.c_str(), content.size());
+                    }
+                });
+                request->send(200, "text/plain");
+            }
+        }
+    }
+    //!
+    //! @brief Send metrics in Prometheus text format
+    //!
+    void ConfigAPI::handleGetMetrics(AsyncWebServerRequest* request)
+    {
+        std::string message;
+        {
+            std::lock_guard<std::mutex> lock(LoopEvent::GetMutex());
+            message = Metrics::Serialize();
         }
+        request->send(200, "text/plain; version=0.0.4", message.c_str());
     }
     //!
     //! @brief Initialize routes
@@ -103,10 +361,18 @@ namespace ModelController
         server.on("/Parameter", handleGetParameters);
         server.on("/Containers", handleGetContainers);
         server.on("/Delete", HTTP_POST, handleDelete);
-        server.on("/Set", HTTP_POST, handleSet);
+        server.on("/Set", HTTP_POST, handleSet, nullptr, handleBody);
+        server.on("/SetResult", HTTP_GET, handleGetSetResult);
+        server.on("/Value", HTTP_GET, handleGetValue);
+        server.on("/Value", HTTP_POST, handleSetValue, nullptr, handleBody);
+        server.on("/Values", HTTP_GET, handleGetValues);
+        server.on("/metrics", HTTP_GET, handleGetMetrics);
+        ValueStream::Initialize(server);
     }
     //!
-    //! @brief Initialize server if not done yet, handle client requests and start server if not done yet or wifi disconnected
+    //! @brief Initialize server if not done yet and start server if not done yet or wifi disconnected
+    //!
+    //! Requests are parsed and answered by the TCP task, so the loop is not blocked by slow clients
     //!
     void ConfigAPI::Handle(bool wifiConnected)
     {
@@ -115,7 +381,6 @@ namespace ModelController
             Initialize();
             initialized = true;
         }
-        server.handleClient();
         if (wifiConnected)
         {
             if (!listening)
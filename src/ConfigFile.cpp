@@ -6,6 +6,7 @@
 //! @copyright Copyright (c) 2023
 //!
 #include "ConfigFile.hpp"
+#include "Metrics.hpp"
 
 namespace ModelController
 {
@@ -20,15 +21,15 @@ namespace ModelController
     //!
     //! @brief Event raised, if config was reloaded
     //!
-    Event<> ConfigFile::ConfigReloaded;
+    Event<> ConfigFile::ConfigReloaded("config_reloaded");
     //!
     //! @brief Event raised, if config was changed
     //!
-    Event<std::string> ConfigFile::ConfigChanged;
+    Event<std::string> ConfigFile::ConfigChanged("config_changed");
     //!
     //! @brief Event raised, if config was deleted
     //!
-    Event<std::string> ConfigFile::ConfigDeleted;
+    Event<std::string> ConfigFile::ConfigDeleted("config_deleted");
     //!
     //! @brief Open config file and write content to configDoc
     //!
@@ -183,6 +184,7 @@ namespace ModelController
     //!
     bool ConfigFile::Save()
     {
+        unsigned long start = micros();
         File file = LittleFS.open(configFilePath.c_str(), FILE_WRITE);
         if (!file)
         {
@@ -190,6 +192,8 @@ namespace ModelController
         }
         serializeJson(configDoc, file);
         file.close();
+        Metrics::configSaves.Increment();
+        Metrics::configSaveDuration.Observe(micros() - start);
         return true;
     }
     //!
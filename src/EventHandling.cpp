@@ -0,0 +1,83 @@
+//!
+//! @file EventHandling.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Implementation of the type independent part of events
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include "EventHandling.hpp"
+
+namespace ModelController
+{
+    //!
+    //! @brief First registered event
+    //!
+    EventBase* EventBase::first = nullptr;
+    //!
+    //! @brief Construct a new unnamed event
+    //!
+    EventBase::EventBase()
+        : EventBase(nullptr)
+    {
+    }
+    //!
+    //! @brief Construct a new event and add it to the front of the registered events
+    //!
+    EventBase::EventBase(const char* name)
+        : next(first),
+        name(name),
+        raiseCount(0)
+    {
+        if (first != nullptr)
+        {
+            first->previous = this;
+        }
+        first = this;
+    }
+    //!
+    //! @brief Unlink event from its neighbours (constant time, events of modules are deleted frequently)
+    //!
+    EventBase::~EventBase()
+    {
+        if (previous != nullptr)
+        {
+            previous->next = next;
+        }
+        else
+        {
+            first = next;
+        }
+        if (next != nullptr)
+        {
+            next->previous = previous;
+        }
+    }
+    //!
+    //! @brief Returns first registered event
+    //!
+    EventBase* EventBase::GetFirst()
+    {
+        return first;
+    }
+    //!
+    //! @brief Returns next registered event
+    //!
+    EventBase* EventBase::GetNext() const
+    {
+        return next;
+    }
+    //!
+    //! @brief Returns name of the event
+    //!
+    const char* EventBase::GetName() const
+    {
+        return name;
+    }
+    //!
+    //! @brief Returns number of raises
+    //!
+    uint64_t EventBase::GetRaiseCount() const
+    {
+        return raiseCount.load(std::memory_order_relaxed);
+    }
+} // namespace ModelController
@@ -13,7 +13,11 @@ namespace ModelController
     //!
     //! @brief Event raised if module in was created
     //!
-    Event<std::string> IModuleIn::ModuleInCreated;
+    Event<std::string> IModuleIn::ModuleInCreated("module_in_created");
+    //!
+    //! @brief Event raised if value of a module in changed
+    //!
+    Event<IModuleIn*> IModuleIn::ModuleInChanged("module_in_changed");
     //!
     //! @brief Wildcard signalizing, that submodules of created modules are ready for connection
     //!
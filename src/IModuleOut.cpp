@@ -13,7 +13,11 @@ namespace ModelController
     //!
     //! @brief Event raised if module out was created
     //!
-    Event<std::string> IModuleOut::ModuleOutCreated;
+    Event<std::string> IModuleOut::ModuleOutCreated("module_out_created");
+    //!
+    //! @brief Event raised if value of a module out changed
+    //!
+    Event<IModuleOut*> IModuleOut::ModuleOutChanged("module_out_changed");
     //!
     //! @brief Wildcard signalizing, that submodules of created modules are ready for connection
     //!
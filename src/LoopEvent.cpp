@@ -9,5 +9,77 @@
 
 namespace ModelController
 {
-    Event<> LoopEvent::loopEvent;
+    Event<> LoopEvent::loopEvent("loop");
+    //!
+    //! @brief Work items posted from other tasks
+    //!
+    std::deque<std::function<void()>> LoopEvent::workItems;
+    //!
+    //! @brief Mutex protecting the work items
+    //!
+    std::mutex LoopEvent::workItemsMutex;
+    //!
+    //! @brief Mutex held while the loop is running
+    //!
+    std::mutex LoopEvent::loopMutex;
+    //!
+    //! @brief Time the last loop was started
+    //!
+    unsigned long LoopEvent::lastRaise = 0;
+    //!
+    //! @brief Function observing the loop period
+    //!
+    void (*LoopEvent::periodObserver)(uint32_t period) = nullptr;
+    //!
+    //! @brief Take posted work items, execute them and raise loop event
+    //!
+    void LoopEvent::Raise()
+    {
+        std::lock_guard<std::mutex> lock(loopMutex);
+        unsigned long now = micros();
+        if (lastRaise != 0 && periodObserver != nullptr)
+        {
+            periodObserver(now - lastRaise);
+        }
+        lastRaise = now;
+        std::deque<std::function<void()>> pendingWorkItems;
+        {
+            std::lock_guard<std::mutex> lockWorkItems(workItemsMutex);
+            pendingWorkItems.swap(workItems);
+        }
+        for (std::function<void()>& workItem : pendingWorkItems)
+        {
+            workItem();
+        }
+        loopEvent.Raise();
+    }
+    //!
+    //! @brief Add work item to the queue
+    //!
+    void LoopEvent::Post(std::function<void()> workItem)
+    {
+        std::lock_guard<std::mutex> lock(workItemsMutex);
+        workItems.push_back(workItem);
+    }
+    //!
+    //! @brief Returns mutex of the loop
+    //!
+    std::mutex& LoopEvent::GetMutex()
+    {
+        return loopMutex;
+    }
+    //!
+    //! @brief Set observer of the loop period
+    //!
+    void LoopEvent::SetPeriodObserver(void (*observer)(uint32_t period))
+    {
+        periodObserver = observer;
+    }
+    //!
+    //! @brief Returns number of listeners of the loop event
+    //!
+    size_t LoopEvent::GetListenerCount()
+    {
+        return loopEvent.GetListenerCount();
+    }
 } // namespace ModelController
@@ -10,6 +10,10 @@
 #include "WiFiHandler.hpp"
 #include "Logger.hpp"
 #include "Utils.hpp"
+#include "Metrics.hpp"
+#include <cmath>
+#include <algorithm>
+#include <LittleFS.h>
 
 namespace ModelController
 {
@@ -18,53 +22,872 @@ namespace ModelController
     //!
     void MQTTClient::callback(char* topic, byte* message, unsigned int length)
     {
-        Logger::debug("MQTT callback called");
-        std::string topicName(topic);
-        Logger::debug("Topic: " + topicName);
-        if (mqttInputVariables.count(topic))
+        unsigned long start = micros();
+        Metrics::mqttReceived.Increment();
+        size_t topicLength = strlen(topic);
+        InputVariable* input = FindInputVariable(topic, topicLength);
+        bool batch = input == nullptr && !batchSetTopic.empty() && batchSetTopic == topic;
+        if (input == nullptr && !batch && wildcardSubscription)
         {
-            IModuleOut* outputVar = mqttInputVariables[topic];
-
-            std::string messageTemp;
-            for (int i = 0; i < length; i++)
+            input = ExposeLazyPort(topic, topicLength);
+        }
+        if (input != nullptr)
+        {
+            input->variable->SetEncodedValue(input->encoding, reinterpret_cast<const char*>(message), length);
+        }
+        else if (batch)
+        {
+            OnBatchMessage(reinterpret_cast<const char*>(message), length);
+        }
+        Metrics::mqttReceiveLatency.Observe(micros() - start);
+    }
+    //!
+    //! @brief Set server and start task connecting to the broker
+    //!
+    void MQTTClient::StartConnect()
+    {
+        // Hostname needs to be kept, because PubSubClient only stores the pointer (otherwise the domain in client is overridden, e.g. by the client ID)
+        connection->hostname = serverHostname.GetValue();
+        connection->clientID = clientID.GetValue();
+        client.setServer(connection->hostname.c_str(), serverPort.GetValue());
+        Logger::debug("Connecting to MQTT server on " + connection->hostname + ":" + std::to_string(serverPort));
+        Metrics::mqttConnectAttempts.Increment();
+        state = ConnectionState::eConnecting;
+        connectStart = micros();
+        connection->succeeded = false;
+        connection->finished.store(false, std::memory_order_relaxed);
+        // Task keeps its own reference, so the client can be deleted while connecting
+        std::shared_ptr<Connection>* taskConnection = new std::shared_ptr<Connection>(connection);
+        if (xTaskCreate(ConnectTask, "mqtt_connect", 4096, taskConnection, 1, nullptr) != pdPASS)
+        {
+            Logger::error("MQTT connect task could not be created");
+            delete taskConnection;
+            connection->finished.store(true, std::memory_order_release);
+        }
+    }
+    //!
+    //! @brief Connect, publish result to the loop, release the connection and delete task
+    //!
+    //! The loop doesn't access the PubSubClient while connecting
+    //!
+    void MQTTClient::ConnectTask(void* parameter)
+    {
+        std::shared_ptr<Connection>* taskConnection = static_cast<std::shared_ptr<Connection>*>(parameter);
+        Connection& connection = **taskConnection;
+        connection.succeeded = connection.client.connect(connection.clientID.c_str());
+        connection.finished.store(true, std::memory_order_release);
+        // Frees the connection, if the client was deleted in the meantime
+        delete taskConnection;
+        vTaskDelete(nullptr);
+    }
+    //!
+    //! @brief Double backoff (limited to backoffMax) and wait between half and full backoff
+    //!
+    //! The minimum is at least 1 ms (0 would retry on every loop) and the maximum at least the minimum
+    //!
+    void MQTTClient::ScheduleReconnect()
+    {
+        state = ConnectionState::eDisconnected;
+        unsigned long minimum = std::max<unsigned long>(backoffMin.GetValue(), 1);
+        unsigned long maximum = std::max<unsigned long>(backoffMax.GetValue(), minimum);
+        backoff = backoff == 0 ? minimum : std::min(backoff * 2, maximum);
+        unsigned long wait = backoff / 2 + esp_random() % (backoff / 2 + 1);
+        nextAttempt = millis() + wait;
+        Logger::debug("MQTT next connection attempt in " + std::to_string(wait) + " ms");
+    }
+    //!
+    //! @brief Reset backoff, subscribe to input topics and drain queue
+    //!
+    void MQTTClient::OnConnected()
+    {
+        Logger::info("MQTT connected");
+        state = ConnectionState::eConnected;
+        backoff = 0;
+        pendingSubscriptions.clear();
+        // Drain values queued while disconnected at a limited rate
+        draining = true;
+        drainTokens = 0;
+        lastRefill = millis();
+        batchSetTopic = IsBatched() ? "/" + edgeName + "/" + batchTopic.GetValue() + "/set" : "";
+        if (wildcardSubscription)
+        {
+            subscribe("/" + wildcardFilter.GetValue());
+            if (IsBatched() && wildcardFilter.GetValue() != "#")
             {
-                messageTemp += (char)message[i];
+                subscribe("/" + batchTopic.GetValue() + "/set");
             }
-            Logger::debug("Message: " + messageTemp);
-
-            outputVar->SetStringValue(messageTemp);
         }
-
+        else
+        {
+            for (std::pair<const uint32_t, InputVariable>& kvp : mqttInputVariables)
+            {
+                subscribe("/" + kvp.second.variable->GetName());
+            }
+            if (IsBatched())
+            {
+                subscribe("/" + batchTopic.GetValue() + "/set");
+            }
+        }
+        if (FlushSubscriptions())
+        {
+            unsigned long readyTime = (micros() - connectStart) / 1000;
+            Metrics::mqttReadyTime.Set(readyTime);
+            Logger::info("MQTT ready after " + std::to_string(readyTime) + " ms");
+        }
+    }
+    //!
+    //! @brief Replace variable with same topic or add new entry under hash of the topic
+    //!
+    void MQTTClient::AddInputVariable(std::string topic, IModuleOut* variable)
+    {
+        uint32_t hash = Utils::Hash(topic.c_str(), topic.size());
+        std::pair<std::unordered_multimap<uint32_t, InputVariable>::iterator, std::unordered_multimap<uint32_t, InputVariable>::iterator> range = mqttInputVariables.equal_range(hash);
+        PayloadCodec::Encoding encoding = GetEncoding(variable->GetDataType());
+        bool found = false;
+        for (std::unordered_multimap<uint32_t, InputVariable>::iterator it = range.first; it != range.second && !found; it++)
+        {
+            if (it->second.topic == topic)
+            {
+                it->second.variable = variable;
+                it->second.encoding = encoding;
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            mqttInputVariables.insert({hash, {topic, variable, encoding}});
+        }
     }
     //!
-    //! @brief Generate/Read client ID and reconnect to MQTT broker
+    //! @brief Erase all entries of the variable
+    //!
+    void MQTTClient::RemoveInputVariable(IModuleOut* variable)
+    {
+        for (std::unordered_multimap<uint32_t, InputVariable>::iterator it = mqttInputVariables.begin(); it != mqttInputVariables.end();)
+        {
+            if (it->second.variable == variable)
+            {
+                unsubscribe(it->second.topic);
+                it = mqttInputVariables.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+    }
     //!
-    //! Subscribe to input topics
+    //! @brief Hash prefix and topic and compare entries with same hash
     //!
-    void MQTTClient::reconnect()
+    MQTTClient::InputVariable* MQTTClient::FindInputVariable(const char* topic, size_t length, const char* prefix, size_t prefixLength)
     {
-        // Conversion of serverHostname to string and in second step to const char* is needed, because otherwise the domain in client is overridden by the client ID (seems to be a bug in PubSubClient)
-        std::string hostnameStr = serverHostname.GetValue();
-        const char* hostname = hostnameStr.c_str();
-        client.setServer(hostname, serverPort.GetValue());
-        Logger::debug(std::string("Connecting to MQTT server on ") + hostname + ":" + std::to_string(serverPort));
-        if (client.connect(clientID.GetValue().c_str()))
+        InputVariable* variable = nullptr;
+        uint32_t hash = Utils::Hash(topic, length, Utils::Hash(prefix, prefixLength));
+        std::pair<std::unordered_multimap<uint32_t, InputVariable>::iterator, std::unordered_multimap<uint32_t, InputVariable>::iterator> range = mqttInputVariables.equal_range(hash);
+        for (std::unordered_multimap<uint32_t, InputVariable>::iterator it = range.first; it != range.second && variable == nullptr; it++)
         {
-            Logger::info("MQTT connected");
-            for (std::pair<std::string, IModuleOut*> kvp : mqttInputVariables)
+            const std::string& entryTopic = it->second.topic;
+            if (entryTopic.size() == prefixLength + length
+                && memcmp(entryTopic.data(), prefix, prefixLength) == 0
+                && memcmp(entryTopic.data() + prefixLength, topic, length) == 0)
             {
-                subscribe(("/" + kvp.second->GetName()).c_str());
+                variable = &it->second;
             }
         }
+        return variable;
     }
     //!
-    //! @brief Call subscribe from PubSubClient
+    //! @brief Strip edge name from topic, find port and expose it, remember topics without lazy port
+    //!
+    //! Messages to lazy outputs only start publishing, their payload is ignored
     //!
-    bool MQTTClient::subscribe(std::string topic)
+    MQTTClient::InputVariable* MQTTClient::ExposeLazyPort(const char* topic, size_t length)
+    {
+        InputVariable* input = nullptr;
+        uint32_t hash = Utils::Hash(topic, length);
+        size_t prefixLength = edgeName.size() + 1;
+        uint32_t& unexposed = unexposedTopics[hash % maxUnexposedTopics];
+        if (hash == 0 || unexposed != hash)
+        {
+            BaseModule* port = nullptr;
+            if (length > prefixLength + 1 && topic[0] == '/' && topic[prefixLength] == '/' && edgeName.compare(0, edgeName.size(), topic + 1, edgeName.size()) == 0)
+            {
+                port = GetModule<BaseModule>(std::string(topic + prefixLength, length - prefixLength));
+            }
+            if (port != nullptr && port->Expose())
+            {
+                Logger::debug("MQTT exposed lazy port " + port->GetPath());
+                input = FindInputVariable(topic, length);
+            }
+            else
+            {
+                unexposed = hash;
+            }
+        }
+        return input;
+    }
+    //!
+    //! @brief Add topic with edge name to pending subscriptions
+    //!
+    void MQTTClient::subscribe(std::string topic)
     {
         topic = "/" + edgeName + topic;
         Logger::debug("Subscribing to " + topic);
-        return client.subscribe(topic.c_str());
+        pendingSubscriptions.push_back(topic);
+    }
+    //!
+    //! @brief Drop pending subscription and unsubscribe, if connected (without wildcard subscription)
+    //!
+    void MQTTClient::unsubscribe(std::string topic)
+    {
+        Logger::debug("Unsubscribing from " + topic);
+        pendingSubscriptions.erase(std::remove(pendingSubscriptions.begin(), pendingSubscriptions.end(), topic), pendingSubscriptions.end());
+        if (!wildcardSubscription && state == ConnectionState::eConnected)
+        {
+            client.unsubscribe(topic.c_str());
+        }
+    }
+    //!
+    //! @brief Check ports of the client, orphans are left after their counterparts were deleted
+    //!
+    //! Outputs are orphaned, if no input listens to them anymore, inputs, if their output was deleted
+    //!
+    void MQTTClient::CollectGarbage()
+    {
+        size_t deleted = 0;
+        for (BaseModule* port : GetPorts())
+        {
+            IModuleOut* output = dynamic_cast<IModuleOut*>(port);
+            IModuleIn* input = dynamic_cast<IModuleIn*>(port);
+            if (output != nullptr && output->GetListenerCount() == 0)
+            {
+                RemoveInputVariable(output);
+                delete port;
+                deleted++;
+            }
+            else if (input != nullptr && !input->IsConnected())
+            {
+                std::map<std::string, Publisher>::iterator publisher = publishers.find("/" + input->GetName());
+                if (publisher != publishers.end())
+                {
+                    publisher->second.orphaned = true;
+                }
+                delete port;
+                deleted++;
+            }
+        }
+        // Publishers still in the queue or schedule publish their latest value first and are erased by a later collection
+        for (std::map<std::string, Publisher>::iterator it = publishers.begin(); it != publishers.end();)
+        {
+            if (it->second.orphaned && !it->second.queued && !it->second.scheduled)
+            {
+                it = publishers.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+        if (deleted > 0)
+        {
+            Logger::debug("MQTT deleted " + std::to_string(deleted) + " orphaned inputs/outputs");
+        }
+        // Deleted or created modules may have changed the ports addressed by the topics
+        unexposedTopics.fill(0);
+        // Reset after deleting, as deleting raises ModuleDeleted again
+        collectGarbage = false;
+    }
+    //!
+    //! @brief Build SUBSCRIBE packets with several topics (QoS 0) and write them directly to the connection
+    //!
+    //! PubSubClient only supports one topic per SUBSCRIBE, SUBACKs are ignored by PubSubClient either way
+    //!
+    bool MQTTClient::FlushSubscriptions()
+    {
+        bool success = true;
+        std::vector<std::string>::iterator first = pendingSubscriptions.begin();
+        while (success && first != pendingSubscriptions.end() && client.connected())
+        {
+            // Variable header: packet identifier
+            std::vector<uint8_t> body = {static_cast<uint8_t>(subscribePacketId >> 8), static_cast<uint8_t>(subscribePacketId & 0xFF)};
+            if (++subscribePacketId == 0)
+            {
+                subscribePacketId = 1;
+            }
+            // Payload: length prefixed topics with requested QoS, at least one topic per packet
+            std::vector<std::string>::iterator last = first;
+            while (last != pendingSubscriptions.end() && (last == first || body.size() + last->size() + 3 <= maxSubscribePacketSize))
+            {
+                body.push_back(static_cast<uint8_t>(last->size() >> 8));
+                body.push_back(static_cast<uint8_t>(last->size() & 0xFF));
+                body.insert(body.end(), last->begin(), last->end());
+                body.push_back(0);
+                last++;
+            }
+            // Fixed header: SUBSCRIBE with reserved flags and remaining length
+            std::vector<uint8_t> packet = {0x82};
+            size_t remainingLength = body.size();
+            do
+            {
+                uint8_t digit = remainingLength % 128;
+                remainingLength /= 128;
+                packet.push_back(remainingLength > 0 ? digit | 0x80 : digit);
+            } while (remainingLength > 0);
+            packet.insert(packet.end(), body.begin(), body.end());
+            success = client.write(packet.data(), packet.size()) == packet.size();
+            if (success)
+            {
+                Logger::debug("MQTT subscribed to " + std::to_string(last - first) + " topics with one packet");
+                first = last;
+            }
+        }
+        pendingSubscriptions.erase(pendingSubscriptions.begin(), first);
+        return success && pendingSubscriptions.empty();
+    }
+    //!
+    //! @brief Handle incoming messages and send subscriptions of new variables
+    //!
+    void MQTTClient::Loop()
+    {
+        Logger::trace("MQTT loop");
+        if (collectGarbage)
+        {
+            CollectGarbage();
+        }
+        switch (state)
+        {
+            case ConnectionState::eDisconnected:
+                if (WiFiHandler::IsConnected() && static_cast<long>(millis() - nextAttempt) >= 0)
+                {
+                    StartConnect();
+                }
+                break;
+            case ConnectionState::eConnecting:
+                if (connection->finished.load(std::memory_order_acquire))
+                {
+                    Metrics::mqttConnectLatency.Observe(micros() - connectStart);
+                    if (connection->succeeded)
+                    {
+                        OnConnected();
+                    }
+                    else
+                    {
+                        Logger::warning("MQTT connection failed with state " + std::to_string(client.state()));
+                        Metrics::mqttConnectFailed.Increment();
+                        ScheduleReconnect();
+                    }
+                }
+                break;
+            case ConnectionState::eConnected:
+                if (client.loop())
+                {
+                    FlushSubscriptions();
+                    FlushPublishers();
+                }
+                else
+                {
+                    Logger::warning("MQTT connection lost");
+                    ScheduleReconnect();
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    //!
+    //! @brief Set default encoding from string or object, encodings of data types from object keys matching the data type names
+    //!
+    void MQTTClient::SetEncodings(JsonObject config)
+    {
+        JsonVariant encodingConfig = config["encoding"];
+        if (encodingConfig.is<std::string>() && !PayloadCodec::ToEncoding(encodingConfig.as<std::string>(), defaultEncoding))
+        {
+            Logger::warning("MQTT unknown encoding " + encodingConfig.as<std::string>());
+        }
+        for (JsonPair pair : encodingConfig.as<JsonObject>())
+        {
+            std::string key = pair.key().c_str();
+            PayloadCodec::Encoding encoding = PayloadCodec::Encoding::eText;
+            if (!PayloadCodec::ToEncoding(pair.value().as<std::string>(), encoding))
+            {
+                Logger::warning("MQTT unknown encoding " + pair.value().as<std::string>() + " for " + key);
+            }
+            else if (key == "default")
+            {
+                defaultEncoding = encoding;
+            }
+            else
+            {
+                for (int dataType = static_cast<int>(ModuleDataType::eDouble); dataType <= static_cast<int>(ModuleDataType::eBool); dataType++)
+                {
+                    if (DataTypeToString(static_cast<ModuleDataType>(dataType)) == key)
+                    {
+                        encodings[static_cast<ModuleDataType>(dataType)] = encoding;
+                    }
+                }
+            }
+        }
+    }
+    //!
+    //! @brief Batch messages are always text, use default encoding if none set for data type
+    //!
+    PayloadCodec::Encoding MQTTClient::GetEncoding(ModuleDataType dataType)
+    {
+        PayloadCodec::Encoding encoding = defaultEncoding;
+        std::map<ModuleDataType, PayloadCodec::Encoding>::iterator it = encodings.find(dataType);
+        if (IsBatched())
+        {
+            encoding = PayloadCodec::Encoding::eText;
+        }
+        else if (it != encodings.end())
+        {
+            encoding = it->second;
+        }
+        return encoding;
+    }
+    //!
+    //! @brief Compare mode with names used in config
+    //!
+    MQTTClient::PublishMode MQTTClient::ToPublishMode(std::string mode)
+    {
+        return mode == "periodic" ? PublishMode::ePeriodic : PublishMode::eOnChange;
+    }
+    //!
+    //! @brief Find publisher or create it with the policy of the topic (default policy if not configured)
+    //!
+    MQTTClient::Publisher& MQTTClient::GetPublisher(std::string topic)
+    {
+        std::map<std::string, Publisher>::iterator it = publishers.find(topic);
+        if (it != publishers.end())
+        {
+            // Input was created again
+            it->second.orphaned = false;
+        }
+        else
+        {
+            Publisher publisher;
+            publisher.topic = topic;
+            std::map<std::string, PublishPolicy>::iterator policy = publishPolicies.find(Utils::TrimStart(topic, "/"));
+            if (policy != publishPolicies.end())
+            {
+                publisher.policy = policy->second;
+            }
+            else
+            {
+                publisher.policy = {publishInterval.GetValue(), publishDeadband.GetValue(), ToPublishMode(publishMode.GetValue())};
+            }
+            it = publishers.insert({topic, publisher}).first;
+        }
+        return it->second;
+    }
+    //!
+    //! @brief Replace latest value, count replaced values, which were never published
+    //!
+    void MQTTClient::Enqueue(Publisher& publisher, std::string value, double number, bool numeric)
+    {
+        if (publisher.pending)
+        {
+            Metrics::mqttPublishCoalesced.Increment();
+        }
+        publisher.value = std::move(value);
+        publisher.number = number;
+        publisher.numeric = numeric;
+        publisher.pending = true;
+        // A spilled value is outdated now
+        publisher.spilled = false;
+        // Only values changed while disconnected are queued (and may be dropped), others wait for their interval in the schedule
+        if (!publisher.queued && !publisher.scheduled && state != ConnectionState::eConnected)
+        {
+            Push(publisher);
+        }
+        else
+        {
+            Schedule(publisher);
+        }
+    }
+    //!
+    //! @brief Append publisher to the schedule
+    //!
+    void MQTTClient::Schedule(Publisher& publisher)
+    {
+        if (!publisher.queued && !publisher.scheduled)
+        {
+            schedule.push_back(&publisher);
+            publisher.scheduled = true;
+        }
+    }
+    //!
+    //! @brief Write publisher after the newest entry of the ring buffer
+    //!
+    void MQTTClient::Push(Publisher& publisher)
+    {
+        if (queueCount == queue.size())
+        {
+            Drop(*Pop());
+        }
+        queue[(queueHead + queueCount) % queue.size()] = &publisher;
+        queueCount++;
+        publisher.queued = true;
+        Metrics::mqttQueueDepth.Add(1);
+    }
+    //!
+    //! @brief Take publisher at head of the ring buffer
+    //!
+    MQTTClient::Publisher* MQTTClient::Pop()
+    {
+        Publisher* publisher = queue[queueHead];
+        queueHead = (queueHead + 1) % queue.size();
+        queueCount--;
+        publisher->queued = false;
+        Metrics::mqttQueueDepth.Add(-1);
+        return publisher;
+    }
+    //!
+    //! @brief Spill or discard the value and count it
+    //!
+    void MQTTClient::Drop(Publisher& publisher)
+    {
+        if (publisher.pending && spillToFile && Spill(publisher))
+        {
+            Metrics::mqttQueueSpilled.Increment();
+            publisher.spilled = true;
+            publisher.value.clear();
+            publisher.value.shrink_to_fit();
+        }
+        else if (publisher.pending)
+        {
+            Logger::debug("MQTT queue full, dropping value of " + publisher.topic);
+            Metrics::mqttQueueDropped.Increment();
+        }
+        publisher.pending = false;
+    }
+    //!
+    //! @brief Append record (topic length, value length, numeric flag, number, topic, value) to the spill file
+    //!
+    bool MQTTClient::Spill(Publisher& publisher)
+    {
+        bool success = false;
+        File file = LittleFS.open(spillFile.c_str(), FILE_APPEND);
+        uint16_t topicLength = publisher.topic.size();
+        uint32_t valueLength = publisher.value.size();
+        uint8_t numeric = publisher.numeric;
+        size_t headerLength = sizeof(topicLength) + sizeof(valueLength) + sizeof(numeric) + sizeof(publisher.number);
+        if (file && file.size() + headerLength + topicLength + valueLength <= maxSpillSize)
+        {
+            success = file.write(reinterpret_cast<const uint8_t*>(&topicLength), sizeof(topicLength)) == sizeof(topicLength)
+                && file.write(reinterpret_cast<const uint8_t*>(&valueLength), sizeof(valueLength)) == sizeof(valueLength)
+                && file.write(&numeric, sizeof(numeric)) == sizeof(numeric)
+                && file.write(reinterpret_cast<const uint8_t*>(&publisher.number), sizeof(publisher.number)) == sizeof(publisher.number)
+                && file.write(reinterpret_cast<const uint8_t*>(publisher.topic.data()), topicLength) == topicLength
+                && file.write(reinterpret_cast<const uint8_t*>(publisher.value.data()), valueLength) == valueLength;
+            spillPending = true;
+        }
+        file.close();
+        return success;
+    }
+    //!
+    //! @brief Read all records (later records overwrite earlier ones), remove file and queue values not replaced in the meantime
+    //!
+    //! Values, which don't fit into the queue, are spilled again.
+    //! Topics without publisher belong to inputs, which were deleted (e.g. by a config change before a reboot), their values are dropped.
+    //!
+    void MQTTClient::LoadSpill()
+    {
+        // Records are read into publishers to keep value and number together
+        std::map<std::string, Publisher> values;
+        File file = LittleFS.open(spillFile.c_str(), FILE_READ);
+        if (file)
+        {
+            uint16_t topicLength = 0;
+            uint32_t valueLength = 0;
+            uint8_t numeric = 0;
+            double number = 0;
+            while (file.read(reinterpret_cast<uint8_t*>(&topicLength), sizeof(topicLength)) == sizeof(topicLength)
+                && file.read(reinterpret_cast<uint8_t*>(&valueLength), sizeof(valueLength)) == sizeof(valueLength)
+                && file.read(&numeric, sizeof(numeric)) == sizeof(numeric)
+                && file.read(reinterpret_cast<uint8_t*>(&number), sizeof(number)) == sizeof(number)
+                && valueLength <= maxSpillSize)
+            {
+                std::string topic(topicLength, '\0');
+                std::string value(valueLength, '\0');
+                if (file.read(reinterpret_cast<uint8_t*>(&topic[0]), topicLength) == topicLength
+                    && file.read(reinterpret_cast<uint8_t*>(&value[0]), valueLength) == valueLength)
+                {
+                    Publisher& record = values[topic];
+                    record.value = value;
+                    record.number = number;
+                    record.numeric = numeric != 0;
+                }
+            }
+            file.close();
+            LittleFS.remove(spillFile.c_str());
+        }
+        spillPending = false;
+        Logger::debug("MQTT loaded " + std::to_string(values.size()) + " spilled values");
+        for (std::pair<const std::string, Publisher>& value : values)
+        {
+            std::map<std::string, Publisher>::iterator it = publishers.find(value.first);
+            if (it == publishers.end() || it->second.orphaned)
+            {
+                Logger::debug("MQTT dropping spilled value of deleted input " + value.first);
+                Metrics::mqttQueueDropped.Increment();
+            }
+            else if (it->second.spilled || (!it->second.pending && !it->second.published))
+            {
+                // Values of publishers without newer value (also after reboot) are queued as backlog
+                Publisher& publisher = it->second;
+                publisher.value = value.second.value;
+                publisher.number = value.second.number;
+                publisher.numeric = value.second.numeric;
+                publisher.pending = true;
+                publisher.spilled = false;
+                if (!publisher.queued && !publisher.scheduled)
+                {
+                    Push(publisher);
+                }
+            }
+        }
+    }
+    //!
+    //! @brief Remember published value and time, clear pending
+    //!
+    void MQTTClient::Commit(Publisher& publisher, unsigned long now)
+    {
+        publisher.publishedNumber = publisher.number;
+        publisher.published = true;
+        publisher.pending = false;
+        publisher.lastPublish = now;
+    }
+    //!
+    //! @brief Suppress values inside the deadband, publish pending and periodic values, whose interval elapsed
+    //!
+    bool MQTTClient::Publish(Publisher& publisher, unsigned long now, bool& failed)
+    {
+        bool elapsed = !publisher.published || now - publisher.lastPublish >= publisher.policy.interval;
+        bool periodic = publisher.policy.mode == PublishMode::ePeriodic && publisher.policy.interval > 0;
+        if (elapsed && publisher.pending && !periodic && publisher.published && publisher.numeric
+            && std::fabs(publisher.number - publisher.publishedNumber) < publisher.policy.deadband)
+        {
+            // Change too small, value is published again, if it leaves the deadband
+            Metrics::mqttPublishSuppressed.Increment();
+            publisher.pending = false;
+        }
+        else if (elapsed && (publisher.pending || (periodic && publisher.published)))
+        {
+            // Batched values are committed, when the batch is published
+            bool batched = IsBatched();
+            failed = batched ? !AddToBatch(publisher) : !publish(publisher.topic, publisher.value);
+            if (!failed && !batched)
+            {
+                Commit(publisher, now);
+                if (draining)
+                {
+                    drainTokens -= 1;
+                }
+            }
+        }
+        // Periodic publishers stay until their input is deleted, others until their value is published
+        return publisher.pending || (periodic && !publisher.orphaned);
+    }
+    //!
+    //! @brief Publish pending values (and periodic values), whose interval elapsed and which are outside of the deadband
+    //!
+    //! Scheduled publishers are visited first, then the backlog queued while disconnected.
+    //! Backlog entries, which aren't publishable yet, move to the schedule, so the queue never evicts live values.
+    //! While draining after reconnect, publishes of the backlog are limited by drainRate.
+    //!
+    void MQTTClient::FlushPublishers()
+    {
+        unsigned long now = millis();
+        if (draining && drainRate > 0)
+        {
+            double burst = drainRate / 10.0 > 1 ? drainRate / 10.0 : 1;
+            drainTokens += (now - lastRefill) * drainRate / 1000.0;
+            drainTokens = drainTokens > burst ? burst : drainTokens;
+        }
+        lastRefill = now;
+        if (client.connected() && queueCount == 0 && spillPending)
+        {
+            LoadSpill();
+        }
+        bool failed = false;
+        for (size_t i = 0; i < schedule.size() && !failed && client.connected();)
+        {
+            Publisher& publisher = *schedule[i];
+            if (Publish(publisher, now, failed))
+            {
+                i++;
+            }
+            else
+            {
+                // Order of the schedule doesn't matter, the last entry takes the free slot
+                schedule[i] = schedule.back();
+                schedule.pop_back();
+                publisher.scheduled = false;
+                collectGarbage = collectGarbage || publisher.orphaned;
+            }
+        }
+        size_t count = queueCount;
+        for (size_t i = 0; i < count && !failed && client.connected() && (!draining || drainRate == 0 || drainTokens >= 1); i++)
+        {
+            Publisher& publisher = *Pop();
+            if (Publish(publisher, now, failed))
+            {
+                Schedule(publisher);
+            }
+            else
+            {
+                collectGarbage = collectGarbage || publisher.orphaned;
+            }
+        }
+        FlushBatch();
+        if (draining && queueCount == 0 && !spillPending)
+        {
+            Logger::info("MQTT queue drained");
+            draining = false;
+        }
+    }
+    //!
+    //! @brief Check, if batch topic is configured
+    //!
+    bool MQTTClient::IsBatched()
+    {
+        return !batchTopic.GetValue().empty();
+    }
+    //!
+    //! @brief Serialize as MessagePack or compact JSON
+    //!
+    void MQTTClient::SerializeBatch(std::string& payload)
+    {
+        if (batchFormat.GetValue() == "msgpack")
+        {
+            serializeMsgPack(batch, payload);
+        }
+        else
+        {
+            serializeJson(batch, payload);
+        }
+    }
+    //!
+    //! @brief Add value (numeric values as number) with relative path as key, publish batch without this value first, if it gets too large
+    //!
+    //! Only the new member is measured, the size of the batch is the sum of its members and the size of the map around them:
+    //! braces and separating commas for JSON, a header depending on the number of members for MessagePack.
+    //!
+    bool MQTTClient::AddToBatch(Publisher& publisher)
+    {
+        bool success = true;
+        std::string key = Utils::TrimStart(publisher.topic, "/");
+        JsonDocument member;
+        if (publisher.numeric)
+        {
+            member[key] = publisher.number;
+        }
+        else
+        {
+            member[key] = publisher.value;
+        }
+        size_t count = batchPublishers.size() + 1;
+        size_t memberSize = 0;
+        size_t size = 0;
+        if (batchFormat.GetValue() == "msgpack")
+        {
+            // Map with one member has a header of one byte (fixmap), larger maps use map16/map32
+            memberSize = measureMsgPack(member) - 1;
+            size = batchMembersSize + memberSize + (count < 16 ? 1 : count < 65536 ? 3 : 5);
+        }
+        else
+        {
+            memberSize = measureJson(member) - 2;
+            size = batchMembersSize + memberSize + 2 + (count - 1);
+        }
+        if (size > batchSize && !batchPublishers.empty())
+        {
+            success = FlushBatch();
+            if (success)
+            {
+                success = AddToBatch(publisher);
+            }
+        }
+        else
+        {
+            batch[key] = member[key];
+            batchMembersSize += memberSize;
+            batchPublishers.push_back(&publisher);
+        }
+        return success;
+    }
+    //!
+    //! @brief Publish batch to batch topic and clear it, commit values on success, schedule them again on failure
+    //!
+    bool MQTTClient::FlushBatch()
+    {
+        bool success = true;
+        if (!batchPublishers.empty())
+        {
+            std::string payload;
+            SerializeBatch(payload);
+            success = publish("/" + batchTopic.GetValue(), payload);
+            if (draining)
+            {
+                drainTokens -= 1;
+            }
+            unsigned long now = millis();
+            for (Publisher* publisher : batchPublishers)
+            {
+                if (success)
+                {
+                    Commit(*publisher, now);
+                }
+                else
+                {
+                    Schedule(*publisher);
+                }
+            }
+            Logger::trace("MQTT published batch with " + std::to_string(batchPublishers.size()) + " values");
+            batchPublishers.clear();
+        }
+        batch.clear();
+        batchMembersSize = 0;
+        return success;
+    }
+    //!
+    //! @brief Parse message (ArduinoJson copies the strings into the document) and set each input variable with "/<edgeName>/<key>" as topic
+    //!
+    void MQTTClient::OnBatchMessage(const char* message, size_t length)
+    {
+        JsonDocument doc;
+        DeserializationError error = batchFormat.GetValue() == "msgpack" ? deserializeMsgPack(doc, message, length) : deserializeJson(doc, message, length);
+        if (error)
+        {
+            Logger::warning(std::string("MQTT batch message could not be parsed: ") + error.c_str());
+        }
+        else
+        {
+            std::string prefix = "/" + edgeName + "/";
+            for (JsonPair pair : doc.as<JsonObject>())
+            {
+                const char* key = pair.key().c_str();
+                InputVariable* input = FindInputVariable(key, strlen(key), prefix.c_str(), prefix.size());
+                IModuleOut* variable = input != nullptr ? input->variable : nullptr;
+                if (variable == nullptr)
+                {
+                    Logger::debug(std::string("MQTT batch message contains unknown key ") + key);
+                }
+                else if (pair.value().is<const char*>())
+                {
+                    const char* value = pair.value().as<const char*>();
+                    variable->SetRawValue(value, strlen(value));
+                }
+                else
+                {
+                    // Numbers and booleans are written to a stack buffer in their text representation
+                    char value[32];
+                    size_t valueLength = serializeJson(pair.value(), value, sizeof(value));
+                    variable->SetRawValue(value, valueLength);
+                }
+            }
+        }
     }
     //!
     //! @brief Get input/ouput mqtt variable, generate new if none found with given properties
@@ -80,10 +903,7 @@ namespace ModelController
             if (type == ModuleType::eInput)
             {
                 Logger::trace("Creating new MQTT output variable with type " + DataTypeToString(dataType));
-                IModuleIn* outputVar = nullptr;
                 modulePath = Utils::TrimStart(modulePath, "/");
-                std::string topic = "/" + modulePath;
-                std::function<void(std::string)> pubFn = [&, topic](std::string value) { this->publish(topic, value);};
                 switch (dataType)
                 {
                     case ModuleDataType::eUndefined:
@@ -92,62 +912,62 @@ namespace ModelController
                         break;
                     case ModuleDataType::eDouble:
                         {
-                            child = new ModuleIn<double>(modulePath, pubFn, this);
+                            child = CreatePublisher<double>(modulePath);
                         }
                         break;
                     case ModuleDataType::eFloat:
                         {
-                            child = new ModuleIn<float>(modulePath, pubFn, this);
+                            child = CreatePublisher<float>(modulePath);
                         }
                         break;
                     case ModuleDataType::eString:
                         {
-                            child = new ModuleIn<std::string>(modulePath, pubFn, this);
+                            child = CreatePublisher<std::string>(modulePath);
                         }
                         break;
                     case ModuleDataType::eInt8:
                         {
-                            child = new ModuleIn<int8_t>(modulePath, pubFn, this);
+                            child = CreatePublisher<int8_t>(modulePath);
                         }
                         break;
                     case ModuleDataType::eInt16:
                         {
-                            child = new ModuleIn<int16_t>(modulePath, pubFn, this);
+                            child = CreatePublisher<int16_t>(modulePath);
                         }
                         break;
                     case ModuleDataType::eInt32:
                         {
-                            child = new ModuleIn<int32_t>(modulePath, pubFn, this);
+                            child = CreatePublisher<int32_t>(modulePath);
                         }
                         break;
                     case ModuleDataType::eInt64:
                         {
-                            child = new ModuleIn<int64_t>(modulePath, pubFn, this);
+                            child = CreatePublisher<int64_t>(modulePath);
                         }
                         break;
                     case ModuleDataType::eUInt8:
                         {
-                            child = new ModuleIn<uint8_t>(modulePath, pubFn, this);
+                            child = CreatePublisher<uint8_t>(modulePath);
                         }
                         break;
                     case ModuleDataType::eUInt16:
                         {
-                            child = new ModuleIn<uint16_t>(modulePath, pubFn, this);
+                            child = CreatePublisher<uint16_t>(modulePath);
                         }
                         break;
                     case ModuleDataType::eUInt32:
                         {
-                            child = new ModuleIn<uint32_t>(modulePath, pubFn, this);
+                            child = CreatePublisher<uint32_t>(modulePath);
                         }
                         break;
                     case ModuleDataType::eUInt64:
                         {
-                            child = new ModuleIn<uint64_t>(modulePath, pubFn, this);
+                            child = CreatePublisher<uint64_t>(modulePath);
                         }
                         break;
                     case ModuleDataType::eBool:
                         {
-                            child = new ModuleIn<bool>(modulePath, pubFn, this);
+                            child = CreatePublisher<bool>(modulePath);
                         }
                         break;
                     default:
@@ -253,10 +1073,13 @@ namespace ModelController
                 }
                 if (mqttInput != nullptr)
                 {
-                    // ToDo: Delete from input variables, if destructor called (idea: via events)
-                    Logger::debug("Add MQTT input variable /" + mqttInput->GetName() + " to inputVariables and subscribe");
-                    mqttInputVariables["/" + edgeName + "/" + mqttInput->GetName()] = mqttInput;
-                    subscribe("/" + mqttInput->GetName());
+                    Logger::debug("Add MQTT input variable /" + mqttInput->GetName() + " to inputVariables");
+                    AddInputVariable("/" + edgeName + "/" + mqttInput->GetName(), mqttInput);
+                    // With wildcard subscription messages are routed by the topic table only
+                    if (!wildcardSubscription)
+                    {
+                        subscribe("/" + mqttInput->GetName());
+                    }
                 }
             }
         }
@@ -267,24 +1090,87 @@ namespace ModelController
     //!
     MQTTClient::MQTTClient(std::string name, JsonObject config, BaseModule* parent)
         : BaseContainer(name, config, parent, ModuleType::eNone, ModuleDataType::eNone),
-        client(wifiClient),
-        OnSTAConnected(&WiFiHandler::STAConnected, [&](){reconnect();}),
-        loopListener([&](){ Logger::trace("MQTT loop"); this->client.loop(); }, 0),
+        loopListener([&](){ this->Loop(); }, 0),
         serverHostname("server", config, "raspberrypi", this),
         serverPort("port", config, 1883, this),
-        clientID("clientID", config, "ESP32-" + Utils::GetRandomNumber(18), this)
+        clientID("clientID", config, "ESP32-" + Utils::GetRandomNumber(18), this),
+        wildcardSubscription("wildcard", config, false, this),
+        wildcardFilter("wildcardFilter", config, "#", this),
+        publishInterval("publishInterval", config, 0, this),
+        publishDeadband("deadband", config, 0.0, this),
+        publishMode("publishMode", config, "change", this),
+        queueSize("queueSize", config, 64, this),
+        spillToFile("spill", config, false, this),
+        drainRate("drainRate", config, 20, this),
+        spillFile("/" + name + ".mqtt"),
+        batchTopic("batchTopic", config, "", this),
+        batchFormat("batchFormat", config, "json", this),
+        batchSize("batchSize", config, 1024, this),
+        connection(std::make_shared<Connection>()),
+        client(connection->client),
+        OnSTAConnected(&WiFiHandler::STAConnected, [&](){ if (state == ConnectionState::eDisconnected) { backoff = 0; nextAttempt = millis(); } }),
+        backoffMin("backoffMin", config, 1000, this),
+        backoffMax("backoffMax", config, 60000, this),
+        OnModuleDeleted(&BaseModule::ModuleDeleted, [&](BaseModule*){ collectGarbage = true; }),
+        OnConfigChanged(&ConfigFile::ConfigChanged, [&](std::string){ collectGarbage = true; })
     {
+        if (IsBatched())
+        {
+            // Buffer of PubSubClient is used for in- and outbound messages (including header and topic)
+            client.setBufferSize(batchSize + 128);
+        }
+        queue.resize(queueSize > 0 ? queueSize.GetValue() : 1);
+        if (backoffMin.GetValue() < 1 || backoffMax.GetValue() < backoffMin.GetValue())
+        {
+            Logger::warning("MQTT " + GetPath() + ": backoffMin is raised to 1 ms and backoffMax to backoffMin");
+        }
+        SetEncodings(config);
+        spillPending = spillToFile && LittleFS.exists(spillFile.c_str());
+        for (JsonPair policy : config["policies"].as<JsonObject>())
+        {
+            JsonObject policyConfig = policy.value().as<JsonObject>();
+            publishPolicies[Utils::Trim(policy.key().c_str(), "/")] = {
+                policyConfig["interval"] | publishInterval.GetValue(),
+                policyConfig["deadband"] | publishDeadband.GetValue(),
+                ToPublishMode(policyConfig["mode"] | publishMode.GetValue())
+            };
+        }
         client.setCallback([&](char* topic, byte* message, unsigned int length){this->callback(topic, message, length);});
 
         IModuleOut::ModuleOutCreated(this->GetPath() + "/*");
         IModuleIn::ModuleInCreated(this->GetPath() + "/*");
     }
     //!
+    //! @brief Delete created inputs/outputs and remove queued publishers from queue depth
+    //!
+    //! A running connect task isn't waited for, it only accesses the shared connection and frees it when finished
+    //!
+    MQTTClient::~MQTTClient()
+    {
+        // Inputs and outputs are created by the client, connected modules wait for them to be created again
+        for (BaseModule* port : GetPorts())
+        {
+            delete port;
+        }
+        Metrics::mqttQueueDepth.Add(-static_cast<int32_t>(queueCount));
+    }
+    //!
     //! @brief Calls publish from PubSubClient
     //!
     bool MQTTClient::publish(std::string topic, std::string value)
     {
         Logger::trace("MQTT " + GetPath() + " publish " + value + " to " + topic);
-        return client.publish(("/" + edgeName + topic).c_str(), value.c_str(), true);
+        unsigned long start = micros();
+        bool success = client.publish(("/" + edgeName + topic).c_str(), reinterpret_cast<const uint8_t*>(value.data()), value.size(), true);
+        Metrics::mqttPublishLatency.Observe(micros() - start);
+        if (success)
+        {
+            Metrics::mqttPublished.Increment();
+        }
+        else
+        {
+            Metrics::mqttPublishFailed.Increment();
+        }
+        return success;
     }
 } // namespace ModelController
@@ -0,0 +1,308 @@
+//!
+//! @file Metrics.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Implementation of the metrics
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include "Metrics.hpp"
+#include <Arduino.h>
+#include "EventHandling.hpp"
+#include "LoopEvent.hpp"
+#include "BaseModule.hpp"
+#include "Gain.hpp"
+#include "SequenceProcessor.hpp"
+#include "SequenceEngine.hpp"
+#include "OnboardPWM.hpp"
+#include "MQTTClient.hpp"
+
+namespace ModelController
+{
+    //!
+    //! @brief Upper bounds of the histogram buckets
+    //!
+    constexpr uint32_t Metrics::Histogram::bounds[];
+    //!
+    //! @brief Period between two loops
+    //!
+    Metrics::Histogram Metrics::loopPeriod;
+    //!
+    //! @brief Number of MQTT messages published
+    //!
+    Metrics::Counter Metrics::mqttPublished;
+    //!
+    //! @brief Number of failed MQTT publishes
+    //!
+    Metrics::Counter Metrics::mqttPublishFailed;
+    //!
+    //! @brief Duration of MQTT publishes
+    //!
+    Metrics::Histogram Metrics::mqttPublishLatency;
+    //!
+    //! @brief Number of MQTT values replaced before publishing
+    //!
+    Metrics::Counter Metrics::mqttPublishCoalesced;
+    //!
+    //! @brief Number of MQTT values inside the deadband
+    //!
+    Metrics::Counter Metrics::mqttPublishSuppressed;
+    //!
+    //! @brief Number of topics in the MQTT outbound queues
+    //!
+    Metrics::Gauge Metrics::mqttQueueDepth;
+    //!
+    //! @brief Number of values dropped from the MQTT outbound queues
+    //!
+    Metrics::Counter Metrics::mqttQueueDropped;
+    //!
+    //! @brief Number of values spilled from the MQTT outbound queues
+    //!
+    Metrics::Counter Metrics::mqttQueueSpilled;
+    //!
+    //! @brief Number of MQTT messages received
+    //!
+    Metrics::Counter Metrics::mqttReceived;
+    //!
+    //! @brief Duration of handling received MQTT messages
+    //!
+    Metrics::Histogram Metrics::mqttReceiveLatency;
+    //!
+    //! @brief Number of MQTT connection attempts
+    //!
+    Metrics::Counter Metrics::mqttConnectAttempts;
+    //!
+    //! @brief Number of failed MQTT connection attempts
+    //!
+    Metrics::Counter Metrics::mqttConnectFailed;
+    //!
+    //! @brief Duration of MQTT connection attempts
+    //!
+    Metrics::Histogram Metrics::mqttConnectLatency;
+    //!
+    //! @brief Time until MQTT is ready after (re)connect
+    //!
+    Metrics::Gauge Metrics::mqttReadyTime;
+    //!
+    //! @brief Time until WiFi is connected after (re)connect
+    //!
+    Metrics::Gauge Metrics::wifiConnectTime;
+    //!
+    //! @brief Number of WiFi connection losses
+    //!
+    Metrics::Counter Metrics::wifiDisconnects;
+    //!
+    //! @brief Number of WiFi connection attempts
+    //!
+    Metrics::Counter Metrics::wifiConnectAttempts;
+    //!
+    //! @brief Number of failed attempts to the cached access point
+    //!
+    Metrics::Counter Metrics::wifiFastConnectFailed;
+    //!
+    //! @brief Duration of the last successful WiFi connection attempt
+    //!
+    Metrics::Gauge Metrics::wifiAttemptTime;
+    //!
+    //! @brief Number of sequence processor evaluations
+    //!
+    Metrics::Counter Metrics::sequenceEvaluations;
+    //!
+    //! @brief Number of config saves
+    //!
+    Metrics::Counter Metrics::configSaves;
+    //!
+    //! @brief Duration of config saves
+    //!
+    Metrics::Histogram Metrics::configSaveDuration;
+    //!
+    //! @brief Construct a new counter with value zero
+    //!
+    Metrics::Counter::Counter()
+        : value(0)
+    {
+    }
+    //!
+    //! @brief Add increment without locking
+    //!
+    void Metrics::Counter::Increment(uint32_t increment)
+    {
+        value.fetch_add(increment, std::memory_order_relaxed);
+    }
+    //!
+    //! @brief Returns actual value
+    //!
+    uint64_t Metrics::Counter::Get() const
+    {
+        return value.load(std::memory_order_relaxed);
+    }
+    //!
+    //! @brief Construct a new gauge with value zero
+    //!
+    Metrics::Gauge::Gauge()
+        : value(0)
+    {
+    }
+    //!
+    //! @brief Store value without locking
+    //!
+    void Metrics::Gauge::Set(uint32_t value)
+    {
+        this->value.store(value, std::memory_order_relaxed);
+    }
+    //!
+    //! @brief Add delta without locking (wraps like the unsigned value)
+    //!
+    void Metrics::Gauge::Add(int32_t delta)
+    {
+        value.fetch_add(static_cast<uint32_t>(delta), std::memory_order_relaxed);
+    }
+    //!
+    //! @brief Returns actual value
+    //!
+    uint32_t Metrics::Gauge::Get() const
+    {
+        return value.load(std::memory_order_relaxed);
+    }
+    //!
+    //! @brief Construct a new histogram with empty buckets
+    //!
+    Metrics::Histogram::Histogram()
+        : sum(0),
+        count(0)
+    {
+        for (std::atomic<uint64_t>& bucket : buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+    //!
+    //! @brief Find bucket of the value and count it without locking
+    //!
+    void Metrics::Histogram::Observe(uint32_t value)
+    {
+        size_t bucket = 0;
+        while (bucket < numberBuckets && value > bounds[bucket])
+        {
+            bucket++;
+        }
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+    //!
+    //! @brief Write cumulative buckets, sum and count, bounds and sum converted to seconds
+    //!
+    std::string Metrics::Histogram::Serialize(std::string name, std::string help) const
+    {
+        std::string text = "# HELP " + name + " " + help + "\n# TYPE " + name + " histogram\n";
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i <= numberBuckets; i++)
+        {
+            cumulative += buckets[i].load(std::memory_order_relaxed);
+            std::string bound = i < numberBuckets ? ToSeconds(bounds[i]) : "+Inf";
+            text += name + "_bucket{le=\"" + bound + "\"} " + std::to_string(cumulative) + "\n";
+        }
+        text += name + "_sum " + ToSeconds(sum.load(std::memory_order_relaxed)) + "\n";
+        text += name + "_count " + std::to_string(count.load(std::memory_order_relaxed)) + "\n";
+        return text;
+    }
+    //!
+    //! @brief Write help, type and value
+    //!
+    std::string Metrics::Serialize(std::string name, std::string help, std::string type, uint64_t value)
+    {
+        return "# HELP " + name + " " + help + "\n# TYPE " + name + " " + type + "\n" + name + " " + std::to_string(value) + "\n";
+    }
+    //!
+    //! @brief Write whole seconds and the six digit fraction, trailing zeros of the fraction are removed
+    //!
+    std::string Metrics::ToSeconds(uint64_t microseconds)
+    {
+        std::string text = std::to_string(microseconds / 1000000);
+        std::string fraction = std::to_string(microseconds % 1000000 + 1000000).substr(1);
+        size_t end = fraction.find_last_not_of('0');
+        if (end != std::string::npos)
+        {
+            text += "." + fraction.substr(0, end + 1);
+        }
+        return text;
+    }
+    //!
+    //! @brief Collect counters, histograms, event statistics, heap and module counts
+    //!
+    std::string Metrics::Serialize()
+    {
+        std::string text;
+        text += loopPeriod.Serialize("edge_loop_period_seconds", "Time between two loops");
+        text += Serialize("edge_loop_listeners", "Number of loop listeners", "gauge", LoopEvent::GetListenerCount());
+
+        text += "# HELP edge_event_raised_total Number of times an event was raised, unnamed events (e.g. of modules) are summed up\n# TYPE edge_event_raised_total counter\n";
+        uint64_t unnamedRaises = 0;
+        for (EventBase* event = EventBase::GetFirst(); event != nullptr; event = event->GetNext())
+        {
+            if (event->GetName() != nullptr)
+            {
+                text += std::string("edge_event_raised_total{event=\"") + event->GetName() + "\"} " + std::to_string(event->GetRaiseCount()) + "\n";
+            }
+            else
+            {
+                unnamedRaises += event->GetRaiseCount();
+            }
+        }
+        text += "edge_event_raised_total{event=\"unnamed\"} " + std::to_string(unnamedRaises) + "\n";
+
+        text += Serialize("edge_mqtt_published_total", "MQTT messages published", "counter", mqttPublished.Get());
+        text += Serialize("edge_mqtt_publish_failed_total", "MQTT messages which could not be published", "counter", mqttPublishFailed.Get());
+        text += mqttPublishLatency.Serialize("edge_mqtt_publish_seconds", "Duration of publishing a MQTT message");
+        text += Serialize("edge_mqtt_publish_coalesced_total", "MQTT values replaced by a newer value before publishing", "counter", mqttPublishCoalesced.Get());
+        text += Serialize("edge_mqtt_publish_suppressed_total", "MQTT values not published because of the deadband", "counter", mqttPublishSuppressed.Get());
+        text += Serialize("edge_mqtt_queue_depth", "Topics waiting in the MQTT outbound queues", "gauge", mqttQueueDepth.Get());
+        text += Serialize("edge_mqtt_queue_dropped_total", "MQTT values dropped because the outbound queue was full", "counter", mqttQueueDropped.Get());
+        text += Serialize("edge_mqtt_queue_spilled_total", "MQTT values moved from the full outbound queue to LittleFS", "counter", mqttQueueSpilled.Get());
+        text += Serialize("edge_mqtt_received_total", "MQTT messages received", "counter", mqttReceived.Get());
+        text += mqttReceiveLatency.Serialize("edge_mqtt_receive_seconds", "Duration of handling a received MQTT message");
+        text += Serialize("edge_mqtt_connect_attempts_total", "MQTT connection attempts", "counter", mqttConnectAttempts.Get());
+        text += Serialize("edge_mqtt_connect_failed_total", "Failed MQTT connection attempts", "counter", mqttConnectFailed.Get());
+        text += mqttConnectLatency.Serialize("edge_mqtt_connect_seconds", "Duration of a MQTT connection attempt");
+        text += Serialize("edge_mqtt_ready_milliseconds", "Time from the last connection attempt until all subscriptions were sent", "gauge", mqttReadyTime.Get());
+
+        text += Serialize("edge_wifi_connect_milliseconds", "Time from starting or losing the WiFi connection until the station got an IP", "gauge", wifiConnectTime.Get());
+        text += Serialize("edge_wifi_disconnects_total", "Number of times the WiFi station lost the connection", "counter", wifiDisconnects.Get());
+        text += Serialize("edge_wifi_connect_attempts_total", "WiFi connection attempts", "counter", wifiConnectAttempts.Get());
+        text += Serialize("edge_wifi_fast_connect_failed_total", "WiFi connection attempts to the cached access point which timed out", "counter", wifiFastConnectFailed.Get());
+        text += Serialize("edge_wifi_attempt_milliseconds", "Duration of the last successful WiFi connection attempt", "gauge", wifiAttemptTime.Get());
+
+        text += Serialize("edge_sequence_evaluations_total", "Number of times a sequence processor calculated its output", "counter", sequenceEvaluations.Get());
+        text += Serialize("edge_sequences", "Number of distinct sequences shared by the sequence processors", "gauge", Sequence::GetCacheSize());
+        text += Serialize("edge_sequence_batch_lanes", "Number of sequence processors evaluated by the batch engine", "gauge", SequenceEngine::GetSize());
+
+        text += Serialize("edge_config_saves_total", "Number of times the config was saved", "counter", configSaves.Get());
+        text += configSaveDuration.Serialize("edge_config_save_seconds", "Duration of saving the config");
+
+        text += Serialize("edge_heap_free_bytes", "Free heap", "gauge", ESP.getFreeHeap());
+        text += Serialize("edge_heap_min_free_bytes", "Minimum free heap since boot", "gauge", ESP.getMinFreeHeap());
+        text += Serialize("edge_heap_largest_block_bytes", "Largest allocatable heap block", "gauge", ESP.getMaxAllocHeap());
+
+        text += "# HELP edge_modules Number of modules by type\n# TYPE edge_modules gauge\n";
+        for (const char* type : {Gain::type, SequenceProcessor::type, OnboardPWM::type, MQTTClient::type})
+        {
+            text += std::string("edge_modules{type=\"") + type + "\"} " + std::to_string(BaseModule::GetContainers("", type).size()) + "\n";
+        }
+        uint32_t inputs = 0;
+        uint32_t outputs = 0;
+        for (BaseModule* port : BaseModule::GetPorts(""))
+        {
+            if (port->GetType() == BaseModule::ModuleType::eInput)
+            {
+                inputs++;
+            }
+            else
+            {
+                outputs++;
+            }
+        }
+        text += "edge_modules{type=\"input\"} " + std::to_string(inputs) + "\n";
+        text += "edge_modules{type=\"output\"} " + std::to_string(outputs) + "\n";
+        return text;
+    }
+} // namespace ModelController
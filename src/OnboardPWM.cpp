@@ -7,6 +7,8 @@
 //!
 #include "OnboardPWM.hpp"
 #include <sstream>
+#include <cmath>
+#include <algorithm>
 #include "Logger.hpp"
 
 namespace ModelController
@@ -40,6 +42,17 @@ namespace ModelController
         Logger::trace("Frequency: " + std::to_string(frequency));
         this->resolution = resolution;
         this->frequency = frequency;
+        // pow() is only called here, SetValue interpolates the table
+        gammaTable.clear();
+        if (gamma.GetValue() != 1.0 && gamma.GetValue() > 0)
+        {
+            uint32_t maxDuty = (1UL << resolution) - 1;
+            gammaTable.resize(gammaIntervals + 1);
+            for (size_t i = 0; i <= gammaIntervals; i++)
+            {
+                gammaTable[i] = std::lround(std::pow(static_cast<double>(i) / gammaIntervals, gamma.GetValue()) * maxDuty);
+            }
+        }
         if (channel >= 0)
         {
             ledcSetup(channel, frequency, resolution);
@@ -58,7 +71,18 @@ namespace ModelController
     {
         Logger::trace("Set value " + std::to_string(value) + " to " + GetPath());
         bool retVal = false;
-        uint32_t duty = value / 100 * (pow(2, resolution.GetValue()) - 1);
+        double position = std::min(std::max(value, 0.0), 100.0) / 100;
+        uint32_t duty = 0;
+        if (gammaTable.empty())
+        {
+            duty = position * ((1UL << resolution.GetValue()) - 1);
+        }
+        else
+        {
+            size_t index = std::min(static_cast<size_t>(position * gammaIntervals), gammaIntervals - 1);
+            double fraction = position * gammaIntervals - index;
+            duty = gammaTable[index] + (gammaTable[index + 1] - gammaTable[index]) * fraction;
+        }
         if (channel >= 0)
         {
             ledcWrite(channel, duty);
@@ -73,14 +97,15 @@ namespace ModelController
         : BaseContainer(name, config, parent),
         in("in", config, [&](double value) { this->SetValue(value); }, this),
         resolution("resolution", config, 16, this),
-        frequency("frequency", config, 500, this)
+        frequency("frequency", config, 500, this),
+        gamma("gamma", config, 1.0, this)
     {
         Logger::trace("OnboardPWM::OnboardPWM(" + name + ", jsonConfig,  " + (parent == nullptr ? "NULL" : parent->GetPath()) + ")");
 
         channel = GetFreeChannel();
         if (channel >= 0)
         {
-            usedChannels.push_back(channel);
+            usedChannels.push_back(static_cast<uint8_t>(channel));
         }
         JsonVariant jPins = config["pin"];
         if (jPins.is<JsonArray>())
@@ -128,6 +153,7 @@ namespace ModelController
         config << ", \"type\": \"" << type << "\"";
         config << ", \"resolution\": " << resolution;
         config << ", \"frequency\": " << frequency;
+        config << ", \"gamma\": " << gamma;
         return config.str();
     }
 } // namespace ModelController
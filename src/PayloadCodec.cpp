@@ -0,0 +1,167 @@
+//!
+//! @file PayloadCodec.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Implementation of the payload codec
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include "PayloadCodec.hpp"
+#include <cmath>
+
+namespace ModelController
+{
+    //!
+    //! @brief Compare name with names used in config
+    //!
+    bool PayloadCodec::ToEncoding(std::string name, Encoding& encoding)
+    {
+        bool success = true;
+        if (name == "text")
+        {
+            encoding = Encoding::eText;
+        }
+        else if (name == "raw")
+        {
+            encoding = Encoding::eRaw;
+        }
+        else if (name == "cbor")
+        {
+            encoding = Encoding::eCbor;
+        }
+        else
+        {
+            success = false;
+        }
+        return success;
+    }
+    //!
+    //! @brief Write major type with argument in the additional information (< 24) or in the following 1, 2, 4 or 8 bytes (big-endian)
+    //!
+    void PayloadCodec::EncodeCborHead(uint8_t majorType, uint64_t argument, std::string& payload)
+    {
+        size_t bytes = 0;
+        uint8_t additional = 0;
+        if (argument < 24)
+        {
+            additional = argument;
+        }
+        else if (argument <= UINT8_MAX)
+        {
+            additional = 24;
+            bytes = 1;
+        }
+        else if (argument <= UINT16_MAX)
+        {
+            additional = 25;
+            bytes = 2;
+        }
+        else if (argument <= UINT32_MAX)
+        {
+            additional = 26;
+            bytes = 4;
+        }
+        else
+        {
+            additional = 27;
+            bytes = 8;
+        }
+        payload.push_back(static_cast<char>(majorType << 5 | additional));
+        for (size_t i = bytes; i > 0; i--)
+        {
+            payload.push_back(static_cast<char>(argument >> (8 * (i - 1))));
+        }
+    }
+    //!
+    //! @brief Write float as simple value 26 (single) or 27 (double) with big-endian bits
+    //!
+    void PayloadCodec::EncodeCborFloat(double value, bool single, std::string& payload)
+    {
+        uint64_t bits = 0;
+        size_t bytes = single ? 4 : 8;
+        if (single)
+        {
+            float singleValue = value;
+            uint32_t singleBits = 0;
+            memcpy(&singleBits, &singleValue, sizeof(singleBits));
+            bits = singleBits;
+        }
+        else
+        {
+            memcpy(&bits, &value, sizeof(bits));
+        }
+        payload.push_back(static_cast<char>(single ? 0xFA : 0xFB));
+        for (size_t i = bytes; i > 0; i--)
+        {
+            payload.push_back(static_cast<char>(bits >> (8 * (i - 1))));
+        }
+    }
+    //!
+    //! @brief Read head and argument, strings point into the payload
+    //!
+    bool PayloadCodec::DecodeCbor(const uint8_t* data, size_t length, CborItem& item)
+    {
+        bool success = length > 0;
+        uint8_t majorType = success ? data[0] >> 5 : 0;
+        uint8_t additional = success ? data[0] & 0x1F : 0;
+        size_t bytes = additional < 24 ? 0 : additional <= 27 ? 1 << (additional - 24) : 0;
+        // Indefinite lengths and reserved values are not supported
+        success = success && additional < 28 && length >= 1 + bytes;
+        uint64_t argument = additional < 24 ? additional : 0;
+        for (size_t i = 1; success && i <= bytes; i++)
+        {
+            argument = argument << 8 | data[i];
+        }
+        size_t headLength = 1 + bytes;
+        if (success && majorType <= 1)
+        {
+            item.type = majorType == 0 ? CborItem::Type::eUnsigned : CborItem::Type::eNegative;
+            item.integer = argument;
+            success = length == headLength;
+        }
+        else if (success && (majorType == 2 || majorType == 3))
+        {
+            item.type = CborItem::Type::eString;
+            item.integer = argument;
+            item.string = reinterpret_cast<const char*>(data + headLength);
+            success = length - headLength == argument;
+        }
+        else if (success && majorType == 7 && (additional == 20 || additional == 21))
+        {
+            item.type = CborItem::Type::eBool;
+            item.integer = additional == 21;
+            success = length == headLength;
+        }
+        else if (success && majorType == 7 && additional == 25)
+        {
+            // Half precision: sign, 5 bit exponent, 10 bit mantissa
+            int exponent = (argument >> 10) & 0x1F;
+            double mantissa = argument & 0x3FF;
+            double value = exponent == 0 ? std::ldexp(mantissa, -24)
+                : exponent == 31 ? (mantissa == 0 ? INFINITY : NAN)
+                : std::ldexp(mantissa + 1024, exponent - 25);
+            item.type = CborItem::Type::eFloat;
+            item.number = (argument & 0x8000) ? -value : value;
+            success = length == headLength;
+        }
+        else if (success && majorType == 7 && additional == 26)
+        {
+            uint32_t singleBits = argument;
+            float singleValue = 0;
+            memcpy(&singleValue, &singleBits, sizeof(singleValue));
+            item.type = CborItem::Type::eFloat;
+            item.number = singleValue;
+            success = length == headLength;
+        }
+        else if (success && majorType == 7 && additional == 27)
+        {
+            item.type = CborItem::Type::eFloat;
+            memcpy(&item.number, &argument, sizeof(item.number));
+            success = length == headLength;
+        }
+        else
+        {
+            success = false;
+        }
+        return success;
+    }
+} // namespace ModelController
@@ -10,38 +10,181 @@
 #include <Arduino.h>
 #include <string>
 #include <sstream>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstring>
+#include <charconv>
 
 namespace ModelController
 {
     //!
-    //! @brief Get actual value depending on relative time
+    //! @brief Reserve contiguous entries for the children, compile them and sum up their start times
     //!
-    double Sequence::GetValueRelativeTime(long time)
+    //! Children after an infinite child are never reached and not compiled. Children running once with a single
+    //! item (e.g. the braces of "{{100;50}{0;50}}") are compiled as their item, so the cursor steps between the elements.
+    //!
+    void Sequence::Compile(std::vector<Segment>& segments, size_t index) const
     {
-        double value = 0;
-        long timeCounter = 0;
-
-        if (GetDuration(false) > 0)
+        size_t first = segments.size();
+        segments.resize(first + subsequences.size());
+        int64_t start = 0;
+        uint32_t count = 0;
+        for (size_t i = 0; i < subsequences.size() && start >= 0; i++)
         {
-            time = time % GetDuration(false);
+            const Sequence* child = subsequences[i];
+            while (child->repeat == 1 && child->subsequences.size() == 1)
+            {
+                child = child->subsequences[0];
+            }
+            child->Compile(segments, first + i);
+            segments[first + i].start = start;
+            start = segments[first + i].duration < 0 ? -1 : start + segments[first + i].duration;
+            count++;
         }
-        //!
-        //! @brief Get value from active subsequence
-        //!
-        for (int i = 0; i < subsequences.size() && timeCounter < time; i++)
+        // Reference is taken after compiling the children, as they resize the table
+        Segment& segment = segments[index];
+        segment.first = first;
+        segment.count = count;
+        segment.period = start;
+        segment.duration = repeat < 0 || start < 0 ? -1 : start * repeat;
+    }
+    //!
+    //! @brief Compare name with names used in config
+    //!
+    bool Sequence::ToPrecision(std::string name, Precision& precision)
+    {
+        bool success = true;
+        if (name == "double")
         {
-
-            if (timeCounter + subsequences[i]->GetDuration() > time || subsequences[i]->GetDuration() < 0)
+            precision = Precision::eDouble;
+        }
+        else if (name == "float")
+        {
+            precision = Precision::eFloat;
+        }
+        else if (name == "fixed")
+        {
+            precision = Precision::eFixed;
+        }
+        else
+        {
+            success = false;
+        }
+        return success;
+    }
+    //!
+    //! @brief Compare name with the names of the curves
+    //!
+    bool Sequence::ToCurve(std::string name, Curve& curve)
+    {
+        bool success = false;
+        for (size_t i = 0; i < curveCount && !success; i++)
+        {
+            if (name == curveNames[i])
             {
-                value = subsequences[i]->GetValueRelativeTime(time - timeCounter);
-                timeCounter = time;
+                curve = static_cast<Curve>(i);
+                success = true;
             }
-            else
+        }
+        return success;
+    }
+    //!
+    //! @brief Look up the name of the curve
+    //!
+    const char* Sequence::CurveToString(Curve curve)
+    {
+        return curveNames[static_cast<size_t>(curve)];
+    }
+    //!
+    //! @brief Names of the curves
+    //!
+    constexpr const char* Sequence::curveNames[];
+    //!
+    //! @brief Tables of the curves (empty until a ramp with the curve is compiled)
+    //!
+    std::vector<int32_t> Sequence::curveTables[curveCount];
+    //!
+    //! @brief Maximum slopes of the curves (linear is known without table)
+    //!
+    int32_t Sequence::curveSlopes[curveCount] = {1 << fixedBits};
+    //!
+    //! @brief Calculate the curve at the borders of the intervals once, pow() is only used here
+    //!
+    void Sequence::PrepareCurve(Curve curve)
+    {
+        std::vector<int32_t>& table = curveTables[static_cast<size_t>(curve)];
+        if (curve != Curve::eLinear && table.empty())
+        {
+            constexpr size_t intervals = 1 << curveBits;
+            table.resize(intervals + 1);
+            int32_t slope = 0;
+            for (size_t i = 0; i <= intervals; i++)
             {
-                timeCounter += subsequences[i]->GetDuration();
+                double x = static_cast<double>(i) / intervals;
+                double y = x;
+                if (curve == Curve::eEaseIn)
+                {
+                    y = x * x;
+                }
+                else if (curve == Curve::eEaseOut)
+                {
+                    y = 1 - (1 - x) * (1 - x);
+                }
+                else if (curve == Curve::eEaseInOut)
+                {
+                    y = x * x * (3 - 2 * x);
+                }
+                else if (curve == Curve::eExponential)
+                {
+                    y = (std::pow(64.0, x) - 1) / 63;
+                }
+                table[i] = ToFixed(y);
+                slope = i > 0 ? std::max(slope, (table[i] - table[i - 1]) * static_cast<int32_t>(intervals)) : slope;
             }
+            curveSlopes[static_cast<size_t>(curve)] = slope;
         }
-        return value;
+    }
+    //!
+    //! @brief Scale the time to fixed point, ramps longer than 2^47 us lose the lower bits of the period
+    //!
+    uint32_t Sequence::GetProgress(uint64_t relativeTime, uint64_t period)
+    {
+        constexpr uint64_t maxProgress = (1 << fixedBits) - 1;
+        uint64_t progress = period < (1ULL << 47) ? (relativeTime << fixedBits) / period : relativeTime / (period >> fixedBits);
+        return std::min(progress, maxProgress);
+    }
+    //!
+    //! @brief Interpolate linearly between the borders of the interval containing the progress
+    //!
+    int32_t Sequence::Shape(Curve curve, uint32_t progress)
+    {
+        constexpr int fractionBits = fixedBits - curveBits;
+        const int32_t* table = curveTables[static_cast<size_t>(curve)].data();
+        uint32_t index = progress >> fractionBits;
+        int32_t fraction = progress & ((1 << fractionBits) - 1);
+        return table[index] + ((table[index + 1] - table[index]) * fraction >> fractionBits);
+    }
+    //!
+    //! @brief Scale by 2^fixedBits, round and saturate
+    //!
+    int32_t Sequence::ToFixed(double value)
+    {
+        double scaled = std::round(std::ldexp(value, fixedBits));
+        int32_t fixed = 0;
+        if (scaled >= std::numeric_limits<int32_t>::max())
+        {
+            fixed = std::numeric_limits<int32_t>::max();
+        }
+        else if (scaled <= std::numeric_limits<int32_t>::min())
+        {
+            fixed = std::numeric_limits<int32_t>::min();
+        }
+        else
+        {
+            fixed = static_cast<int32_t>(scaled);
+        }
+        return fixed;
     }
     //!
     //! @brief Construct a new Sequence object
@@ -52,85 +195,377 @@ namespace ModelController
 
     }
     //!
-    //! @brief Construct a new Sequence object
+    //! @brief Parse and compile the sequence, an invalid sequence string results in an empty sequence
     //!
-    Sequence::Sequence(std::string sequenceString)
+    Sequence::Sequence(std::string_view sequenceString)
+        : repeat(1)
     {
-        std::string repeat = sequenceString.substr(0, sequenceString.find("{"));
-        if (repeat == "inf")
+        std::string error;
+        if (!Parse(sequenceString, this, error))
         {
-            this->repeat = -1;
+            for (Sequence* subsequence : subsequences)
+            {
+                delete subsequence;
+            }
+            subsequences.clear();
+            repeat = 1;
         }
-        else if(repeat == "")
+        segments.resize(1);
+        Compile(segments, 0);
+    }
+    //!
+    //! @brief Parsed sequences by canonical sequence string
+    //!
+    std::map<std::string, std::weak_ptr<const Sequence>, std::less<>> Sequence::cache;
+    //!
+    //! @brief Look up the string as given (usually canonical already), else parse and look up the canonical string
+    //!
+    std::shared_ptr<const Sequence> Sequence::Get(std::string_view sequenceString)
+    {
+        std::shared_ptr<const Sequence> sequence;
+        std::map<std::string, std::weak_ptr<const Sequence>, std::less<>>::iterator it = cache.find(sequenceString);
+        if (it != cache.end())
         {
-            this->repeat = 1;
+            sequence = it->second.lock();
         }
-        else
+        if (sequence == nullptr)
+        {
+            std::shared_ptr<const Sequence> parsed = std::make_shared<const Sequence>(sequenceString);
+            std::weak_ptr<const Sequence>& entry = cache[parsed->GetSequenceString()];
+            sequence = entry.lock();
+            if (sequence == nullptr)
+            {
+                sequence = parsed;
+                entry = sequence;
+            }
+            // Remove entries of sequences no longer in use
+            for (it = cache.begin(); it != cache.end();)
+            {
+                it = it->second.expired() ? cache.erase(it) : std::next(it);
+            }
+        }
+        return sequence;
+    }
+    //!
+    //! @brief Count entries of sequences in use
+    //!
+    size_t Sequence::GetCacheSize()
+    {
+        size_t size = 0;
+        for (const std::pair<const std::string, std::weak_ptr<const Sequence>>& entry : cache)
         {
-            this->repeat = atoi(repeat.c_str());
+            size += entry.second.expired() ? 0 : 1;
         }
-        std::string subsequenceString = sequenceString.substr(sequenceString.find("{") + 1, sequenceString.find_last_of("}") - sequenceString.find("{") - 1);
-        int deep = 0;
-        int index = 0;
-        int start = index;
-
-        while (index < subsequenceString.length())
+        return size;
+    }
+    //!
+    //! @brief Parse without building the tree
+    //!
+    std::string Sequence::Validate(std::string_view sequenceString)
+    {
+        std::string error;
+        Parse(sequenceString, nullptr, error);
+        return error;
+    }
+    //!
+    //! @brief Parse the root sequence and check that only spaces follow
+    //!
+    bool Sequence::Parse(std::string_view text, Sequence* sequence, std::string& error)
+    {
+        size_t position = 0;
+        int64_t duration = -1;
+        bool success = ParseSequence(text, position, sequence, 0, duration, error);
+        SkipSpaces(text, position);
+        if (success && position < text.size())
+        {
+            error = Error(position, "unexpected character after sequence");
+            success = false;
+        }
+        return success;
+    }
+    //!
+    //! @brief Parse repetitions, opening bracket, items until closing bracket
+    //!
+    //! Durations of the items are summed up and multiplied by the repetitions, a sequence whose duration exceeds int64 is rejected
+    //!
+    bool Sequence::ParseSequence(std::string_view text, size_t& position, Sequence* sequence, int depth, int64_t& duration, std::string& error)
+    {
+        bool success = depth < maxDepth;
+        long repeat = 1;
+        SkipSpaces(text, position);
+        size_t sequenceStart = position;
+        // Duration of one iteration, -1 after an infinite item
+        int64_t period = 0;
+        if (!success)
+        {
+            error = Error(position, "sequences nested too deep");
+        }
+        else if (text.compare(position, 3, "inf") == 0)
+        {
+            repeat = -1;
+            position += 3;
+        }
+        else if (position < text.size() && text[position] >= '0' && text[position] <= '9')
+        {
+            size_t start = position;
+            success = ParseInteger(text, position, repeat) && repeat <= std::numeric_limits<int>::max();
+            if (!success)
+            {
+                error = Error(start, "number of repetitions out of range");
+            }
+        }
+        SkipSpaces(text, position);
+        if (success && (position >= text.size() || text[position] != '{'))
+        {
+            error = Error(position, "expected '{'");
+            success = false;
+        }
+        if (success)
         {
-            if (subsequenceString[index] == '{')
+            position++;
+            if (sequence != nullptr)
             {
-                deep++;
+                sequence->repeat = repeat;
             }
-            else if (subsequenceString[index] == '}' || index == subsequenceString.length() - 1)
+        }
+        SkipSpaces(text, position);
+        while (success && position < text.size() && text[position] != '}')
+        {
+            // Items starting with '{', 'inf{' or digits followed by '{' are sequences, others are elements
+            size_t next = position;
+            if (text.compare(next, 3, "inf") == 0)
             {
-                if (--deep <= 0)
+                next += 3;
+            }
+            while (next < text.size() && text[next] >= '0' && text[next] <= '9')
+            {
+                next++;
+            }
+            SkipSpaces(text, next);
+            size_t itemStart = position;
+            int64_t itemDuration = -1;
+            if (next < text.size() && text[next] == '{')
+            {
+                Sequence* subsequence = sequence != nullptr ? new Sequence() : nullptr;
+                if (subsequence != nullptr)
                 {
-                    std::string subsubsequenceString = subsequenceString.substr(start, index - start + 1);
-                    if (subsubsequenceString.find("{") != std::string::npos)
-                    {
-                        subsequences.push_back(new Sequence(subsubsequenceString));
-                    }
-                    else
-                    {
-                        std::string startStr = "";
-                        std::string timeStr = "";
-                        std::string endStr = "";
-                        if (subsubsequenceString.find(";") != std::string::npos)
-                        {
-                            startStr = subsubsequenceString.substr(0, subsubsequenceString.find(";"));
-                            subsubsequenceString = subsubsequenceString.substr(subsubsequenceString.find(";") + 1, subsubsequenceString.length() - subsubsequenceString.find(";"));
-                            if (subsubsequenceString.find(";") != std::string::npos)
-                            {
-                                timeStr = subsubsequenceString.substr(0, subsubsequenceString.find(";"));
-                                endStr = subsubsequenceString.substr(subsubsequenceString.find(";") + 1, subsubsequenceString.length() - subsubsequenceString.find(";"));
-                            }
-                            else
-                            {
-                                timeStr = subsubsequenceString;
-                            }
-                        }
-                        else
-                        {
-                            startStr = subsubsequenceString;
-                        }
-                        if (endStr != "")
-                        {
-                            subsequences.push_back(new SequenceElement(std::atof(startStr.c_str()), std::atol(timeStr.c_str()), std::atof(endStr.c_str())));
-                        }
-                        else if (timeStr != "")
-                        {
-                            subsequences.push_back(new SequenceElement(std::atof(startStr.c_str()), std::atol(timeStr.c_str())));
-                        }
-                        else if (startStr != "")
-                        {
-                            subsequences.push_back(new SequenceElement(std::atof(startStr.c_str())));
-                        }
-
-                    }
-                    start = index + 1;
+                    sequence->subsequences.push_back(subsequence);
                 }
+                success = ParseSequence(text, position, subsequence, depth + 1, itemDuration, error);
+            }
+            else
+            {
+                success = ParseElement(text, position, sequence, itemDuration, error);
+            }
+            if (success && period >= 0)
+            {
+                if (itemDuration < 0)
+                {
+                    period = -1;
+                }
+                else if (itemDuration > std::numeric_limits<int64_t>::max() - period)
+                {
+                    error = Error(itemStart, "sequence too long");
+                    success = false;
+                }
+                else
+                {
+                    period += itemDuration;
+                }
+            }
+            SkipSpaces(text, position);
+        }
+        if (success && position >= text.size())
+        {
+            error = Error(position, "expected '}'");
+            success = false;
+        }
+        if (success && repeat >= 0 && period > 0 && repeat > std::numeric_limits<int64_t>::max() / period)
+        {
+            error = Error(sequenceStart, "sequence too long");
+            success = false;
+        }
+        if (success)
+        {
+            position++;
+            duration = repeat < 0 || period < 0 ? -1 : period * repeat;
+        }
+        return success;
+    }
+    //!
+    //! @brief Parse start value, optional duration and optional end value separated by ';'
+    //!
+    //! Elements without duration last forever
+    //!
+    bool Sequence::ParseElement(std::string_view text, size_t& position, Sequence* sequence, int64_t& elementDuration, std::string& error)
+    {
+        double start = 0;
+        int64_t duration = -1;
+        double end = 0;
+        Curve curve = Curve::eLinear;
+        int fields = 1;
+        bool success = ParseNumber(text, position, start);
+        if (!success)
+        {
+            error = Error(position, "expected value");
+        }
+        SkipSpaces(text, position);
+        if (success && position < text.size() && text[position] == ';')
+        {
+            position++;
+            SkipSpaces(text, position);
+            success = ParseDuration(text, position, duration);
+            fields++;
+            if (!success)
+            {
+                error = Error(position, "expected duration");
+            }
+            SkipSpaces(text, position);
+        }
+        if (success && position < text.size() && text[position] == ';')
+        {
+            position++;
+            SkipSpaces(text, position);
+            success = ParseNumber(text, position, end);
+            fields++;
+            if (!success)
+            {
+                error = Error(position, "expected end value");
+            }
+            SkipSpaces(text, position);
+        }
+        if (success && fields == 3 && position < text.size() && text[position] == ';')
+        {
+            position++;
+            SkipSpaces(text, position);
+            success = ParseCurve(text, position, curve);
+            if (!success)
+            {
+                error = Error(position, "unknown curve");
+            }
+            SkipSpaces(text, position);
+        }
+        if (success && position < text.size() && text[position] != '{' && text[position] != '}')
+        {
+            error = Error(position, "expected '{' or '}' after element");
+            success = false;
+        }
+        if (success)
+        {
+            elementDuration = fields == 1 ? -1 : duration;
+        }
+        if (success && sequence != nullptr)
+        {
+            if (fields == 3)
+            {
+                sequence->subsequences.push_back(new SequenceElement(start, duration, end, 1, curve));
+            }
+            else if (fields == 2)
+            {
+                sequence->subsequences.push_back(new SequenceElement(start, duration));
             }
-            index++;
+            else
+            {
+                sequence->subsequences.push_back(new SequenceElement(start));
+            }
+        }
+        return success;
+    }
+    //!
+    //! @brief Copy the characters of the number to a buffer on the stack and convert them completely
+    //!
+    bool Sequence::ParseNumber(std::string_view text, size_t& position, double& value)
+    {
+        size_t end = position;
+        while (end < text.size() && ((text[end] >= '0' && text[end] <= '9') || text[end] == '.' || text[end] == '-' || text[end] == '+' || text[end] == 'e' || text[end] == 'E'))
+        {
+            end++;
         }
+        char buffer[32];
+        size_t size = end - position;
+        bool success = size > 0 && size < sizeof(buffer);
+        if (success)
+        {
+            memcpy(buffer, text.data() + position, size);
+            buffer[size] = '\0';
+            char* parsedEnd = nullptr;
+            value = strtod(buffer, &parsedEnd);
+            success = parsedEnd == buffer + size && std::isfinite(value);
+        }
+        if (success)
+        {
+            position = end;
+        }
+        return success;
+    }
+    //!
+    //! @brief Parse number of milliseconds and round to microseconds
+    //!
+    bool Sequence::ParseDuration(std::string_view text, size_t& position, int64_t& value)
+    {
+        double milliseconds = 0;
+        size_t start = position;
+        bool success = ParseNumber(text, position, milliseconds) && milliseconds >= 0 && milliseconds < 1e15;
+        if (success)
+        {
+            value = std::llround(milliseconds * 1000);
+        }
+        else
+        {
+            position = start;
+        }
+        return success;
+    }
+    //!
+    //! @brief Take the letters at position as name of the curve
+    //!
+    bool Sequence::ParseCurve(std::string_view text, size_t& position, Curve& curve)
+    {
+        size_t end = position;
+        while (end < text.size() && text[end] >= 'a' && text[end] <= 'z')
+        {
+            end++;
+        }
+        bool success = end > position && ToCurve(std::string(text.substr(position, end - position)), curve);
+        if (success)
+        {
+            position = end;
+        }
+        return success;
+    }
+    //!
+    //! @brief Convert the digits at position
+    //!
+    bool Sequence::ParseInteger(std::string_view text, size_t& position, long& value)
+    {
+        size_t end = position;
+        while (end < text.size() && text[end] >= '0' && text[end] <= '9')
+        {
+            end++;
+        }
+        bool success = end > position && std::from_chars(text.data() + position, text.data() + end, value).ec == std::errc();
+        if (success)
+        {
+            position = end;
+        }
+        return success;
+    }
+    //!
+    //! @brief Skip spaces, tabs and line breaks
+    //!
+    void Sequence::SkipSpaces(std::string_view text, size_t& position)
+    {
+        while (position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r'))
+        {
+            position++;
+        }
+    }
+    //!
+    //! @brief Prefix message with position
+    //!
+    std::string Sequence::Error(size_t position, const char* message)
+    {
+        return "Position " + std::to_string(position) + ": " + message;
     }
     //!
     //! @brief Destruction of the sequence object
@@ -144,22 +579,215 @@ namespace ModelController
         subsequences.clear();
     }
     //!
-    //! @brief Get actual value from actual time
+    //! @brief Descend from the root to the active element and track absolute start and end of the actual iterations
+    //!
+    void Sequence::Find(uint64_t time, Cursor& cursor) const
+    {
+        constexpr uint64_t infinite = std::numeric_limits<uint64_t>::max();
+        cursor.valid = !segments.empty();
+        size_t index = 0;
+        uint32_t last = 0;
+        uint64_t iterationStart = 0;
+        uint64_t end = infinite;
+        uint64_t blockEnd = infinite;
+        while (cursor.valid && segments[index].count > 0)
+        {
+            const Segment& sequence = segments[index];
+            uint64_t iterationEnd = end;
+            if (sequence.period > 0)
+            {
+                iterationStart += (time - iterationStart) / sequence.period * sequence.period;
+                iterationEnd = std::min(end, iterationStart + sequence.period);
+            }
+            int64_t relativeTime = time - iterationStart;
+            // Last child starting before or at the time (zero duration children are followed by a child with the same start)
+            const Segment* begin = segments.data() + sequence.first;
+            const Segment* child = std::upper_bound(begin, begin + sequence.count, relativeTime, [](int64_t time, const Segment& segment){ return time < segment.start; }) - 1;
+            cursor.valid = child >= begin && (child->duration < 0 || relativeTime < child->start + child->duration);
+            if (cursor.valid)
+            {
+                iterationStart += child->start;
+                end = child->duration < 0 ? iterationEnd : std::min(iterationEnd, iterationStart + child->duration);
+                blockEnd = iterationEnd;
+                last = sequence.first + sequence.count;
+                index = child - segments.data();
+            }
+        }
+        if (cursor.valid)
+        {
+            const Segment& element = segments[index];
+            if (element.period > 0)
+            {
+                iterationStart += (time - iterationStart) / element.period * element.period;
+                end = std::min(end, iterationStart + element.period);
+            }
+            cursor.index = index;
+            cursor.last = last;
+            cursor.start = iterationStart;
+            cursor.length = end == infinite ? infinite : end - iterationStart;
+            cursor.blockLength = blockEnd == infinite ? infinite : blockEnd - iterationStart;
+        }
+    }
+    //!
+    //! @brief Search active element without cursor
+    //!
+    double Sequence::GetValue(uint64_t time) const
+    {
+        Cursor cursor;
+        return GetValue(time, cursor);
+    }
+    //!
+    //! @brief Keep element or step to the following sibling elements while the parent's iteration continues, else search
+    //!
+    void Sequence::Advance(uint64_t time, Cursor& cursor) const
+    {
+        constexpr uint64_t infinite = std::numeric_limits<uint64_t>::max();
+        while (cursor.valid && time >= cursor.start && time - cursor.start >= cursor.length
+            && cursor.length < cursor.blockLength && cursor.index + 1 < cursor.last && segments[cursor.index + 1].count == 0)
+        {
+            cursor.start += cursor.length;
+            cursor.blockLength = cursor.blockLength == infinite ? infinite : cursor.blockLength - cursor.length;
+            cursor.index++;
+            int64_t duration = segments[cursor.index].duration;
+            cursor.length = duration < 0 || static_cast<uint64_t>(duration) > cursor.blockLength ? cursor.blockLength : duration;
+        }
+        if (!cursor.valid || time < cursor.start || time - cursor.start >= cursor.length)
+        {
+            Find(time, cursor);
+        }
+    }
+    //!
+    //! @brief Advance cursor and interpolate the element with the requested number type
     //!
-    double Sequence::GetValue(unsigned long time)
+    double Sequence::GetValue(uint64_t time, Cursor& cursor, Precision precision) const
     {
         double value = 0;
-        if (GetDuration() <= 0)
+        if (precision == Precision::eFixed)
         {
-            value = GetValueRelativeTime(time);
+            value = GetFixedValue(time, cursor) * (1.0 / (1 << fixedBits));
         }
         else
         {
-            value = GetValueRelativeTime(time % GetDuration());
+            Advance(time, cursor);
+            if (cursor.valid)
+            {
+                const Segment& element = segments[cursor.index];
+                value = element.from;
+                if (element.period > 0)
+                {
+                    uint64_t relativeTime = (time - cursor.start) % element.period;
+                    if (element.curve != Curve::eLinear)
+                    {
+                        // Shaped progress is looked up in fixed point, so curves cost the same in every precision
+                        int32_t shaped = Shape(element.curve, GetProgress(relativeTime, element.period));
+                        if (precision == Precision::eFloat)
+                        {
+                            value = element.fromFloat + element.deltaFloat * (static_cast<float>(shaped) * (1.0f / (1 << fixedBits)));
+                        }
+                        else
+                        {
+                            value = element.from + (element.to - element.from) * (shaped * (1.0 / (1 << fixedBits)));
+                        }
+                    }
+                    else if (precision == Precision::eFloat)
+                    {
+                        value = element.fromFloat + element.deltaFloat * (static_cast<float>(relativeTime) / static_cast<float>(element.period));
+                    }
+                    else
+                    {
+                        value = element.from + (element.to - element.from) * ((double)relativeTime / (double)element.period);
+                    }
+                }
+            }
         }
         return value;
     }
     //!
+    //! @brief Advance cursor and interpolate the element with integers (64 bit product, 32 bit result)
+    //!
+    int32_t Sequence::GetFixedValue(uint64_t time, Cursor& cursor) const
+    {
+        int32_t value = 0;
+        Advance(time, cursor);
+        if (cursor.valid)
+        {
+            const Segment& element = segments[cursor.index];
+            value = element.fromFixed;
+            if (element.period > 0)
+            {
+                uint64_t relativeTime = (time - cursor.start) % element.period;
+                if (element.curve != Curve::eLinear)
+                {
+                    value += static_cast<int32_t>(static_cast<int64_t>(element.deltaFixed) * Shape(element.curve, GetProgress(relativeTime, element.period)) / (1 << fixedBits));
+                }
+                else
+                {
+                    value += static_cast<int32_t>(static_cast<int64_t>(element.deltaFixed) * static_cast<int64_t>(relativeTime) / element.period);
+                }
+            }
+        }
+        return value;
+    }
+    //!
+    //! @brief Advance cursor and limit the element to the actual iteration of ramps
+    //!
+    Sequence::Piece Sequence::GetPiece(uint64_t time, Cursor& cursor) const
+    {
+        constexpr uint64_t infinite = std::numeric_limits<uint64_t>::max();
+        Piece piece;
+        piece.start = time;
+        piece.end = infinite;
+        Advance(time, cursor);
+        if (cursor.valid)
+        {
+            const Segment& element = segments[cursor.index];
+            piece.start = cursor.start;
+            piece.end = cursor.length == infinite ? infinite : cursor.start + cursor.length;
+            piece.from = element.from;
+            if (element.period > 0)
+            {
+                piece.start = cursor.start + (time - cursor.start) / element.period * element.period;
+                piece.end = std::min(piece.end, piece.start + element.period);
+                piece.slope = (element.to - element.from) / element.period;
+                if (element.curve != Curve::eLinear)
+                {
+                    // Chord of the table interval containing time, the end is rounded up to stay behind time
+                    constexpr uint64_t intervals = 1 << curveBits;
+                    const std::vector<int32_t>& table = curveTables[static_cast<size_t>(element.curve)];
+                    uint64_t iterationStart = piece.start;
+                    uint64_t interval = GetProgress(time - iterationStart, element.period) >> (fixedBits - curveBits);
+                    piece.start = iterationStart + interval * element.period / intervals;
+                    piece.end = std::min(piece.end, iterationStart + ((interval + 1) * element.period + intervals - 1) / intervals);
+                    piece.from = element.from + (element.to - element.from) * (table[interval] * (1.0 / (1 << fixedBits)));
+                    piece.slope = (element.to - element.from) * ((table[interval + 1] - table[interval]) * (1.0 / (1 << fixedBits))) / (piece.end - piece.start);
+                }
+            }
+        }
+        return piece;
+    }
+    //!
+    //! @brief End of the element or time of the next step of the ramp
+    //!
+    std::optional<uint64_t> Sequence::GetNextChange(uint64_t time, const Cursor& cursor, double resolution) const
+    {
+        constexpr uint64_t infinite = std::numeric_limits<uint64_t>::max();
+        uint64_t next = infinite;
+        if (cursor.valid)
+        {
+            const Segment& element = segments[cursor.index];
+            next = cursor.length == infinite ? infinite : cursor.start + cursor.length;
+            if (element.period > 0 && element.deltaFixed != 0)
+            {
+                // Time for a change of resolution: ceil(resolution * period / |delta * slope|), done in fixed point
+                int64_t delta = std::abs(static_cast<int64_t>(element.deltaFixed)) * curveSlopes[static_cast<size_t>(element.curve)] >> fixedBits;
+                int64_t resolutionFixed = resolution > 0 ? ToFixed(resolution) : 0;
+                int64_t step = (resolutionFixed * element.period + delta - 1) / delta;
+                next = std::min(next, time + (step > 0 ? static_cast<uint64_t>(step) : 1));
+            }
+        }
+        return next == infinite ? std::nullopt : std::optional<uint64_t>(next);
+    }
+    //!
     //! @brief Returns number of repetitions
     //!
     int Sequence::GetRepeat() const
@@ -169,30 +797,28 @@ namespace ModelController
     //!
     //! @brief Calculates duration of the sequence
     //!
-    long Sequence::GetDuration(bool withRepeat) const
+    std::optional<uint64_t> Sequence::GetDuration(bool withRepeat) const
     {
-        long duration = 0;
-
-        if (withRepeat && repeat < 0)
+        std::optional<uint64_t> duration = 0;
+        if (!segments.empty())
         {
-            duration = -1;
+            int64_t compiled = withRepeat ? segments[0].duration : segments[0].period;
+            duration = compiled < 0 ? std::nullopt : std::optional<uint64_t>(compiled);
+        }
+        else if (withRepeat && repeat < 0)
+        {
+            duration = std::nullopt;
         }
         else
         {
-            for (int i = 0; i < subsequences.size() && duration >= 0; i++)
+            for (size_t i = 0; i < subsequences.size() && duration; i++)
             {
-                if (subsequences[i]->GetDuration() >= 0)
-                {
-                    duration += subsequences[i]->GetDuration();
-                }
-                else
-                {
-                    duration = -1;
-                }
+                std::optional<uint64_t> subsequenceDuration = subsequences[i]->GetDuration();
+                duration = subsequenceDuration ? std::optional<uint64_t>(*duration + *subsequenceDuration) : std::nullopt;
             }
-            if (withRepeat)
+            if (withRepeat && duration)
             {
-                duration *= repeat;
+                *duration *= repeat;
             }
         }
         return duration;
@@ -200,7 +826,7 @@ namespace ModelController
     //!
     //! @brief Calculate the sequence's config string
     //!
-    std::string Sequence::GetSequenceString()
+    std::string Sequence::GetSequenceString() const
     {
         std::stringstream sequenceString;
         if (GetRepeat() < 0)
@@ -216,9 +842,15 @@ namespace ModelController
             sequenceString << GetRepeat();
         }
         sequenceString << "{";
-        for (int i = 0; i < subsequences.size(); i++)
+        for (size_t i = 0; i < subsequences.size(); i++)
         {
-            sequenceString << subsequences[i]->GetSequenceString();
+            std::string item = subsequences[i]->GetSequenceString();
+            // An element of digits followed by a sequence would be read as its repetitions, so it gets its own braces
+            if (i + 1 < subsequences.size() && item.back() != '}' && item.find_first_not_of("0123456789") == std::string::npos)
+            {
+                item = "{" + item + "}";
+            }
+            sequenceString << item;
         }
         sequenceString << "}";
         return sequenceString.str();
@@ -8,55 +8,44 @@
 #include <Arduino.h>
 #include <sstream>
 #include "SequenceElement.hpp"
+#include "Utils.hpp"
 
 namespace ModelController
 {
     //!
-    //! @brief Calculate actual value depending on time
+    //! @brief Set values, duration of one iteration and with repetition
     //!
-    double SequenceElement::GetValueRelativeTime(long time)
+    void SequenceElement::Compile(std::vector<Segment>& segments, size_t index) const
     {
-        //!
-        //! @brief If duration is bigger than time, modulo is calculated
-        //!
-        time = time % duration;
-        //!
-        //! @brief If time is smaller zero (infinity) start is returned
-        //!
-        if (time <= 0)
-        {
-            return start;
-        }
-        //!
-        //! @brief If time is bigger than duration end is returned
-        //!
-        else if (time >= duration)
-        {
-            return end;
-        }
-        //!
-        //! @brief Else value is calculated from difference between start and end and the duration and actual time
-        //!
-        else
-        {
-            return start + (end - start) * ((double)time / (double)duration);
-        }
+        Segment& segment = segments[index];
+        segment.from = start;
+        segment.to = end;
+        segment.fromFixed = ToFixed(start);
+        segment.deltaFixed = ToFixed(end - start);
+        segment.fromFloat = start;
+        segment.deltaFloat = end - start;
+        segment.curve = curve;
+        PrepareCurve(curve);
+        segment.period = duration;
+        std::optional<uint64_t> withRepeat = GetDuration();
+        segment.duration = withRepeat ? static_cast<int64_t>(*withRepeat) : -1;
     }
     //!
     //! @brief Construct a new SequenceElement object
     //!
-    SequenceElement::SequenceElement(double start, long duration, double end, int repeat)
+    SequenceElement::SequenceElement(double start, int64_t duration, double end, int repeat, Curve curve)
         : Sequence(repeat),
         start(start),
         duration(duration),
-        end(end)
+        end(end),
+        curve(curve)
     {
     }
     //!
     //! @brief Construct a new SequenceElement object
     //! End is not present => end = start
     //!
-    SequenceElement::SequenceElement(double start, long duration, int repeat)
+    SequenceElement::SequenceElement(double start, int64_t duration, int repeat)
         : SequenceElement(start, duration, start, repeat)
     {
     }
@@ -77,46 +66,42 @@ namespace ModelController
     {
     }
     //!
-    //! @brief Calculates duration of the element
+    //! @brief Calculates duration of the element, infinite if repeated infinitely or without duration
     //!
-    long SequenceElement::GetDuration(bool withRepeat) const
+    std::optional<uint64_t> SequenceElement::GetDuration(bool withRepeat) const
     {
-        //!
-        //! @brief -1 (Infinity), if repeat smaller zero
-        //!
-        if (GetRepeat() < 0)
-        {
-            return - 1;
-        }
-        else
+        std::optional<uint64_t> elementDuration;
+        if (GetRepeat() >= 0 && duration >= 0)
         {
-            //!
-            //! @brief If with repeat, duration multiplied with repetition
-            //!
-            if (withRepeat)
-            {
-                return duration * GetRepeat();
-            }
-            else
-            {
-                return duration;
-            }
+            elementDuration = withRepeat ? duration * GetRepeat() : duration;
         }
+        return elementDuration;
     }
     //!
     //! @brief Calculate the element's sequence string
     //!
-    std::string SequenceElement::GetSequenceString()
+    std::string SequenceElement::GetSequenceString() const
     {
         std::stringstream sequenceString;
-        sequenceString << start;
+        // Values need to round trip, as the string is the key of the sequence cache
+        sequenceString << Utils::ToExactString(start);
         if (duration >= 0)
         {
-            sequenceString << ";" << duration;
+            // Duration in milliseconds, fractions only if it isn't a multiple of a millisecond
+            sequenceString << ";" << duration / 1000;
+            if (duration % 1000 != 0)
+            {
+                std::string fraction = std::to_string(1000 + duration % 1000).substr(1);
+                sequenceString << "." << fraction.substr(0, fraction.find_last_not_of('0') + 1);
+            }
             if (end != start)
             {
                 sequenceString << ";";
-                sequenceString << end;
+                sequenceString << Utils::ToExactString(end);
+                if (curve != Curve::eLinear)
+                {
+                    sequenceString << ";" << CurveToString(curve);
+                }
             }
         }
         return sequenceString.str();
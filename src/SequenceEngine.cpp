@@ -0,0 +1,162 @@
+//!
+//! @file SequenceEngine.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Implementation of the SequenceEngine
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include "SequenceEngine.hpp"
+#include "SequenceProcessor.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace ModelController
+{
+    //!
+    //! @brief Processors in the batch
+    //!
+    std::vector<SequenceProcessor*> SequenceEngine::processors;
+    //!
+    //! @brief Start of the pieces
+    //!
+    std::vector<uint64_t> SequenceEngine::starts;
+    //!
+    //! @brief End of the pieces
+    //!
+    std::vector<uint64_t> SequenceEngine::ends;
+    //!
+    //! @brief Values at the start of the pieces
+    //!
+    std::vector<double> SequenceEngine::offsets;
+    //!
+    //! @brief Slopes of the pieces
+    //!
+    std::vector<double> SequenceEngine::slopes;
+    //!
+    //! @brief Values of the last pass
+    //!
+    std::vector<double> SequenceEngine::values;
+    //!
+    //! @brief Listener evaluating the lanes
+    //!
+    LoopEvent::LoopListener* SequenceEngine::loopListener = nullptr;
+    //!
+    //! @brief Append lane, which is refreshed on the next pass, and create listener with the first lane or wake it
+    //!
+    void SequenceEngine::Add(SequenceProcessor* processor)
+    {
+        processors.push_back(processor);
+        starts.push_back(0);
+        ends.push_back(0);
+        offsets.push_back(0);
+        slopes.push_back(0);
+        values.push_back(0);
+        if (loopListener == nullptr)
+        {
+            loopListener = new LoopEvent::LoopListener([](){ Evaluate(Clock::Now()); });
+        }
+        else
+        {
+            loopListener->Wake();
+        }
+    }
+    //!
+    //! @brief Move last lane to the lane of the processor and delete listener with the last lane
+    //!
+    void SequenceEngine::Remove(SequenceProcessor* processor)
+    {
+        std::vector<SequenceProcessor*>::iterator it = std::find(processors.begin(), processors.end(), processor);
+        if (it != processors.end())
+        {
+            size_t lane = it - processors.begin();
+            processors[lane] = processors.back();
+            starts[lane] = starts.back();
+            ends[lane] = ends.back();
+            offsets[lane] = offsets.back();
+            slopes[lane] = slopes.back();
+            values[lane] = values.back();
+            processors.pop_back();
+            starts.pop_back();
+            ends.pop_back();
+            offsets.pop_back();
+            slopes.pop_back();
+            values.pop_back();
+        }
+        if (processors.empty())
+        {
+            delete loopListener;
+            loopListener = nullptr;
+        }
+    }
+    //!
+    //! @brief Set end of the lane's piece to the past and wake the listener for the next pass
+    //!
+    void SequenceEngine::Invalidate(SequenceProcessor* processor)
+    {
+        std::vector<SequenceProcessor*>::iterator it = std::find(processors.begin(), processors.end(), processor);
+        if (it != processors.end())
+        {
+            ends[it - processors.begin()] = 0;
+            loopListener->Wake();
+        }
+    }
+    //!
+    //! @brief Refresh lanes at their breakpoints, evaluate all lanes in one pass and set the outputs
+    //!
+    //! If no lane is ramping, the listener sleeps until the first piece ends
+    //!
+    void SequenceEngine::Evaluate(uint64_t time)
+    {
+        constexpr uint64_t infinite = std::numeric_limits<uint64_t>::max();
+        size_t size = processors.size();
+        for (size_t lane = 0; lane < size; lane++)
+        {
+            if (time >= ends[lane])
+            {
+                Sequence::Piece piece = processors[lane]->Refresh(time);
+                starts[lane] = piece.start;
+                ends[lane] = piece.end;
+                offsets[lane] = piece.from;
+                slopes[lane] = piece.slope;
+            }
+        }
+        // Branch-free over contiguous arrays, vectorized by the compiler where SIMD is available
+        const uint64_t* start = starts.data();
+        const double* offset = offsets.data();
+        const double* slope = slopes.data();
+        double* value = values.data();
+        for (size_t lane = 0; lane < size; lane++)
+        {
+            value[lane] = offset[lane] + slope[lane] * static_cast<double>(time - start[lane]);
+        }
+        for (size_t lane = 0; lane < size; lane++)
+        {
+            processors[lane]->SetOutput(value[lane]);
+        }
+        bool ramping = false;
+        uint64_t wakeTime = infinite;
+        for (size_t lane = 0; lane < size; lane++)
+        {
+            ramping = ramping || slopes[lane] != 0;
+            wakeTime = std::min(wakeTime, ends[lane]);
+        }
+        if (loopListener != nullptr && !ramping)
+        {
+            if (wakeTime == infinite)
+            {
+                loopListener->Sleep();
+            }
+            else
+            {
+                loopListener->Sleep(wakeTime);
+            }
+        }
+    }
+    //!
+    //! @brief Returns number of lanes
+    //!
+    size_t SequenceEngine::GetSize()
+    {
+        return processors.size();
+    }
+} // namespace ModelController
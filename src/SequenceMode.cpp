@@ -15,11 +15,15 @@ namespace ModelController
     //! @brief Construct new mode with json config
     //!
     SequenceMode::SequenceMode(JsonObject mode)
-        : sequence(mode["mode"].is<std::string>() ? mode["mode"].as<std::string>() : "{}")
+        : sequence(Sequence::Get(mode["mode"].is<std::string>() ? mode["mode"].as<std::string>() : "{}"))
     {
         on = mode["on"].is<bool>() ? mode["on"] : false;
         off = mode["off"].is<bool>() ? mode["off"] : false;
-        syncTime = mode["sync"].is<long>() ? mode["sync"] : -1;
+        // Sync is configured in milliseconds
+        if (mode["sync"].is<long>() && mode["sync"].as<long>() > 0)
+        {
+            syncTime = static_cast<uint64_t>(mode["sync"].as<long>()) * 1000;
+        }
     }
     //!
     //! @brief Destruction of the SequenceMode object
@@ -28,16 +32,23 @@ namespace ModelController
     {
     }
     //!
-    //! @brief Get actual value of the sequence for specified time
+    //! @brief Returns shared sequence
+    //!
+    const Sequence& SequenceMode::GetSequence() const
+    {
+        return *sequence;
+    }
+    //!
+    //! @brief Returns cursor
     //!
-    double SequenceMode::GetValue(unsigned long time)
+    Sequence::Cursor& SequenceMode::GetCursor()
     {
-        return sequence.GetValue(time);
+        return cursor;
     }
     //!
     //! @brief Get sync time
     //!
-    long SequenceMode::GetSyncTime() const
+    std::optional<uint64_t> SequenceMode::GetSyncTime() const
     {
         return syncTime;
     }
@@ -61,7 +72,7 @@ namespace ModelController
     std::string SequenceMode::GetConfig()
     {
         std::stringstream config;
-        config << "\"mode\": \"" + sequence.GetSequenceString() + "\"";
+        config << "\"mode\": \"" + sequence->GetSequenceString() + "\"";
         if (on)
         {
             config << ",\"on\": true";
@@ -70,9 +81,9 @@ namespace ModelController
         {
             config << ",\"off\": true";
         }
-        if (syncTime >= 0)
+        if (syncTime)
         {
-            config << ",\"off\": " << syncTime;
+            config << ",\"sync\": " << *syncTime / 1000;
         }
         return config.str();
     }
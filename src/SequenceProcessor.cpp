@@ -6,7 +6,12 @@
 //! @copyright Copyright (c) 2023
 //!
 #include "SequenceProcessor.hpp"
+#include "Metrics.hpp"
+#include "SequenceEngine.hpp"
+#include "Clock.hpp"
 #include <sstream>
+#include <limits>
+#include <algorithm>
 namespace ModelController
 {
     //!
@@ -19,6 +24,7 @@ namespace ModelController
             manualSetpoint = -1;
         }
         active = value;
+        Wake();
     }
     //!
     //! @brief Set manual setpoint value
@@ -26,6 +32,7 @@ namespace ModelController
     void SequenceProcessor::OnManualTargetChanged(double value)
     {
         manualSetpoint = value;
+        Wake();
     }
     //!
     //! @brief Set manual target value
@@ -47,30 +54,31 @@ namespace ModelController
         {
             active = true;
         }
+        Wake();
     }
     //!
     //! @brief Calcultes time start on-sequence depending on duration of on-sequence and on flag of active mode
     //!
-    long SequenceProcessor::GetTimeStartOn() const
+    std::optional<uint64_t> SequenceProcessor::GetTimeStartOn() const
     {
-        long timeStartOn = timeStartMode;
-        // On sequence is executed directly before mode
-        if (activeMode != nullptr && activeMode->GetOn())
+        std::optional<uint64_t> timeStartOn = timeStartMode;
+        // On sequence is executed directly before mode (infinite on-sequences are skipped)
+        if (timeStartOn && activeMode != nullptr && activeMode->GetOn())
         {
-            timeStartOn -= on.GetDuration();
+            *timeStartOn -= std::min(*timeStartOn, on->GetDuration().value_or(0));
         }
         return timeStartOn;
     }
     //!
     //! @brief Calcultes time end off-sequence depending on duration of off-sequence and off flag of active mode
     //!
-    long SequenceProcessor::GetTimeEndOff() const
+    std::optional<uint64_t> SequenceProcessor::GetTimeEndOff() const
     {
-        long timeEndOff = timeEndMode;
-        // Calculate end time of off sequence
-        if (activeMode != nullptr && activeMode->GetOff())
+        std::optional<uint64_t> timeEndOff = timeEndMode;
+        // Calculate end time of off sequence (infinite off-sequences are skipped)
+        if (timeEndOff && activeMode != nullptr && activeMode->GetOff())
         {
-            timeEndOff += off.GetDuration();
+            *timeEndOff += off->GetDuration().value_or(0);
         }
         return timeEndOff;
     }
@@ -94,13 +102,14 @@ namespace ModelController
         : BaseContainer(name, config, parent, ModuleType::eNone, ModuleDataType::eNone),
         loopListener([&](){this->Execute();}),
         out("out", this),
-        on(config["on"].is<std::string>() ? config["on"].as<std::string>() : "{}"),
-        off(config["off"].is<std::string>() ? config["off"].as<std::string>() : "{}"),
         activate("activate", config, [&](bool value) { this->OnActivateChanged(value); }, this),
         manualTarget("manualTarget", config, [&](double value) { this->OnManualTargetChanged(value); }, this),
         targetMode("targetMode", config, [&](std::string value) { this->OnTargetModeChanged(value); }, this),
         defaultMode("defaultMode", config, "", this),
-        active("active", this)
+        off(Sequence::Get(config["off"].is<std::string>() ? config["off"].as<std::string>() : "{}")),
+        on(Sequence::Get(config["on"].is<std::string>() ? config["on"].as<std::string>() : "{}")),
+        active("active", this),
+        resolution("resolution", config, defaultResolution, this)
     {
         JsonObject jsonModes = config["modes"].as<JsonObject>();
         for (JsonObject::iterator it = jsonModes.begin(); it != jsonModes.end(); ++it)
@@ -111,12 +120,58 @@ namespace ModelController
             }
         }
         activeMode = GetMode(defaultMode);
+        for (JsonPair jsonChannel : config["channels"].as<JsonObject>())
+        {
+            if (GetDirectChild(jsonChannel.key().c_str()) != nullptr)
+            {
+                Logger::warning("SequenceProcessor " + GetPath() + ": Channel " + jsonChannel.key().c_str() + " is skipped, name is already used");
+            }
+            else
+            {
+                Channel channel;
+                channel.out = new ModuleOut<double>(jsonChannel.key().c_str(), this);
+                channel.phase = static_cast<uint64_t>(std::max(0.0, jsonChannel.value()["phase"] | 0.0) * 1000);
+                channel.gain = jsonChannel.value()["gain"] | 1.0;
+                channel.invert = jsonChannel.value()["invert"] | false;
+                channels.push_back(channel);
+            }
+        }
+        if (config["precision"].is<std::string>())
+        {
+            Sequence::ToPrecision(config["precision"].as<std::string>(), precision);
+        }
+        std::string errorMessage = Validate(config);
+        if (!errorMessage.empty())
+        {
+            Logger::warning("SequenceProcessor " + GetPath() + ": " + errorMessage);
+        }
+        // Processors in the batch are evaluated by the engine, the own listener sleeps forever
+        batch = config["batch"] | false;
+        if (batch && !channels.empty())
+        {
+            // The engine evaluates a single piece per lane, channels with phase need their own evaluation
+            Logger::warning("SequenceProcessor " + GetPath() + ": Processors with channels can't be batched");
+            batch = false;
+        }
+        if (batch)
+        {
+            loopListener.Sleep();
+            SequenceEngine::Add(this);
+        }
     }
     //!
-    //! @brief Delete modes
+    //! @brief Leave the batch and delete channel outputs and modes
     //!
     SequenceProcessor::~SequenceProcessor()
     {
+        if (batch)
+        {
+            SequenceEngine::Remove(this);
+        }
+        for (Channel& channel : channels)
+        {
+            delete channel.out;
+        }
         for (std::map<std::string, SequenceMode*>::iterator it = modes.begin(); it != modes.end(); ++it)
         {
             if (it->second != nullptr)
@@ -126,10 +181,49 @@ namespace ModelController
         }
     }
     //!
-    //! @brief Calculate target value and set value to channel
+    //! @brief Validate on- and off-sequence, the sequences of all modes and the precision, stop at the first error
     //!
-    void SequenceProcessor::Execute()
+    std::string SequenceProcessor::Validate(JsonObject config)
+    {
+        std::string errorMessage = "";
+        for (const char* key : {"on", "off"})
+        {
+            if (errorMessage.empty() && config[key].is<const char*>())
+            {
+                std::string error = Sequence::Validate(config[key].as<const char*>());
+                errorMessage = error.empty() ? "" : std::string(key) + ": " + error;
+            }
+        }
+        for (JsonPair mode : config["modes"].as<JsonObject>())
+        {
+            if (errorMessage.empty() && mode.value()["mode"].is<const char*>())
+            {
+                std::string error = Sequence::Validate(mode.value()["mode"].as<const char*>());
+                errorMessage = error.empty() ? "" : std::string("modes/") + mode.key().c_str() + "/mode: " + error;
+            }
+        }
+        for (JsonPair channel : config["channels"].as<JsonObject>())
+        {
+            if (errorMessage.empty() && channel.value()["phase"].is<double>() && channel.value()["phase"].as<double>() < 0)
+            {
+                errorMessage = std::string("channels/") + channel.key().c_str() + "/phase: phase must not be negative";
+            }
+        }
+        Sequence::Precision precision = Sequence::Precision::eDouble;
+        if (errorMessage.empty() && config["precision"].is<std::string>() && !Sequence::ToPrecision(config["precision"].as<std::string>(), precision))
+        {
+            errorMessage = "precision: unknown precision " + config["precision"].as<std::string>();
+        }
+        return errorMessage;
+    }
+    //!
+    //! @brief Update times of on-sequence, mode and off-sequence and select the sequence running at actual time
+    //!
+    double SequenceProcessor::Update(uint64_t actualTime, const Sequence*& running, Sequence::Cursor*& cursor, uint64_t& sequenceStart, std::optional<uint64_t>& nextChange)
     {
+        nextChange.reset();
+        running = nullptr;
+        Metrics::sequenceEvaluations.Increment();
         double value = manualSetpoint;
         if (value < 0)
         {
@@ -139,102 +233,109 @@ namespace ModelController
                 nextActiveMode = nullptr;
             }
             value = 0;
-            // ToDo: Duration -1
             // End if not active or no active mode is set or new next active mode is set
             // End time is time where next sync cycle is finished (if used) plus duration of off-sequence (if used)
             if (!active || activeMode == nullptr || (activeMode != nextActiveMode && nextActiveMode != nullptr))
             {
                 // If time for ending was set already or time started was not set yet, time for ending does not need to be set
-                if (timeEndMode < 0 && timeStartMode >= 0)
+                if (!timeEndMode && timeStartMode)
                 {
-                    timeEndMode = millis();
                     // Earliest time for ending is time where mode was started
-                    if (timeEndMode < timeStartMode)
-                    {
-                        timeEndMode = timeStartMode;
-                    }
+                    timeEndMode = std::max(actualTime, *timeStartMode);
                     // End mode only after end of sync cycle, if sync is active
-                    if (activeMode != nullptr && activeMode->GetSyncTime() >= 0)
+                    if (activeMode != nullptr && activeMode->GetSyncTime())
                     {
-                        long syncTime = activeMode->GetSyncTime();
-                        if (timeEndMode % syncTime != 0)
+                        uint64_t syncTime = *activeMode->GetSyncTime();
+                        if (*timeEndMode % syncTime != 0)
                         {
-                            timeEndMode = (timeEndMode / syncTime) * syncTime + syncTime;
+                            timeEndMode = (*timeEndMode / syncTime) * syncTime + syncTime;
                         }
                     }
                 }
                 // if actual time is bigger then time where mode ends, time for starting mode and time for starting on sequence is not needed anymore
-                if (millis() > timeEndMode && timeEndMode >= 0)
+                if (timeEndMode && actualTime > *timeEndMode)
                 {
-                    timeStartMode = -1;
+                    timeStartMode.reset();
                 }
             }
             else
             {
-                if (timeStartMode < 0)
+                if (!timeStartMode)
                 {
-                    timeStartMode = millis();
                     // Earliest time for starting is time where off-sequence is ending
-                    if (timeStartMode < GetTimeEndOff())
-                    {
-                        timeStartMode = GetTimeEndOff();
-                    }
+                    timeStartMode = std::max(actualTime, GetTimeEndOff().value_or(0));
                     if (activeMode != nullptr)
                     {
                         // Mode can only be started after on-sequence (if set)
                         if (activeMode->GetOn())
                         {
-                            timeStartMode += on.GetDuration();
+                            *timeStartMode += on->GetDuration().value_or(0);
                         }
                         // Mode is only started with beginning of sync cycle (if set)
-                        if (activeMode->GetSyncTime() >= 0)
+                        if (activeMode->GetSyncTime())
                         {
-                            unsigned long endWithoutSync = timeStartMode;
-                            unsigned long endWithSync = (endWithoutSync / activeMode->GetSyncTime()) * activeMode->GetSyncTime();
-                            if (endWithoutSync % activeMode->GetSyncTime() != 0)
+                            uint64_t syncTime = *activeMode->GetSyncTime();
+                            uint64_t endWithoutSync = *timeStartMode;
+                            uint64_t endWithSync = (endWithoutSync / syncTime) * syncTime;
+                            if (endWithoutSync % syncTime != 0)
                             {
-                                endWithSync += activeMode->GetSyncTime();
+                                endWithSync += syncTime;
                             }
                             timeStartMode = endWithSync;
-                            Logger::debug("Setting timeStartMode for " + GetName() + " to " + std::to_string(timeStartMode));
-                            Logger::debug("Actual time " + std::to_string(millis()));
+                            Logger::debug("Setting timeStartMode for " + GetName() + " to " + std::to_string(*timeStartMode));
+                            Logger::debug("Actual time " + std::to_string(actualTime));
                         }
                     }
                 }
                 // if actual time is bigger then time where mode starts, time for ending mode and time for ending off sequence is not needed anymore
-                if (millis() > timeStartMode && timeStartMode >= 0)
+                if (actualTime > *timeStartMode)
                 {
-                    timeEndMode = -1;
+                    timeEndMode.reset();
                 }
             }
 
             if (activeMode != nullptr)
             {
-                unsigned long actualTime = millis();
-                if (timeStartMode >= 0 && actualTime >= GetTimeStartOn() && actualTime <= timeStartMode)
+                if (timeStartMode && actualTime >= *GetTimeStartOn() && actualTime <= *timeStartMode)
                 {
                     // Run on sequence
-                    value = on.GetValue(actualTime - GetTimeStartOn());
+                    running = on.get();
+                    cursor = &onCursor;
+                    sequenceStart = *GetTimeStartOn();
                 }
-                else if (timeStartMode >= 0 && actualTime >= timeStartMode && (timeEndMode < 0 || actualTime <= timeEndMode))
+                else if (timeStartMode && actualTime >= *timeStartMode && (!timeEndMode || actualTime <= *timeEndMode))
                 {
                     // Run Mode
-                    value = activeMode->GetValue(actualTime - timeStartMode);
+                    running = &activeMode->GetSequence();
+                    cursor = &activeMode->GetCursor();
+                    sequenceStart = *timeStartMode;
                 }
-                else if (timeEndMode >= 0 && actualTime >= timeEndMode && actualTime <= GetTimeEndOff())
+                else if (timeEndMode && actualTime >= *timeEndMode && actualTime <= *GetTimeEndOff())
                 {
                     // Run off sequence
-                    value = off.GetValue(actualTime - timeEndMode);
+                    running = off.get();
+                    cursor = &offCursor;
+                    sequenceStart = *timeEndMode;
                 }
-                else if (timeEndMode >= 0 && actualTime >= GetTimeEndOff())
+                else if (timeEndMode && actualTime >= *GetTimeEndOff())
                 {
                     // Off
                     value = 0;
                     activate.SetValue(false);
-                    timeEndMode = -1;
+                    timeEndMode.reset();
                     if (nextActiveMode != nullptr)
                     {
                         activeMode = nullptr;
+                        // Next mode is taken on the next loop
+                        nextChange = actualTime;
+                    }
+                }
+                // Transitions between waiting, on-sequence, mode, off-sequence and off (branches above switch after these times)
+                for (std::optional<uint64_t> transition : {GetTimeStartOn(), timeStartMode ? *timeStartMode + 1 : timeStartMode, timeEndMode ? *timeEndMode + 1 : timeEndMode, timeEndMode ? *GetTimeEndOff() + 1 : timeEndMode})
+                {
+                    if (transition && *transition > actualTime)
+                    {
+                        nextChange = std::min(nextChange.value_or(*transition), *transition);
                     }
                 }
             }
@@ -242,9 +343,111 @@ namespace ModelController
         else
         {
             active = false;
-            timeStartMode = -1;
-            timeEndMode = -1;
+            timeStartMode.reset();
+            timeEndMode.reset();
+        }
+        return value;
+    }
+    //!
+    //! @brief Calculate target value, set value to channel and sleep until the next transition or change of the running sequence
+    //!
+    void SequenceProcessor::Execute()
+    {
+        uint64_t actualTime = Clock::Now();
+        const Sequence* running = nullptr;
+        Sequence::Cursor* cursor = nullptr;
+        uint64_t sequenceStart = 0;
+        std::optional<uint64_t> nextChange;
+        double idleValue = Update(actualTime, running, cursor, sequenceStart, nextChange);
+        double value = idleValue;
+        if (running != nullptr)
+        {
+            value = running->GetValue(actualTime - sequenceStart, *cursor, precision);
+            std::optional<uint64_t> sequenceChange = running->GetNextChange(actualTime - sequenceStart, *cursor, resolution);
+            if (sequenceChange)
+            {
+                nextChange = std::min(nextChange.value_or(UINT64_MAX), sequenceStart + *sequenceChange);
+            }
+        }
+        out.SetValue(value);
+        // Channels share the state above and only evaluate the running sequence, the mode sequence shifted by their phase
+        // (on- and off-sequences run in sync). Without running sequence (off or manual) the value is passed unchanged.
+        for (Channel& channel : channels)
+        {
+            double channelValue = idleValue;
+            if (running != nullptr)
+            {
+                if (channel.sequence != running)
+                {
+                    channel.sequence = running;
+                    channel.cursor = Sequence::Cursor();
+                }
+                // Cursor identifies the mode sequence, on- and off-sequences may share the same sequence object
+                uint64_t phase = cursor == &activeMode->GetCursor() ? channel.phase : 0;
+                uint64_t channelTime = actualTime - sequenceStart + phase;
+                channelValue = running->GetValue(channelTime, channel.cursor, precision);
+                std::optional<uint64_t> channelChange = running->GetNextChange(channelTime, channel.cursor, resolution);
+                if (channelChange)
+                {
+                    nextChange = std::min(nextChange.value_or(UINT64_MAX), sequenceStart + *channelChange - phase);
+                }
+                channelValue = channel.gain * (channel.invert ? 100 - channelValue : channelValue);
+            }
+            channel.out->SetValue(channelValue);
+        }
+        // Inputs wake the processor, if nothing is scheduled
+        if (nextChange)
+        {
+            loopListener.Sleep(*nextChange);
         }
+        else
+        {
+            loopListener.Sleep();
+        }
+    }
+    //!
+    //! @brief Wake own listener or let the engine refresh the lane on its next pass
+    //!
+    void SequenceProcessor::Wake()
+    {
+        if (batch)
+        {
+            SequenceEngine::Invalidate(this);
+        }
+        else
+        {
+            loopListener.Wake();
+        }
+    }
+    //!
+    //! @brief Update state and return the piece of the running sequence in absolute time, limited by the next transition
+    //!
+    Sequence::Piece SequenceProcessor::Refresh(uint64_t time)
+    {
+        constexpr uint64_t infinite = std::numeric_limits<uint64_t>::max();
+        const Sequence* running = nullptr;
+        Sequence::Cursor* cursor = nullptr;
+        uint64_t sequenceStart = 0;
+        std::optional<uint64_t> nextChange;
+        Sequence::Piece piece;
+        piece.start = time;
+        piece.from = Update(time, running, cursor, sequenceStart, nextChange);
+        piece.end = nextChange.value_or(infinite);
+        if (running != nullptr)
+        {
+            Sequence::Piece sequencePiece = running->GetPiece(time - sequenceStart, *cursor);
+            piece.start = sequenceStart + sequencePiece.start;
+            piece.end = sequencePiece.end == infinite ? piece.end : std::min(piece.end, sequenceStart + sequencePiece.end);
+            piece.from = sequencePiece.from;
+            piece.slope = sequencePiece.slope;
+        }
+        return piece;
+    }
+    //!
+    //! @brief Set value calculated by the engine to the output
+    //!
+    void SequenceProcessor::SetOutput(double value)
+    {
         out.SetValue(value);
     }
 
@@ -7,6 +7,7 @@
 //!
 #include "Utils.hpp"
 #include "esp_random.h"
+#include <cstdio>
 #include "Logger.hpp"
 
 namespace ModelController
@@ -61,12 +62,27 @@ namespace ModelController
         return value.size() >= check.size() ? value.find(check.c_str(), value.size() - check.size()) == value.size() - check.size() : false;
     }
     //!
+    //! @brief Increase the precision until strtod returns the value again
+    //!
+    std::string Utils::ToExactString(double value)
+    {
+        char buffer[32];
+        int precision = 6;
+        snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        while (precision < 17 && strtod(buffer, nullptr) != value)
+        {
+            precision++;
+            snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        }
+        return buffer;
+    }
+    //!
     //! @brief Returns randum number with specified length
     //!
     std::string Utils::GetRandomNumber(int length)
     {
         std::string random = std::to_string(esp_random());
-        if (random.size() >= length)
+        if (random.size() >= static_cast<size_t>(length))
         {
             random = random.substr(0, length);
         }
@@ -0,0 +1,296 @@
+//!
+//! @file ValueStream.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Implementation of the ValueStream
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include "ValueStream.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+
+namespace ModelController
+{
+    //!
+    //! @brief WebSocket the subscribers are connected to
+    //!
+    AsyncWebSocket ValueStream::socket("/Stream");
+    //!
+    //! @brief Subscribers by client id
+    //!
+    std::map<uint32_t, ValueStream::Subscriber> ValueStream::subscribers;
+    //!
+    //! @brief Latest values of the changed ports
+    //!
+    std::map<std::string, ValueStream::Value> ValueStream::values;
+    //!
+    //! @brief Values changed in the actual loop tick
+    //!
+    std::vector<std::map<std::string, ValueStream::Value>::iterator> ValueStream::changes;
+    //!
+    //! @brief Document the changed values are read into
+    //!
+    JsonDocument ValueStream::valueDocument;
+    //!
+    //! @brief Serialized frames waiting to be sent
+    //!
+    std::map<uint32_t, std::string> ValueStream::outbox;
+    //!
+    //! @brief Lock of the outbox
+    //!
+    std::mutex ValueStream::outboxMutex;
+    //!
+    //! @brief Listener called periodically, only while clients are subscribed
+    //!
+    LoopEvent::LoopListener* ValueStream::loopListener = nullptr;
+    //!
+    //! @brief Listener to changed outputs
+    //!
+    Event<IModuleOut*>::Listener* ValueStream::onModuleOutChanged = nullptr;
+    //!
+    //! @brief Listener to changed inputs
+    //!
+    Event<IModuleIn*>::Listener* ValueStream::onModuleInChanged = nullptr;
+    //!
+    //! @brief Post connects, disconnects and complete text messages to the loop and send waiting frames
+    //!
+    //! The frame of a disconnected client is dropped under the lock, so the socket can delete the client after this event
+    //!
+    void ValueStream::OnEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t length)
+    {
+        uint32_t id = client->id();
+        if (type == WS_EVT_CONNECT)
+        {
+            Logger::debug("ValueStream: Client " + std::to_string(id) + " connected");
+            server->cleanupClients();
+            LoopEvent::Post([id](){ subscribers[id]; UpdateListeners(); });
+        }
+        else if (type == WS_EVT_DISCONNECT)
+        {
+            Logger::debug("ValueStream: Client " + std::to_string(id) + " disconnected");
+            {
+                std::lock_guard<std::mutex> lock(outboxMutex);
+                outbox.erase(id);
+            }
+            LoopEvent::Post([id]()
+            {
+                subscribers.erase(id);
+                {
+                    // Process may have added a frame before the subscriber was removed
+                    std::lock_guard<std::mutex> lock(outboxMutex);
+                    outbox.erase(id);
+                }
+                UpdateListeners();
+            });
+        }
+        else if (type == WS_EVT_DATA)
+        {
+            AwsFrameInfo* info = static_cast<AwsFrameInfo*>(arg);
+            if (info->final && info->index == 0 && info->len == length && info->opcode == WS_TEXT)
+            {
+                std::string message(reinterpret_cast<char*>(data), length);
+                LoopEvent::Post([id, message](){ OnMessage(id, message); });
+            }
+            Flush();
+        }
+    }
+    //!
+    //! @brief Add/remove prefixes and set interval of the subscriber
+    //!
+    void ValueStream::OnMessage(uint32_t id, std::string message)
+    {
+        std::map<uint32_t, Subscriber>::iterator it = subscribers.find(id);
+        JsonDocument doc;
+        if (it != subscribers.end() && !deserializeJson(doc, message) && doc.is<JsonObject>())
+        {
+            Subscriber& subscriber = it->second;
+            for (JsonVariant prefix : doc["subscribe"].as<JsonArray>())
+            {
+                subscriber.prefixes.push_back(prefix.as<std::string>());
+            }
+            for (JsonVariant prefix : doc["unsubscribe"].as<JsonArray>())
+            {
+                std::string path = prefix.as<std::string>();
+                subscriber.prefixes.erase(std::remove(subscriber.prefixes.begin(), subscriber.prefixes.end(), path), subscriber.prefixes.end());
+            }
+            if (doc["interval"].is<unsigned long>())
+            {
+                unsigned long interval = doc["interval"].as<unsigned long>();
+                subscriber.interval = interval < minInterval ? minInterval : interval;
+            }
+            Logger::debug("ValueStream: Client " + std::to_string(id) + " subscribed to " + std::to_string(subscriber.prefixes.size()) + " prefixes");
+        }
+    }
+    //!
+    //! @brief Listen to changed values and the loop only while clients are connected
+    //!
+    void ValueStream::UpdateListeners()
+    {
+        if (subscribers.empty())
+        {
+            delete onModuleOutChanged;
+            onModuleOutChanged = nullptr;
+            delete onModuleInChanged;
+            onModuleInChanged = nullptr;
+            delete loopListener;
+            loopListener = nullptr;
+            changes.clear();
+            values.clear();
+            std::lock_guard<std::mutex> lock(outboxMutex);
+            outbox.clear();
+        }
+        else if (onModuleOutChanged == nullptr)
+        {
+            loopListener = new LoopEvent::LoopListener([](){ Process(); });
+            onModuleOutChanged = new Event<IModuleOut*>::Listener(&IModuleOut::ModuleOutChanged, [](IModuleOut* output)
+            {
+                output->GetJsonValue(valueDocument.to<JsonVariant>());
+                OnValueChanged(output->GetPath(), valueDocument.as<JsonVariant>());
+            });
+            onModuleInChanged = new Event<IModuleIn*>::Listener(&IModuleIn::ModuleInChanged, [](IModuleIn* input)
+            {
+                input->GetJsonValue(valueDocument.to<JsonVariant>());
+                OnValueChanged(input->GetPath(), valueDocument.as<JsonVariant>());
+            });
+        }
+    }
+    //!
+    //! @brief Compare the start and check that the prefix is followed by a '/' in the path (or ends with one)
+    //!
+    bool ValueStream::Matches(const std::string& path, const std::string& prefix)
+    {
+        return path.compare(0, prefix.size(), prefix) == 0
+            && (path.size() == prefix.size() || prefix.empty() || prefix.back() == '/' || path[prefix.size()] == '/');
+    }
+    //!
+    //! @brief Serialize value into the string of the path, later changes of the same path in this tick replace it
+    //!
+    void ValueStream::OnValueChanged(const std::string& path, JsonVariant value)
+    {
+        std::map<std::string, Value>::iterator it = values.find(path);
+        if (it == values.end())
+        {
+            it = values.emplace(path, Value()).first;
+        }
+        if (!it->second.changed)
+        {
+            it->second.changed = true;
+            changes.push_back(it);
+        }
+        it->second.serialized.clear();
+        serializeJson(value, it->second.serialized);
+    }
+    //!
+    //! @brief Quote text and escape quotes, backslashes and control characters
+    //!
+    void ValueStream::AppendString(std::string& buffer, const std::string& text)
+    {
+        static constexpr char hex[] = "0123456789abcdef";
+        buffer += '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                buffer += '\\';
+                buffer += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                buffer += "\\u00";
+                buffer += hex[c >> 4];
+                buffer += hex[c & 0xF];
+            }
+            else
+            {
+                buffer += c;
+            }
+        }
+        buffer += '"';
+    }
+    //!
+    //! @brief Merge changes into pending values of matching subscribers, create frames respecting the interval,
+    //! serialize the next frame of each subscriber without a waiting frame into the outbox and flush it
+    //!
+    void ValueStream::Process()
+    {
+        unsigned long now = millis();
+        for (std::pair<const uint32_t, Subscriber>& kvp : subscribers)
+        {
+            Subscriber& subscriber = kvp.second;
+            for (std::map<std::string, Value>::iterator change : changes)
+            {
+                for (std::string& prefix : subscriber.prefixes)
+                {
+                    if (Matches(change->first, prefix))
+                    {
+                        subscriber.pending[change->first] = change->second.serialized;
+                        break;
+                    }
+                }
+            }
+            if (!subscriber.pending.empty() && now - subscriber.lastFrame >= subscriber.interval)
+            {
+                subscriber.frames.push_back(std::move(subscriber.pending));
+                subscriber.pending.clear();
+                subscriber.lastFrame = now;
+                if (subscriber.frames.size() > maxFrames)
+                {
+                    // Values of the next frame are newer, the oldest frame only adds paths missing there
+                    subscriber.frames[1].merge(subscriber.frames.front());
+                    subscriber.frames.pop_front();
+                    subscriber.coalesced++;
+                }
+            }
+        }
+        for (std::map<std::string, Value>::iterator change : changes)
+        {
+            change->second.changed = false;
+        }
+        changes.clear();
+        {
+            std::lock_guard<std::mutex> lock(outboxMutex);
+            for (std::pair<const uint32_t, Subscriber>& kvp : subscribers)
+            {
+                std::string& message = outbox[kvp.first];
+                if (message.empty() && !kvp.second.frames.empty())
+                {
+                    // Values are serialized already, the frame is the object of them
+                    message += '{';
+                    for (std::pair<const std::string, std::string>& value : kvp.second.frames.front())
+                    {
+                        message += message.size() > 1 ? "," : "";
+                        AppendString(message, value.first);
+                        message += ':';
+                        message += value.second;
+                    }
+                    message += '}';
+                    kvp.second.frames.pop_front();
+                }
+            }
+        }
+        Flush();
+    }
+    //!
+    //! @brief Send frames of clients with space in their queue, the socket looks the clients up by their id
+    //!
+    void ValueStream::Flush()
+    {
+        std::lock_guard<std::mutex> lock(outboxMutex);
+        for (std::pair<const uint32_t, std::string>& message : outbox)
+        {
+            if (!message.second.empty() && socket.availableForWrite(message.first))
+            {
+                socket.text(message.first, message.second.c_str(), message.second.size());
+                message.second.clear();
+            }
+        }
+    }
+    //!
+    //! @brief Register WebSocket (listeners are created with the first subscriber)
+    //!
+    void ValueStream::Initialize(AsyncWebServer& server)
+    {
+        socket.onEvent(OnEvent);
+        server.addHandler(&socket);
+    }
+} // namespace ModelController
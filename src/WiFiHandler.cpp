@@ -7,30 +7,158 @@
 //!
 #include "WiFiHandler.hpp"
 #include "Logger.hpp"
+#include "Metrics.hpp"
+#include <LittleFS.h>
 
 unsigned long WiFiHandler::timeout = 5000;
 unsigned long WiFiHandler::timeStarted = 0;
 int WiFiHandler::reconnects = 0;
 int WiFiHandler::reconnectsBeforeFail = 5;
-bool WiFiHandler::activeAP = false;
 std::string WiFiHandler::ssid = "Controller";
 std::string WiFiHandler::password = "Controller";
-bool WiFiHandler::staConnected = false;
-ModelController::Event<> WiFiHandler::STAConnected;
-ModelController::Event<> WiFiHandler::APInitialized;
+WiFiHandler::State WiFiHandler::state = WiFiHandler::State::eDisconnected;
+unsigned long WiFiHandler::stateChanged = 0;
+std::atomic<bool> WiFiHandler::linkUp(false);
+std::atomic<unsigned long> WiFiHandler::linkChanged(0);
+bool WiFiHandler::eventsRegistered = false;
+WiFiHandler::ConnectionCache WiFiHandler::cache;
+bool WiFiHandler::cacheLoaded = false;
+bool WiFiHandler::fastAttempt = false;
+bool WiFiHandler::fastConnect = true;
+bool WiFiHandler::reuseLease = false;
+IPAddress WiFiHandler::staticIP;
+IPAddress WiFiHandler::staticGateway;
+IPAddress WiFiHandler::staticSubnet;
+IPAddress WiFiHandler::staticDNS;
+ModelController::Event<> WiFiHandler::STAConnected("wifi_sta_connected");
+ModelController::Event<> WiFiHandler::APInitialized("wifi_ap_initialized");
 
 //!
-//! @brief Disconnect from WiFi and restart with new settings
+//! @brief Store link state and time, the transition is handled by the loop in Check()
 //!
-void WiFiHandler::BeginSTA(const char* ssid, const char* password)
+void WiFiHandler::OnWiFiEvent(arduino_event_id_t event, arduino_event_info_t)
 {
+    if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP)
+    {
+        linkChanged.store(millis(), std::memory_order_relaxed);
+        linkUp.store(true, std::memory_order_release);
+    }
+    else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED || event == ARDUINO_EVENT_WIFI_STA_LOST_IP)
+    {
+        linkChanged.store(millis(), std::memory_order_relaxed);
+        linkUp.store(false, std::memory_order_release);
+    }
+}
+//!
+//! @brief Set state and time of the transition
+//!
+void WiFiHandler::SetState(State newState, unsigned long time)
+{
+    state = newState;
+    stateChanged = time;
+}
+//!
+//! @brief Read cache with fixed layout, cache stays empty if file is missing or has another size
+//!
+void WiFiHandler::LoadCache()
+{
+    if (!cacheLoaded)
+    {
+        cacheLoaded = true;
+        File file = LittleFS.open(cacheFile, "r");
+        if (file)
+        {
+            ConnectionCache loaded;
+            if (file.read(reinterpret_cast<uint8_t*>(&loaded), sizeof(loaded)) == sizeof(loaded))
+            {
+                loaded.ssid[sizeof(loaded.ssid) - 1] = '\0';
+                cache = loaded;
+            }
+            file.close();
+        }
+    }
+}
+//!
+//! @brief Compare with cache and write only changes to spare the flash
+//!
+void WiFiHandler::SaveCache()
+{
+    ConnectionCache actual;
+    strncpy(actual.ssid, ssid.c_str(), sizeof(actual.ssid) - 1);
+    const uint8_t* bssid = WiFi.BSSID();
+    if (bssid != nullptr)
+    {
+        memcpy(actual.bssid, bssid, sizeof(actual.bssid));
+    }
+    actual.channel = WiFi.channel();
+    actual.ip = WiFi.localIP();
+    actual.gateway = WiFi.gatewayIP();
+    actual.subnet = WiFi.subnetMask();
+    actual.dns = WiFi.dnsIP();
+    if (!(actual == cache))
+    {
+        File file = LittleFS.open(cacheFile, "w");
+        if (file)
+        {
+            file.write(reinterpret_cast<const uint8_t*>(&actual), sizeof(actual));
+            file.close();
+            cache = actual;
+            Logger::debug("WiFi: Cached BSSID and channel " + std::to_string(actual.channel));
+        }
+    }
+    cacheLoaded = true;
+}
+//!
+//! @brief Configure static IP, cached lease or DHCP and begin with cached BSSID and channel or with full scan
+//!
+void WiFiHandler::Connect(bool fast)
+{
+    LoadCache();
+    fastAttempt = fast && fastConnect && cache.channel > 0 && ssid == cache.ssid;
+    WiFi.disconnect();
+    if (static_cast<uint32_t>(staticIP) != 0)
+    {
+        WiFi.config(staticIP, staticGateway, staticSubnet, staticDNS);
+    }
+    else if (fastAttempt && reuseLease && cache.ip != 0)
+    {
+        WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+    }
+    else
+    {
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    }
+    if (fastAttempt)
+    {
+        Logger::debug("WiFi: Connecting to cached access point on channel " + std::to_string(cache.channel));
+        WiFi.begin(ssid.c_str(), password.c_str(), cache.channel, cache.bssid);
+    }
+    else
+    {
+        Logger::debug("WiFi: Connecting to WiFi");
+        WiFi.begin(ssid.c_str(), password.c_str());
+    }
+    ModelController::Metrics::wifiConnectAttempts.Increment();
+    timeStarted = millis();
+}
+//!
+//! @brief Disconnect from WiFi and restart with the actual SSID and password
+//!
+void WiFiHandler::BeginSTA()
+{
+    if (!eventsRegistered)
+    {
+        WiFi.onEvent(OnWiFiEvent);
+        eventsRegistered = true;
+    }
     reconnects = 0;
-    staConnected = false;
     WiFi.disconnect();
+    linkUp.store(false, std::memory_order_relaxed);
     WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid, password);
-    timeStarted = millis();
-    Logger::debug("WiFi: Connecting to WiFi");
+    // Reconnects are started by Check(), to try the cached access point first
+    WiFi.setAutoReconnect(false);
+    Connect(true);
+    SetState(State::eConnecting, timeStarted);
 }
 //!
 //! @brief Start AP with default values
@@ -44,7 +172,6 @@ bool WiFiHandler::BeginAP()
 //!
 bool WiFiHandler::BeginAP(const char* ssid, const char* password)
 {
-    staConnected = false;
     bool success = false;
     reconnects = 0;
     WiFi.disconnect();
@@ -62,77 +189,139 @@ bool WiFiHandler::BeginAP(const char* ssid, const char* password)
         APInitialized.Raise();
         success = true;
     }
+    SetState(success ? State::eAccessPoint : State::eDisconnected, millis());
     return success;
 }
 //!
-//! @brief Check if WiFi is connected
+//! @brief Compare cached link state with state, the WiFi driver is only called on timeouts
 //!
 bool WiFiHandler::Check()
 {
-    bool retVal = false;
-    //!
-    //! @brief Check WiFi mode
-    //!
-    if (WiFi.getMode() == WIFI_STA)
+    bool up = linkUp.load(std::memory_order_acquire);
+    switch (state)
     {
-        //!
-        //! @brief Return true if WiFi-Station is connected
-        //!
-        if (WiFi.status() == WL_CONNECTED)
-        {
-            timeStarted = millis();
-            retVal = true;
-            reconnects = 0;
-            if (!staConnected)
+        case State::eConnecting:
+            if (up)
             {
-                Logger::info("WiFi: STA Connected IP:" + std::string(WiFi.localIP().toString().c_str()) + " Hostname: " + WiFi.getHostname());
+                unsigned long connected = linkChanged.load(std::memory_order_relaxed);
+                ModelController::Metrics::wifiConnectTime.Set(connected - stateChanged);
+                ModelController::Metrics::wifiAttemptTime.Set(connected - timeStarted);
+                SetState(State::eConnected, connected);
+                reconnects = 0;
+                Logger::info("WiFi: STA Connected IP:" + std::string(WiFi.localIP().toString().c_str()) + " Hostname: " + WiFi.getHostname()
+                    + " after " + std::to_string(connected - timeStarted) + " ms (" + (fastAttempt ? "cached access point" : "scan") + ")");
+                SaveCache();
                 STAConnected.Raise();
-                staConnected = true;
             }
-        }
-        else if (millis() > timeStarted + timeout)
-        {
-            staConnected = false;
-            //!
-            //! @brief Reconnect if WiFi-Station is not connected
-            //!
-            if (++reconnects > reconnectsBeforeFail)
+            else if (millis() - timeStarted > timeout)
             {
-                retVal = activeAP = BeginAP();
+                //!
+                //! @brief Scan, if cached access point didn't answer (doesn't count as reconnect)
+                //!
+                if (fastAttempt)
+                {
+                    Logger::warning("WiFi: Cached access point not reachable, scanning");
+                    ModelController::Metrics::wifiFastConnectFailed.Increment();
+                    Connect(false);
+                }
+                //!
+                //! @brief Start AP if WiFi connection could not be restarted
+                //!
+                else if (++reconnects > reconnectsBeforeFail)
+                {
+                    BeginAP();
+                }
+                //!
+                //! @brief Reconnect if WiFi-Station is not connected
+                //!
+                else
+                {
+                    Logger::warning("WiFi: Try Reconnect");
+                    Connect(false);
+                }
             }
-            //!
-            //! @brief Start STA if WiFi connection could not be restarted
-            //!
-            else
+            break;
+        case State::eConnected:
+            if (!up)
             {
-                Logger::warning("WiFi: Try Reconnect");
-                retVal = false;
-                WiFi.reconnect();
-                timeStarted = millis();
+                // Time until reconnected is measured from the loss of the link
+                SetState(State::eConnecting, linkChanged.load(std::memory_order_relaxed));
+                ModelController::Metrics::wifiDisconnects.Increment();
+                Logger::warning("WiFi: STA Disconnected");
+                Connect(true);
             }
-        }
-        else
-        {
-            staConnected = false;
-            retVal = false;
-        }
+            break;
+        case State::eDisconnected:
+            BeginAP();
+            break;
+        default:
+            break;
+    }
+    return state == State::eConnected || state == State::eAccessPoint;
+}
+//!
+//! @brief Returns true if state is connected
+//!
+bool WiFiHandler::IsConnected()
+{
+    return state == State::eConnected;
+}
+//!
+//! @brief Returns state
+//!
+WiFiHandler::State WiFiHandler::GetState()
+{
+    return state;
+}
+//!
+//! @brief Returns time of the last state transition
+//!
+unsigned long WiFiHandler::GetStateChanged()
+{
+    return stateChanged;
+}
+//!
+//! @brief Parse static IP and options, restart STA if only the static IP changed, else let SetSSIDPassword decide
+//!
+void WiFiHandler::SetConfig(JsonObject config)
+{
+    IPAddress ip;
+    IPAddress gateway;
+    IPAddress subnet(255, 255, 255, 0);
+    IPAddress dns;
+    if (!ip.fromString(config["ip"] | ""))
+    {
+        ip = IPAddress();
+    }
+    if (!gateway.fromString(config["gateway"] | ""))
+    {
+        gateway = ip;
+    }
+    subnet.fromString(config["subnet"] | "");
+    if (!dns.fromString(config["dns"] | ""))
+    {
+        dns = gateway;
+    }
+    bool ipChanged = static_cast<uint32_t>(ip) != static_cast<uint32_t>(staticIP)
+        || static_cast<uint32_t>(gateway) != static_cast<uint32_t>(staticGateway)
+        || static_cast<uint32_t>(subnet) != static_cast<uint32_t>(staticSubnet)
+        || static_cast<uint32_t>(dns) != static_cast<uint32_t>(staticDNS);
+    staticIP = ip;
+    staticGateway = gateway;
+    staticSubnet = subnet;
+    staticDNS = dns;
+    fastConnect = config["fastConnect"] | true;
+    reuseLease = config["reuseLease"] | false;
+    std::string newSSID = config["ssid"] | ssid;
+    std::string newPassword = config["password"] | password;
+    if (ipChanged && newSSID == ssid && newPassword == password && (state == State::eConnecting || state == State::eConnected))
+    {
+        BeginSTA();
     }
     else
     {
-        staConnected = false;
-        //!
-        //! @brief Return true if AP is active/started successfully
-        //!
-        if (activeAP)
-        {
-            retVal = true;
-        }
-        else
-        {
-            retVal = activeAP = BeginAP();
-        }
+        SetSSIDPassword(newSSID, newPassword);
     }
-    return retVal;
 }
 //!
 //! @brief Set ssid and password and begin STA, if they changed
@@ -143,11 +332,11 @@ void WiFiHandler::SetSSIDPassword(std::string ssid, std::string password)
     {
         WiFiHandler::ssid = ssid;
         WiFiHandler::password = password;
-        BeginSTA(ssid.c_str(), password.c_str());
+        BeginSTA();
     }
-    else if (WiFi.getMode() != WIFI_STA)
+    else if (state == State::eAccessPoint || state == State::eDisconnected)
     {
-        BeginSTA(ssid.c_str(), password.c_str());
+        BeginSTA();
     }
 }
 //!
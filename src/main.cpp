@@ -5,11 +5,13 @@
 #include "Logger.hpp"
 #include "ConfigFile.hpp"
 #include "ConfigAPI.hpp"
+#include "Metrics.hpp"
 
 void setup()
 {
     Serial.begin(115200);
     Logger::info("started");
+    ModelController::LoopEvent::SetPeriodObserver([](uint32_t period){ ModelController::Metrics::loopPeriod.Observe(period); });
 
     // Check if Filesystem was initialized
     if (!LittleFS.begin(false, ""))
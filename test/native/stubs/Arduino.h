@@ -0,0 +1,153 @@
+//!
+//! @file Arduino.h
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Minimal Arduino API for native tests, time is derived from the Clock
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Clock.hpp"
+#include "esp_random.h"
+
+//!
+//! @brief Milliseconds since boot, wrapping at 2^32 like on the ESP32
+//!
+//! @return uint32_t Time in milliseconds
+//!
+inline uint32_t millis()
+{
+    return static_cast<uint32_t>(ModelController::Clock::Now() / 1000);
+}
+//!
+//! @brief Microseconds since boot, wrapping at 2^32 like on the ESP32
+//!
+//! @return uint32_t Time in microseconds
+//!
+inline uint32_t micros()
+{
+    return static_cast<uint32_t>(ModelController::Clock::Now());
+}
+//!
+//! @brief Byte type of the Arduino API
+//!
+typedef uint8_t byte;
+//!
+//! @brief Boolean type of the Arduino API
+//!
+typedef bool boolean;
+//!
+//! @brief Serial port discarding all output
+//!
+struct SerialStub
+{
+    //!
+    //! @brief Ignore baud rate
+    //!
+    void begin(unsigned long) { }
+    //!
+    //! @brief Discard text
+    //!
+    void print(const char*) { }
+    //!
+    //! @brief Discard line
+    //!
+    void println(const char*) { }
+};
+//!
+//! @brief Serial port used by the Logger
+//!
+inline SerialStub Serial;
+//!
+//! @brief Heap statistics of the ESP32, fixed values on the host
+//!
+struct EspStub
+{
+    //!
+    //! @brief Free heap in bytes
+    //!
+    uint32_t getFreeHeap() { return 200000; }
+    //!
+    //! @brief Minimum free heap since boot in bytes
+    //!
+    uint32_t getMinFreeHeap() { return 150000; }
+    //!
+    //! @brief Largest allocatable block in bytes
+    //!
+    uint32_t getMaxAllocHeap() { return 100000; }
+};
+//!
+//! @brief Chip of the ESP32
+//!
+inline EspStub ESP;
+//!
+//! @brief Duties written to the LEDC channels by ledcWrite (read by tests)
+//!
+inline uint32_t ledcDuties[16] = {};
+//!
+//! @brief Configure LEDC channel, returns the frequency
+//!
+inline double ledcSetup(uint8_t, double frequency, uint8_t)
+{
+    return frequency;
+}
+//!
+//! @brief Attach pin to a LEDC channel (no hardware on the host)
+//!
+inline void ledcAttachPin(uint8_t, uint8_t) { }
+//!
+//! @brief Detach pin from its LEDC channel (no hardware on the host)
+//!
+inline void ledcDetachPin(uint8_t) { }
+//!
+//! @brief Store duty of the LEDC channel
+//!
+inline void ledcWrite(uint8_t channel, uint32_t duty)
+{
+    ledcDuties[channel % 16] = duty;
+}
+//!
+//! @brief Result of a successful task creation
+//!
+constexpr int pdPASS = 1;
+//!
+//! @brief True if created tasks wait for RunPendingTasks() (a slow task), else they run synchronously
+//!
+inline bool deferTasks = false;
+//!
+//! @brief Tasks created while deferTasks is set, with their parameter
+//!
+inline std::vector<std::pair<void (*)(void*), void*>> pendingTasks;
+//!
+//! @brief Run the task synchronously or keep it for RunPendingTasks(), it returns after calling vTaskDelete
+//!
+inline int xTaskCreate(void (*task)(void*), const char*, uint32_t, void* parameter, unsigned int, void*)
+{
+    if (deferTasks)
+    {
+        pendingTasks.emplace_back(task, parameter);
+    }
+    else
+    {
+        task(parameter);
+    }
+    return pdPASS;
+}
+//!
+//! @brief Run the tasks kept while deferTasks was set
+//!
+inline void RunPendingTasks()
+{
+    std::vector<std::pair<void (*)(void*), void*>> tasks;
+    tasks.swap(pendingTasks);
+    for (std::pair<void (*)(void*), void*>& task : tasks)
+    {
+        task.first(task.second);
+    }
+}
+//!
+//! @brief End of a task, the task function returns on the host
+//!
+inline void vTaskDelete(void*) { }
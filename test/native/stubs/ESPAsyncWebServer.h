@@ -0,0 +1,260 @@
+//!
+//! @file ESPAsyncWebServer.h
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief WebSocket server for native tests, the test connects clients and reads the messages sent to them
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+//!
+//! @brief Opcode of text frames
+//!
+#define WS_TEXT 0x01
+
+//!
+//! @brief Events of the WebSocket
+//!
+enum AwsEventType
+{
+    WS_EVT_CONNECT,
+    WS_EVT_DISCONNECT,
+    WS_EVT_PONG,
+    WS_EVT_ERROR,
+    WS_EVT_DATA,
+};
+
+//!
+//! @brief Status of a WebSocket client
+//!
+enum AwsClientStatus
+{
+    WS_DISCONNECTED,
+    WS_CONNECTED,
+    WS_DISCONNECTING,
+};
+
+//!
+//! @brief Info of a received frame
+//!
+struct AwsFrameInfo
+{
+    //!
+    //! @brief Opcode of the message
+    //!
+    uint8_t message_opcode = WS_TEXT;
+    //!
+    //! @brief Number of the frame in the message
+    //!
+    uint32_t num = 0;
+    //!
+    //! @brief True for the last frame of the message
+    //!
+    uint8_t final = 1;
+    //!
+    //! @brief True if the frame is masked (always for clients)
+    //!
+    uint8_t masked = 1;
+    //!
+    //! @brief Opcode of the frame
+    //!
+    uint8_t opcode = WS_TEXT;
+    //!
+    //! @brief Length of the frame
+    //!
+    uint64_t len = 0;
+    //!
+    //! @brief Mask of the frame
+    //!
+    uint8_t mask[4] = {};
+    //!
+    //! @brief Offset of the data in the frame
+    //!
+    uint64_t index = 0;
+};
+
+//!
+//! @brief Client of the WebSocket, stores the messages sent to it
+//!
+class AsyncWebSocketClient
+{
+private:
+    //!
+    //! @brief Id of the client
+    //!
+    uint32_t clientId;
+
+public:
+    //!
+    //! @brief Status of the connection
+    //!
+    AwsClientStatus clientStatus = WS_CONNECTED;
+    //!
+    //! @brief True if the queue of the client has space (false for a slow client)
+    //!
+    bool writable = true;
+    //!
+    //! @brief Messages sent to the client in order
+    //!
+    std::vector<std::string> messages;
+    //!
+    //! @brief Construct a connected client
+    //!
+    explicit AsyncWebSocketClient(uint32_t id)
+        : clientId(id)
+    { }
+    //!
+    //! @brief Id of the client
+    //!
+    uint32_t id() const
+    {
+        return clientId;
+    }
+    //!
+    //! @brief Status of the connection
+    //!
+    AwsClientStatus status() const
+    {
+        return clientStatus;
+    }
+    //!
+    //! @brief Store the message
+    //!
+    void text(const char* message, size_t length)
+    {
+        messages.emplace_back(message, length);
+    }
+};
+
+class AsyncWebSocket;
+
+//!
+//! @brief Handler of the WebSocket events
+//!
+typedef std::function<void(AsyncWebSocket*, AsyncWebSocketClient*, AwsEventType, void*, uint8_t*, size_t)> AwsEventHandler;
+
+//!
+//! @brief WebSocket, the test connects clients, sends messages and disconnects them like the TCP task
+//!
+class AsyncWebSocket
+{
+private:
+    //!
+    //! @brief Handler of the events
+    //!
+    AwsEventHandler handler;
+    //!
+    //! @brief Connected clients by id
+    //!
+    std::map<uint32_t, std::unique_ptr<AsyncWebSocketClient>> clients;
+    //!
+    //! @brief Id of the next client
+    //!
+    uint32_t nextId = 1;
+
+public:
+    //!
+    //! @brief Construct WebSocket for a path
+    //!
+    explicit AsyncWebSocket(const std::string&) { }
+    //!
+    //! @brief Set handler of the events
+    //!
+    void onEvent(AwsEventHandler handler)
+    {
+        this->handler = handler;
+    }
+    //!
+    //! @brief Get connected client
+    //!
+    //! @return AsyncWebSocketClient* Client, nullptr if it isn't connected
+    //!
+    AsyncWebSocketClient* client(uint32_t id)
+    {
+        std::map<uint32_t, std::unique_ptr<AsyncWebSocketClient>>::iterator it = clients.find(id);
+        return it == clients.end() ? nullptr : it->second.get();
+    }
+    //!
+    //! @brief Check if the queue of the client has space (true for unknown clients like the library)
+    //!
+    bool availableForWrite(uint32_t id)
+    {
+        AsyncWebSocketClient* connected = client(id);
+        return connected == nullptr || connected->writable;
+    }
+    //!
+    //! @brief Send text to a connected client
+    //!
+    void text(uint32_t id, const char* message, size_t length)
+    {
+        AsyncWebSocketClient* connected = client(id);
+        if (connected != nullptr)
+        {
+            connected->text(message, length);
+        }
+    }
+    //!
+    //! @brief Close clients above the limit (no limit on the host)
+    //!
+    void cleanupClients(uint16_t = 8) { }
+    //!
+    //! @brief Connect a new client
+    //!
+    //! @return AsyncWebSocketClient* Connected client
+    //!
+    AsyncWebSocketClient* Connect()
+    {
+        uint32_t id = nextId++;
+        clients[id] = std::make_unique<AsyncWebSocketClient>(id);
+        handler(this, clients[id].get(), WS_EVT_CONNECT, nullptr, nullptr, 0);
+        return clients[id].get();
+    }
+    //!
+    //! @brief Receive a text message from a client
+    //!
+    void Receive(uint32_t id, std::string message)
+    {
+        AwsFrameInfo info;
+        info.len = message.size();
+        handler(this, client(id), WS_EVT_DATA, &info, reinterpret_cast<uint8_t*>(&message[0]), message.size());
+    }
+    //!
+    //! @brief Disconnect a client and delete it after the event
+    //!
+    void Disconnect(uint32_t id)
+    {
+        client(id)->clientStatus = WS_DISCONNECTED;
+        handler(this, client(id), WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+        clients.erase(id);
+    }
+};
+
+//!
+//! @brief Web server holding the WebSockets added to it
+//!
+class AsyncWebServer
+{
+public:
+    //!
+    //! @brief WebSockets added to the server
+    //!
+    std::vector<AsyncWebSocket*> handlers;
+    //!
+    //! @brief Construct server for a port
+    //!
+    explicit AsyncWebServer(uint16_t) { }
+    //!
+    //! @brief Add a WebSocket
+    //!
+    void addHandler(AsyncWebSocket* handler)
+    {
+        handlers.push_back(handler);
+    }
+};
@@ -0,0 +1,187 @@
+//!
+//! @file LittleFS.h
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief In-memory file system for native tests
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+//!
+//! @brief Open file, reads and writes go directly to the content kept by the file system
+//!
+class File
+{
+private:
+    //!
+    //! @brief Content of the file, nullptr if the file isn't open
+    //!
+    std::shared_ptr<std::string> content;
+    //!
+    //! @brief Position of the next read
+    //!
+    size_t position = 0;
+
+public:
+    //!
+    //! @brief Construct a closed file
+    //!
+    File() = default;
+    //!
+    //! @brief Construct an open file
+    //!
+    //! @param content Content of the file
+    //!
+    explicit File(std::shared_ptr<std::string> content)
+        : content(content)
+    { }
+    //!
+    //! @brief Check if the file is open
+    //!
+    explicit operator bool() const
+    {
+        return content != nullptr;
+    }
+    //!
+    //! @brief Read bytes from the actual position
+    //!
+    //! @return size_t Number of bytes read
+    //!
+    size_t read(uint8_t* buffer, size_t length)
+    {
+        size_t count = content == nullptr || position >= content->size() ? 0 : std::min(length, content->size() - position);
+        if (count > 0)
+        {
+            memcpy(buffer, content->data() + position, count);
+            position += count;
+        }
+        return count;
+    }
+    //!
+    //! @brief Read one byte (used by ArduinoJson)
+    //!
+    //! @return int Byte, -1 at the end of the file
+    //!
+    int read()
+    {
+        uint8_t value = 0;
+        return read(&value, 1) == 1 ? value : -1;
+    }
+    //!
+    //! @brief Read bytes (used by ArduinoJson)
+    //!
+    //! @return size_t Number of bytes read
+    //!
+    size_t readBytes(char* buffer, size_t length)
+    {
+        return read(reinterpret_cast<uint8_t*>(buffer), length);
+    }
+    //!
+    //! @brief Append bytes
+    //!
+    //! @return size_t Number of bytes written
+    //!
+    size_t write(const uint8_t* buffer, size_t length)
+    {
+        size_t count = 0;
+        if (content != nullptr)
+        {
+            content->append(reinterpret_cast<const char*>(buffer), length);
+            count = length;
+        }
+        return count;
+    }
+    //!
+    //! @brief Append one byte (used by ArduinoJson)
+    //!
+    //! @return size_t Number of bytes written
+    //!
+    size_t write(uint8_t value)
+    {
+        return write(&value, 1);
+    }
+    //!
+    //! @brief Get the size of the file
+    //!
+    //! @return size_t Size in bytes
+    //!
+    size_t size() const
+    {
+        return content == nullptr ? 0 : content->size();
+    }
+    //!
+    //! @brief Close the file
+    //!
+    void close()
+    {
+        content.reset();
+    }
+};
+
+//!
+//! @brief File system keeping the files in memory until the process ends
+//!
+class LittleFSStub
+{
+public:
+    //!
+    //! @brief Content of the files by path (tests may write and read them directly)
+    //!
+    std::map<std::string, std::shared_ptr<std::string>> files;
+    //!
+    //! @brief Mount the file system
+    //!
+    bool begin(bool = false)
+    {
+        return true;
+    }
+    //!
+    //! @brief Open a file, "w" truncates, "a" appends, "r" fails for missing files
+    //!
+    //! @return File Open file, closed if it doesn't exist for reading
+    //!
+    File open(const char* path, const char* mode)
+    {
+        File file;
+        std::map<std::string, std::shared_ptr<std::string>>::iterator it = files.find(path);
+        if (mode[0] == 'w' || (mode[0] == 'a' && it == files.end()))
+        {
+            files[path] = std::make_shared<std::string>();
+            file = File(files[path]);
+        }
+        else if (it != files.end())
+        {
+            file = File(it->second);
+        }
+        return file;
+    }
+    //!
+    //! @brief Check if a file exists
+    //!
+    bool exists(const char* path)
+    {
+        return files.count(path) > 0;
+    }
+    //!
+    //! @brief Delete a file
+    //!
+    bool remove(const char* path)
+    {
+        return files.erase(path) > 0;
+    }
+};
+
+//!
+//! @brief File system used by the config, the WiFi cache and the MQTT spill file
+//!
+inline LittleFSStub LittleFS;
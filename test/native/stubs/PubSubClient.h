@@ -0,0 +1,213 @@
+//!
+//! @file PubSubClient.h
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief MQTT client for native tests, connected to a stand-in broker controlled by the test
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "WiFi.h"
+
+class PubSubClient;
+
+//!
+//! @brief Stand-in broker shared by all clients, tests switch it on and off and read the traffic
+//!
+struct Broker
+{
+    //!
+    //! @brief True if connects succeed and connections stay up
+    //!
+    bool available = true;
+    //!
+    //! @brief Number of connection attempts
+    //!
+    int connects = 0;
+    //!
+    //! @brief Published messages (topic and payload) in order
+    //!
+    std::vector<std::pair<std::string, std::string>> published;
+    //!
+    //! @brief Raw packets written by the clients (SUBSCRIBE packets of the MQTT client)
+    //!
+    std::vector<std::vector<uint8_t>> packets;
+    //!
+    //! @brief Unsubscribed topics in order
+    //!
+    std::vector<std::string> unsubscribed;
+    //!
+    //! @brief Clients, which connected successfully
+    //!
+    std::vector<PubSubClient*> clients;
+    //!
+    //! @brief Deliver a message to all connected clients like a message received from the broker
+    //!
+    //! @param topic Topic of the message
+    //! @param payload Payload of the message
+    //!
+    void Deliver(const std::string& topic, const std::string& payload);
+};
+
+//!
+//! @brief Broker used by all clients
+//!
+inline Broker broker;
+
+//!
+//! @brief MQTT client connected to the stand-in broker
+//!
+class PubSubClient
+{
+private:
+    //!
+    //! @brief True if connected
+    //!
+    bool isConnected = false;
+    //!
+    //! @brief Callback of received messages
+    //!
+    std::function<void(char*, uint8_t*, unsigned int)> callback;
+    //!
+    //! @brief Buffer of the received topic, reused like the buffer of PubSubClient
+    //!
+    std::string topicBuffer;
+    //!
+    //! @brief Buffer of the received payload, reused like the buffer of PubSubClient
+    //!
+    std::vector<uint8_t> payloadBuffer;
+
+public:
+    //!
+    //! @brief Construct a new client
+    //!
+    PubSubClient(WiFiClient&) { }
+    //!
+    //! @brief Leave the broker
+    //!
+    ~PubSubClient()
+    {
+        broker.clients.erase(std::remove(broker.clients.begin(), broker.clients.end(), this), broker.clients.end());
+    }
+    //!
+    //! @brief Set broker address (the stand-in broker is used)
+    //!
+    PubSubClient& setServer(const char*, uint16_t)
+    {
+        return *this;
+    }
+    //!
+    //! @brief Set callback of received messages
+    //!
+    PubSubClient& setCallback(std::function<void(char*, uint8_t*, unsigned int)> callback)
+    {
+        this->callback = callback;
+        return *this;
+    }
+    //!
+    //! @brief Set size of the message buffer
+    //!
+    bool setBufferSize(uint16_t)
+    {
+        return true;
+    }
+    //!
+    //! @brief Connect to the broker
+    //!
+    bool connect(const char*)
+    {
+        broker.connects++;
+        isConnected = broker.available;
+        if (isConnected && std::find(broker.clients.begin(), broker.clients.end(), this) == broker.clients.end())
+        {
+            broker.clients.push_back(this);
+        }
+        return isConnected;
+    }
+    //!
+    //! @brief Check the connection, which drops while the broker is unavailable
+    //!
+    bool connected()
+    {
+        isConnected = isConnected && broker.available;
+        return isConnected;
+    }
+    //!
+    //! @brief Keep the connection alive
+    //!
+    bool loop()
+    {
+        return connected();
+    }
+    //!
+    //! @brief Publish a message
+    //!
+    bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool)
+    {
+        bool success = connected();
+        if (success)
+        {
+            broker.published.emplace_back(topic, std::string(reinterpret_cast<const char*>(payload), length));
+        }
+        return success;
+    }
+    //!
+    //! @brief Write a raw packet
+    //!
+    size_t write(const uint8_t* buffer, size_t size)
+    {
+        size_t written = 0;
+        if (connected())
+        {
+            broker.packets.emplace_back(buffer, buffer + size);
+            written = size;
+        }
+        return written;
+    }
+    //!
+    //! @brief Unsubscribe from a topic
+    //!
+    bool unsubscribe(const char* topic)
+    {
+        broker.unsubscribed.push_back(topic);
+        return connected();
+    }
+    //!
+    //! @brief State of the connection (-2 for a failed connect like PubSubClient)
+    //!
+    int state()
+    {
+        return isConnected ? 0 : -2;
+    }
+    //!
+    //! @brief Pass a message to the callback, if connected (allocates only, if the buffers need to grow)
+    //!
+    //! @param topic Topic of the message
+    //! @param payload Payload of the message
+    //!
+    void Receive(const std::string& topic, const std::string& payload)
+    {
+        if (connected())
+        {
+            topicBuffer.assign(topic);
+            payloadBuffer.assign(payload.begin(), payload.end());
+            callback(&topicBuffer[0], payloadBuffer.data(), payloadBuffer.size());
+        }
+    }
+};
+
+//!
+//! @brief Pass the message to every client
+//!
+inline void Broker::Deliver(const std::string& topic, const std::string& payload)
+{
+    for (PubSubClient* client : clients)
+    {
+        client->Receive(topic, payload);
+    }
+}
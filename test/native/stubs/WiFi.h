@@ -0,0 +1,276 @@
+//!
+//! @file WiFi.h
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief WiFi driver for native tests, records the calls and raises events on request of the test
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "Arduino.h"
+
+//!
+//! @brief IPv4 address stored in network byte order like on the ESP32
+//!
+class IPAddress
+{
+private:
+    //!
+    //! @brief Address, first octet in the lowest byte
+    //!
+    uint32_t address = 0;
+
+public:
+    //!
+    //! @brief Construct 0.0.0.0
+    //!
+    IPAddress() = default;
+    //!
+    //! @brief Construct from octets
+    //!
+    IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth)
+        : address(first | second << 8 | third << 16 | static_cast<uint32_t>(fourth) << 24)
+    { }
+    //!
+    //! @brief Construct from address in network byte order
+    //!
+    IPAddress(uint32_t address)
+        : address(address)
+    { }
+    //!
+    //! @brief Get address in network byte order
+    //!
+    operator uint32_t() const
+    {
+        return address;
+    }
+    //!
+    //! @brief Parse dotted decimal address
+    //!
+    //! @return true Address was parsed
+    //! @return false Text isn't an address, address is unchanged
+    //!
+    bool fromString(const char* text)
+    {
+        unsigned int octets[4] = {};
+        char end = 0;
+        bool success = sscanf(text, "%u.%u.%u.%u%c", &octets[0], &octets[1], &octets[2], &octets[3], &end) == 4
+            && octets[0] < 256 && octets[1] < 256 && octets[2] < 256 && octets[3] < 256;
+        if (success)
+        {
+            *this = IPAddress(octets[0], octets[1], octets[2], octets[3]);
+        }
+        return success;
+    }
+    //!
+    //! @brief Format as dotted decimal address
+    //!
+    std::string toString() const
+    {
+        return std::to_string(address & 0xFF) + "." + std::to_string(address >> 8 & 0xFF) + "." + std::to_string(address >> 16 & 0xFF) + "." + std::to_string(address >> 24);
+    }
+};
+
+//!
+//! @brief Address 0.0.0.0, lets the driver use DHCP
+//!
+inline const IPAddress INADDR_NONE;
+
+//!
+//! @brief Events of the WiFi driver used by the WiFiHandler
+//!
+enum arduino_event_id_t
+{
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP,
+};
+
+//!
+//! @brief Info of an event (not evaluated by the WiFiHandler)
+//!
+struct arduino_event_info_t
+{
+};
+
+//!
+//! @brief Modes of the WiFi driver
+//!
+enum wifi_mode_t
+{
+    WIFI_OFF,
+    WIFI_STA,
+    WIFI_AP,
+};
+
+//!
+//! @brief TCP client (not connected on the host)
+//!
+class WiFiClient
+{
+};
+
+//!
+//! @brief WiFi driver recording the calls, the test raises the events of the link
+//!
+class WiFiClass
+{
+public:
+    //!
+    //! @brief Callback of the events
+    //!
+    void (*callback)(arduino_event_id_t, arduino_event_info_t) = nullptr;
+    //!
+    //! @brief Number of begin calls
+    //!
+    int begins = 0;
+    //!
+    //! @brief Channel of the last begin call, 0 for a full scan
+    //!
+    int32_t beginChannel = 0;
+    //!
+    //! @brief True if the last begin call passed a BSSID
+    //!
+    bool beginBSSID = false;
+    //!
+    //! @brief Number of softAP calls
+    //!
+    int softAPs = 0;
+    //!
+    //! @brief Actual mode
+    //!
+    wifi_mode_t currentMode = WIFI_OFF;
+    //!
+    //! @brief Address reported after the link is up
+    //!
+    IPAddress ip = IPAddress(192, 168, 1, 50);
+    //!
+    //! @brief BSSID of the access point reported after the link is up
+    //!
+    uint8_t bssid[6] = {0x24, 0x0a, 0xc4, 0x01, 0x02, 0x03};
+    //!
+    //! @brief Channel of the access point reported after the link is up
+    //!
+    int32_t apChannel = 6;
+    //!
+    //! @brief Raise an event like the WiFi event task
+    //!
+    //! @param event Event to raise
+    //!
+    void Raise(arduino_event_id_t event)
+    {
+        if (callback != nullptr)
+        {
+            callback(event, arduino_event_info_t());
+        }
+    }
+    //!
+    //! @brief Start connecting
+    //!
+    void begin(const char*, const char*, int32_t channel = 0, const uint8_t* bssid = nullptr)
+    {
+        begins++;
+        beginChannel = channel;
+        beginBSSID = bssid != nullptr;
+    }
+    //!
+    //! @brief Configure addresses
+    //!
+    bool config(IPAddress, IPAddress, IPAddress, IPAddress = IPAddress())
+    {
+        return true;
+    }
+    //!
+    //! @brief Disconnect the STA
+    //!
+    bool disconnect()
+    {
+        return true;
+    }
+    //!
+    //! @brief Set the mode
+    //!
+    bool mode(wifi_mode_t mode)
+    {
+        currentMode = mode;
+        return true;
+    }
+    //!
+    //! @brief Register the callback of the events
+    //!
+    void onEvent(void (*callback)(arduino_event_id_t, arduino_event_info_t))
+    {
+        this->callback = callback;
+    }
+    //!
+    //! @brief Enable reconnects of the driver
+    //!
+    bool setAutoReconnect(bool)
+    {
+        return true;
+    }
+    //!
+    //! @brief Start the access point
+    //!
+    bool softAP(const char*, const char*)
+    {
+        softAPs++;
+        return true;
+    }
+    //!
+    //! @brief Address of the STA
+    //!
+    IPAddress localIP()
+    {
+        return ip;
+    }
+    //!
+    //! @brief Gateway of the STA
+    //!
+    IPAddress gatewayIP()
+    {
+        return IPAddress(192, 168, 1, 1);
+    }
+    //!
+    //! @brief Subnet mask of the STA
+    //!
+    IPAddress subnetMask()
+    {
+        return IPAddress(255, 255, 255, 0);
+    }
+    //!
+    //! @brief DNS server of the STA
+    //!
+    IPAddress dnsIP()
+    {
+        return IPAddress(192, 168, 1, 1);
+    }
+    //!
+    //! @brief BSSID of the access point
+    //!
+    const uint8_t* BSSID()
+    {
+        return bssid;
+    }
+    //!
+    //! @brief Channel of the access point
+    //!
+    int32_t channel()
+    {
+        return apChannel;
+    }
+    //!
+    //! @brief Hostname of the STA
+    //!
+    const char* getHostname()
+    {
+        return "controller";
+    }
+};
+
+//!
+//! @brief WiFi driver used by the WiFiHandler and the MQTT client
+//!
+inline WiFiClass WiFi;
@@ -0,0 +1,23 @@
+//!
+//! @file esp_random.h
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Deterministic replacement of the hardware random number generator for native tests
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+#include <cstdint>
+
+//!
+//! @brief Pseudo random number (xorshift, same sequence on every run)
+//!
+//! @return uint32_t Random number
+//!
+inline uint32_t esp_random()
+{
+    static uint32_t state = 2463534242u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
@@ -0,0 +1,19 @@
+//!
+//! @file esp_timer.h
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief ESP timer for native tests (tests set the source of the Clock)
+//!
+//! @copyright Copyright (c) 2024
+//!
+#pragma once
+#include <cstdint>
+
+//!
+//! @brief Time since boot in microseconds, always 0 without hardware timer
+//!
+//! @return int64_t Time in microseconds
+//!
+inline int64_t esp_timer_get_time()
+{
+    return 0;
+}
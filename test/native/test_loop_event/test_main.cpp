@@ -0,0 +1,102 @@
+//!
+//! @file test_main.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Native tests of the loop listeners running on a simulated uptime of 50 days
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include <unity.h>
+#include "LoopEvent.hpp"
+
+using namespace ModelController;
+
+//!
+//! @brief Simulated time in microseconds
+//!
+static uint64_t now = 0;
+//!
+//! @brief Source of the Clock returning the simulated time
+//!
+static uint64_t GetNow()
+{
+    return now;
+}
+//!
+//! @brief Time in microseconds where millis() wraps (about 49.7 days)
+//!
+static constexpr uint64_t millisWrap = (uint64_t(1) << 32) * 1000;
+//!
+//! @brief One day in microseconds
+//!
+static constexpr uint64_t day = uint64_t(24) * 3600 * 1000000;
+
+void setUp()
+{
+    now = 0;
+    Clock::SetSource(&GetNow);
+}
+
+void tearDown()
+{
+    Clock::SetSource(nullptr);
+}
+
+//!
+//! @brief Listener with timeout keeps firing once per timeout, while millis() wraps
+//!
+void test_timeout_across_millis_wrap()
+{
+    size_t calls = 0;
+    LoopEvent::LoopListener listener([&](){ calls++; }, 1);
+    now = millisWrap - 10000000;
+    // 20 seconds in loops of 100 milliseconds, millis() wraps after 10 seconds
+    for (size_t i = 0; i < 200; i++)
+    {
+        LoopEvent::Raise();
+        now += 100000;
+    }
+    TEST_ASSERT_EQUAL(20, calls);
+}
+
+//!
+//! @brief Listener sleeping until its next change (like a sequence processor) runs for 50 days
+//!
+void test_sleep_for_50_days()
+{
+    size_t calls = 0;
+    LoopEvent::LoopListener* listener = nullptr;
+    LoopEvent::LoopListener sleeper([&](){ calls++; listener->Sleep(Clock::Now() + 3600000000ULL); });
+    listener = &sleeper;
+    // 50 days in loops of one minute
+    while (now < 50 * day)
+    {
+        LoopEvent::Raise();
+        now += 60000000;
+    }
+    TEST_ASSERT_EQUAL(50 * 24, calls);
+}
+
+//!
+//! @brief Listener without timeout is called on every loop after the wrap
+//!
+void test_every_loop_after_millis_wrap()
+{
+    size_t calls = 0;
+    LoopEvent::LoopListener listener([&](){ calls++; });
+    now = millisWrap - 500;
+    for (size_t i = 0; i < 10; i++)
+    {
+        LoopEvent::Raise();
+        now += 100;
+    }
+    TEST_ASSERT_EQUAL(10, calls);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_timeout_across_millis_wrap);
+    RUN_TEST(test_sleep_for_50_days);
+    RUN_TEST(test_every_loop_after_millis_wrap);
+    return UNITY_END();
+}
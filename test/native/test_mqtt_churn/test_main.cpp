@@ -0,0 +1,199 @@
+//!
+//! @file test_main.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Native soak test of the MQTT client, whose ports are created and deleted with the modules 10000 times
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include <unity.h>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <PubSubClient.h>
+#include "BaseModule.hpp"
+#include "LoopEvent.hpp"
+#include "Metrics.hpp"
+#include "WiFiHandler.hpp"
+
+using namespace ModelController;
+
+//!
+//! @brief Number of blocks allocated with new and not deleted yet
+//!
+static size_t liveAllocations = 0;
+
+//!
+//! @brief Allocate with malloc and count the block
+//!
+void* operator new(size_t size)
+{
+    void* block = malloc(size == 0 ? 1 : size);
+    if (block == nullptr)
+    {
+        abort();
+    }
+    liveAllocations++;
+    return block;
+}
+//!
+//! @brief Free the block and count it
+//!
+void operator delete(void* block) noexcept
+{
+    if (block != nullptr)
+    {
+        liveAllocations--;
+    }
+    free(block);
+}
+//!
+//! @brief Free the block and count it
+//!
+void operator delete(void* block, size_t) noexcept
+{
+    operator delete(block);
+}
+
+//!
+//! @brief Simulated time in microseconds
+//!
+static uint64_t now = 0;
+//!
+//! @brief Source of the Clock returning the simulated time
+//!
+static uint64_t GetNow()
+{
+    return now;
+}
+//!
+//! @brief Run loops of 1 ms
+//!
+//! @param duration Time to run in milliseconds
+//!
+static void Run(uint64_t duration)
+{
+    for (uint64_t end = now + duration * 1000; now < end; now += 1000)
+    {
+        LoopEvent::Raise();
+    }
+}
+//!
+//! @brief Numbers of messages the broker saw during the churn, its records are cleared after each round to keep the heap flat
+//!
+struct Traffic
+{
+    //!
+    //! @brief Published messages
+    //!
+    size_t published = 0;
+    //!
+    //! @brief Unsubscribed topics
+    //!
+    size_t unsubscribed = 0;
+    //!
+    //! @brief Raw SUBSCRIBE packets
+    //!
+    size_t packets = 0;
+};
+//!
+//! @brief Traffic of the churn
+//!
+static Traffic traffic;
+//!
+//! @brief Set the gain "/Processors/churn<i>", whose ports are connected to the API, set its input over MQTT and delete it again
+//!
+//! @param i Number of the gain
+//!
+static void Churn(size_t i)
+{
+    std::string name = "churn" + std::to_string(i);
+    TEST_ASSERT_EQUAL_STRING("", BaseModule::Set("Processors/" + name, R"({"type": "gain", "gain": 2})").c_str());
+    Run(1);
+    broker.Deliver("/edge/Processors/" + name + "/in", std::to_string(i));
+    // Topic without port, remembered by the client in its fixed table of unexposed topics (with wildcard subscription)
+    broker.Deliver("/edge/unknown/" + name, "0");
+    Run(1);
+    BaseModule::Delete("/Processors/" + name);
+    Run(1);
+    traffic.published += broker.published.size();
+    traffic.unsubscribed += broker.unsubscribed.size();
+    traffic.packets += broker.packets.size();
+    broker.published.clear();
+    broker.unsubscribed.clear();
+    broker.packets.clear();
+}
+//!
+//! @brief Create the client, churn 10000 gains and check that the client is left as after the first 100 rounds
+//!
+//! @param wildcard True for a wildcard subscription instead of a subscription per topic
+//!
+static void Soak(bool wildcard)
+{
+    JsonDocument doc;
+    deserializeJson(doc, R"({"name": "edge", "Connectors": {"mqtt": {"type": "mqtt", "server": "broker"}}})");
+    doc["Connectors"]["mqtt"]["wildcard"] = wildcard;
+    BaseModule::UpdateConfig(doc.as<JsonObject>());
+    WiFi.Raise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFiHandler::Check();
+    Run(10);
+    size_t ports = BaseModule::GetPorts("/Connectors/mqtt").size();
+    // Containers and buffers, which only grow, reach their size during the first rounds
+    for (size_t i = 0; i < 100; i++)
+    {
+        Churn(i);
+    }
+    size_t warm = liveAllocations;
+    traffic = Traffic();
+    uint64_t received = Metrics::mqttReceived.Get();
+    for (size_t i = 100; i < 10000; i++)
+    {
+        Churn(i);
+    }
+    std::string message = std::string(wildcard ? "Wildcard" : "Topic") + " subscriptions, live allocations after 10000 rounds: "
+        + std::to_string(liveAllocations) + ", after 100 rounds: " + std::to_string(warm);
+    TEST_MESSAGE(message.c_str());
+    // Every gain published its output, the client received both messages of every round
+    TEST_ASSERT_EQUAL(9900, traffic.published);
+    TEST_ASSERT_EQUAL(2 * 9900, Metrics::mqttReceived.Get() - received);
+    // Topics of deleted inputs are unsubscribed (the wildcard subscription covers them)
+    TEST_ASSERT_EQUAL(wildcard ? 0 : 9900, traffic.unsubscribed);
+    TEST_ASSERT_EQUAL(wildcard ? 0 : 9900, traffic.packets);
+    TEST_ASSERT_EQUAL(ports, BaseModule::GetPorts("/Connectors/mqtt").size());
+    TEST_ASSERT_LESS_OR_EQUAL(warm + 16, liveAllocations);
+    BaseModule::Delete("/Connectors/mqtt");
+}
+
+void setUp()
+{
+    now = 1000000;
+    Clock::SetSource(&GetNow);
+}
+
+void tearDown()
+{
+    Clock::SetSource(nullptr);
+}
+
+//!
+//! @brief Creating and deleting modules 10000 times leaves no ports, subscriptions or memory behind in the client
+//!
+void test_churn_topic_subscriptions()
+{
+    Soak(false);
+}
+
+//!
+//! @brief Creating and deleting modules 10000 times with a wildcard subscription leaves no ports, unexposed topics or memory behind
+//!
+void test_churn_wildcard_subscription()
+{
+    Soak(true);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_churn_topic_subscriptions);
+    RUN_TEST(test_churn_wildcard_subscription);
+    return UNITY_END();
+}
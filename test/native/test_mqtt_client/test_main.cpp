@@ -0,0 +1,301 @@
+//!
+//! @file test_main.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Native tests of the MQTT client against a stand-in broker accepting, delaying and refusing connections
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include <unity.h>
+#include <chrono>
+#include <set>
+#include <string>
+#include <vector>
+#include <PubSubClient.h>
+#include "BaseModule.hpp"
+#include "LoopEvent.hpp"
+#include "Metrics.hpp"
+#include "WiFiHandler.hpp"
+
+using namespace ModelController;
+
+//!
+//! @brief Simulated time in microseconds
+//!
+static uint64_t now = 0;
+//!
+//! @brief Source of the Clock returning the simulated time
+//!
+static uint64_t GetNow()
+{
+    return now;
+}
+//!
+//! @brief Create the MQTT client "/Connectors/mqtt" from the config and bring the WiFi link up
+//!
+//! @param config Config of the client
+//!
+static void Load(const std::string& config)
+{
+    JsonDocument client;
+    deserializeJson(client, config);
+    client["type"] = "mqtt";
+    JsonDocument doc;
+    doc["Connectors"]["mqtt"] = client;
+    BaseModule::UpdateConfig(doc.as<JsonObject>());
+    WiFi.Raise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFiHandler::Check();
+}
+//!
+//! @brief Run loops of 1 ms and record the times of the connection attempts
+//!
+//! @param duration Time to run in milliseconds
+//! @return std::vector<uint64_t> Times of the attempts in milliseconds
+//!
+static std::vector<uint64_t> Run(uint64_t duration)
+{
+    std::vector<uint64_t> attempts;
+    for (uint64_t end = now + duration * 1000; now < end; now += 1000)
+    {
+        uint64_t before = Metrics::mqttConnectAttempts.Get();
+        LoopEvent::Raise();
+        if (Metrics::mqttConnectAttempts.Get() != before)
+        {
+            attempts.push_back(now / 1000);
+        }
+    }
+    return attempts;
+}
+//!
+//! @brief Create the MQTT client "/Connectors/mqtt" and gains "/Processors/gain<i>", whose inputs are mirrored by
+//! outputs of the client subscribed to "/edge/Processors/gain<i>/in", and bring the WiFi link up
+//!
+//! @param config Config of the client
+//! @param count Number of gains
+//!
+static void LoadGains(const std::string& config, size_t count)
+{
+    JsonDocument client;
+    deserializeJson(client, config);
+    client["type"] = "mqtt";
+    JsonDocument doc;
+    doc["name"] = "edge";
+    doc["Connectors"]["mqtt"] = client;
+    for (size_t i = 0; i < count; i++)
+    {
+        doc["Processors"]["gain" + std::to_string(i)]["type"] = "gain";
+    }
+    BaseModule::UpdateConfig(doc.as<JsonObject>());
+    WiFi.Raise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFiHandler::Check();
+}
+//!
+//! @brief Delete the gains
+//!
+//! @param count Number of gains
+//!
+static void UnloadGains(size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        BaseModule::Delete("/Processors/gain" + std::to_string(i));
+    }
+}
+//!
+//! @brief Read the topics of the SUBSCRIBE packets written to the broker
+//!
+//! @return std::vector<std::string> Topics in order
+//!
+static std::vector<std::string> GetSubscribedTopics()
+{
+    std::vector<std::string> topics;
+    for (const std::vector<uint8_t>& packet : broker.packets)
+    {
+        // Fixed header with remaining length of up to four bytes, then the packet identifier
+        size_t position = 1;
+        while (packet[position++] & 0x80)
+        {
+        }
+        position += 2;
+        while (position + 2 <= packet.size())
+        {
+            size_t length = packet[position] << 8 | packet[position + 1];
+            topics.emplace_back(packet.begin() + position + 2, packet.begin() + position + 2 + length);
+            position += 2 + length + 1;
+        }
+    }
+    return topics;
+}
+//!
+//! @brief Drop the connection, let the broker answer the next attempt after the delay and measure the time to ready
+//!
+//! @param delay Time the broker takes to accept the connection in milliseconds
+//! @param duration Returns the time the loop handling the connection took on the host in microseconds
+//! @return uint64_t Time to ready reported by the client in milliseconds
+//!
+static uint64_t Reconnect(uint64_t delay, double& duration)
+{
+    broker.available = false;
+    Run(1);
+    broker.available = true;
+    broker.packets.clear();
+    deferTasks = true;
+    while (Run(1).empty())
+    {
+    }
+    Run(delay - 1);
+    deferTasks = false;
+    RunPendingTasks();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Run(1);
+    duration = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return Metrics::mqttReadyTime.Get();
+}
+
+void setUp()
+{
+    now = 1000000;
+    Clock::SetSource(&GetNow);
+    broker.available = true;
+}
+
+void tearDown()
+{
+    BaseModule::Delete("/Connectors/mqtt");
+    Clock::SetSource(nullptr);
+}
+
+//!
+//! @brief Refused connections are retried after a jittered backoff doubling up to backoffMax,
+//! a lost connection starts again at backoffMin
+//!
+void test_refused_backoff()
+{
+    broker.available = false;
+    Load(R"({"server": "broker", "backoffMin": 1000, "backoffMax": 8000})");
+    uint64_t failed = Metrics::mqttConnectFailed.Get();
+    std::vector<uint64_t> attempts = Run(60000);
+    TEST_ASSERT_GREATER_OR_EQUAL(9, attempts.size());
+    // Every attempt is refused, the last one may still be running
+    TEST_ASSERT_GREATER_OR_EQUAL(attempts.size() - 1, Metrics::mqttConnectFailed.Get() - failed);
+    TEST_ASSERT_LESS_OR_EQUAL(attempts.size(), Metrics::mqttConnectFailed.Get() - failed);
+    // The failure is handled on the loop after the attempt, then the client waits between half and full backoff
+    uint64_t backoff = 1000;
+    for (size_t i = 1; i < attempts.size(); i++)
+    {
+        uint64_t wait = attempts[i] - attempts[i - 1] - 1;
+        TEST_ASSERT_GREATER_OR_EQUAL(backoff / 2, wait);
+        TEST_ASSERT_LESS_OR_EQUAL(backoff, wait);
+        backoff = std::min<uint64_t>(backoff * 2, 8000);
+    }
+    // Broker accepts the next attempt and drops the connection later
+    broker.available = true;
+    attempts = Run(8001);
+    TEST_ASSERT_EQUAL(1, attempts.size());
+    broker.available = false;
+    uint64_t lost = now / 1000;
+    attempts = Run(2000);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, attempts.size());
+    TEST_ASSERT_GREATER_OR_EQUAL(lost + 500, attempts[0]);
+    TEST_ASSERT_LESS_OR_EQUAL(lost + 1000, attempts[0]);
+}
+
+//!
+//! @brief A broker answering after 3 s doesn't block the loop and no further attempt is started meanwhile
+//!
+void test_delayed_connect()
+{
+    deferTasks = true;
+    Load(R"({"server": "broker"})");
+    size_t loops = 0;
+    LoopEvent::LoopListener counter([&](){ loops++; });
+    std::vector<uint64_t> attempts = Run(3000);
+    TEST_ASSERT_EQUAL(1, attempts.size());
+    TEST_ASSERT_EQUAL(1, pendingTasks.size());
+    TEST_ASSERT_EQUAL(3000, loops);
+    deferTasks = false;
+    RunPendingTasks();
+    Run(1);
+    // Ready time is measured from the start of the attempt, 3 s before the task finished
+    TEST_ASSERT_EQUAL(now / 1000 - 1 - attempts[0], Metrics::mqttReadyTime.Get());
+    TEST_ASSERT_EQUAL(0, Run(10000).size());
+}
+
+//!
+//! @brief A backoffMin of 0 is raised to 1 ms and grows, a backoffMax below backoffMin is raised to backoffMin
+//!
+void test_backoff_clamped()
+{
+    broker.available = false;
+    Load(R"({"server": "broker", "backoffMin": 0})");
+    // 1, 2, 4, ... 32768 ms fit 16 attempts in 60 s (at 0 ms the loop would retry every other loop)
+    std::vector<uint64_t> attempts = Run(60000);
+    TEST_ASSERT_LESS_OR_EQUAL(20, attempts.size());
+    BaseModule::Delete("/Connectors/mqtt");
+    Load(R"({"server": "broker", "backoffMin": 4000, "backoffMax": 1000})");
+    attempts = Run(30000);
+    TEST_ASSERT_GREATER_OR_EQUAL(2, attempts.size());
+    for (size_t i = 1; i < attempts.size(); i++)
+    {
+        TEST_ASSERT_GREATER_OR_EQUAL(2000, attempts[i] - attempts[i - 1] - 1);
+        TEST_ASSERT_LESS_OR_EQUAL(4000, attempts[i] - attempts[i - 1] - 1);
+    }
+}
+
+//!
+//! @brief 200 variables are subscribed with few SUBSCRIBE packets in the loop handling the connection,
+//! so the client is ready when the broker accepts the connection
+//!
+void test_ready_topic_subscriptions()
+{
+    LoadGains(R"({"server": "broker"})", 200);
+    Run(10);
+    double duration = 0;
+    uint64_t ready = Reconnect(20, duration);
+    std::vector<std::string> topics = GetSubscribedTopics();
+    TEST_ASSERT_EQUAL(200, topics.size());
+    // Every input is subscribed once
+    std::set<std::string> expected;
+    for (size_t i = 0; i < 200; i++)
+    {
+        expected.insert("/edge/Processors/gain" + std::to_string(i) + "/in");
+    }
+    TEST_ASSERT_TRUE(std::set<std::string>(topics.begin(), topics.end()) == expected);
+    // Each topic takes 28 to 30 bytes, so a packet of 1 kB holds at least 34 of them
+    TEST_ASSERT_LESS_OR_EQUAL(6, broker.packets.size());
+    TEST_ASSERT_EQUAL(20, ready);
+    std::string message = "Ready " + std::to_string(ready) + " ms after the attempt with 200 topics in " + std::to_string(broker.packets.size())
+        + " SUBSCRIBE packets (one per variable: 200), loop handling the connection took " + std::to_string(duration) + " us";
+    TEST_MESSAGE(message.c_str());
+    UnloadGains(200);
+}
+
+//!
+//! @brief With wildcard subscription 200 variables are covered by a single topic
+//!
+void test_ready_wildcard_subscription()
+{
+    LoadGains(R"({"server": "broker", "wildcard": true})", 200);
+    Run(10);
+    double duration = 0;
+    uint64_t ready = Reconnect(20, duration);
+    std::vector<std::string> topics = GetSubscribedTopics();
+    TEST_ASSERT_EQUAL(1, broker.packets.size());
+    TEST_ASSERT_EQUAL(1, topics.size());
+    TEST_ASSERT_EQUAL_STRING("/edge/#", topics[0].c_str());
+    TEST_ASSERT_EQUAL(20, ready);
+    std::string message = "Ready " + std::to_string(ready) + " ms after the attempt with a wildcard subscription in 1 SUBSCRIBE packet, loop handling the connection took "
+        + std::to_string(duration) + " us";
+    TEST_MESSAGE(message.c_str());
+    UnloadGains(200);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_refused_backoff);
+    RUN_TEST(test_delayed_connect);
+    RUN_TEST(test_backoff_clamped);
+    RUN_TEST(test_ready_topic_subscriptions);
+    RUN_TEST(test_ready_wildcard_subscription);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+//!
+//! @file test_main.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Native benchmark of the receive path of the MQTT client, fed with messages by the stand-in broker
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include <unity.h>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include <PubSubClient.h>
+#include "BaseModule.hpp"
+#include "LoopEvent.hpp"
+#include "Metrics.hpp"
+#include "ModuleOut.hpp"
+#include "WiFiHandler.hpp"
+
+using namespace ModelController;
+
+//!
+//! @brief Number of blocks allocated with new
+//!
+static size_t allocations = 0;
+
+//!
+//! @brief Allocate with malloc and count the block
+//!
+void* operator new(size_t size)
+{
+    void* block = malloc(size == 0 ? 1 : size);
+    if (block == nullptr)
+    {
+        abort();
+    }
+    allocations++;
+    return block;
+}
+//!
+//! @brief Free the block
+//!
+void operator delete(void* block) noexcept
+{
+    free(block);
+}
+//!
+//! @brief Free the block
+//!
+void operator delete(void* block, size_t) noexcept
+{
+    free(block);
+}
+
+//!
+//! @brief Simulated time in microseconds
+//!
+static uint64_t now = 0;
+//!
+//! @brief Source of the Clock returning the simulated time
+//!
+static uint64_t GetNow()
+{
+    return now;
+}
+//!
+//! @brief Number of gains, whose inputs are set over MQTT
+//!
+static constexpr size_t numberGains = 200;
+//!
+//! @brief Run loops of 1 ms
+//!
+//! @param duration Time to run in milliseconds
+//!
+static void Run(uint64_t duration)
+{
+    for (uint64_t end = now + duration * 1000; now < end; now += 1000)
+    {
+        LoopEvent::Raise();
+    }
+}
+
+void setUp()
+{
+    now = 1000000;
+    Clock::SetSource(&GetNow);
+}
+
+void tearDown()
+{
+    Clock::SetSource(nullptr);
+}
+
+//!
+//! @brief 100000 messages to the inputs of 200 gains are dispatched by topic hash and parsed in place without allocating
+//!
+void test_receive_messages_per_second()
+{
+    JsonDocument doc;
+    doc["name"] = "edge";
+    doc["Connectors"]["mqtt"]["type"] = "mqtt";
+    doc["Connectors"]["mqtt"]["server"] = "broker";
+    std::vector<std::string> topics;
+    for (size_t i = 0; i < numberGains; i++)
+    {
+        std::string name = "gain" + std::to_string(i);
+        doc["Processors"][name]["type"] = "gain";
+        doc["Processors"][name]["gain"] = 2;
+        // Only the input is set over MQTT, the output isn't published
+        doc["Processors"][name]["api"]["out"] = "none";
+        topics.push_back("/edge/Processors/" + name + "/in");
+    }
+    BaseModule::UpdateConfig(doc.as<JsonObject>());
+    WiFi.Raise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFiHandler::Check();
+    Run(10);
+    std::vector<std::string> payloads;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        payloads.push_back(std::to_string(i * 0.25));
+    }
+    // Buffers of the broker grow during the first round
+    for (size_t i = 0; i < numberGains; i++)
+    {
+        broker.Deliver(topics[i], payloads.back());
+    }
+    constexpr size_t messages = 100000;
+    uint64_t received = Metrics::mqttReceived.Get();
+    size_t before = allocations;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < messages; i++)
+    {
+        broker.Deliver(topics[i % numberGains], payloads[i % payloads.size()]);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t allocated = allocations - before;
+    std::string message = std::to_string(static_cast<uint64_t>(messages / elapsed)) + " messages/s to " + std::to_string(numberGains)
+        + " topics (" + std::to_string(elapsed * 1e6 / messages) + " us per message), " + std::to_string(allocated) + " allocations";
+    TEST_MESSAGE(message.c_str());
+    TEST_ASSERT_EQUAL(messages, Metrics::mqttReceived.Get() - received);
+    TEST_ASSERT_EQUAL(0, allocated);
+    // Every gain got the last payload sent to its topic
+    for (size_t i = 0; i < numberGains; i++)
+    {
+        size_t last = messages - numberGains + i;
+        ModuleOut<double>* out = BaseModule::GetModule<ModuleOut<double>>("/Processors/gain" + std::to_string(i) + "/out");
+        TEST_ASSERT_NOT_NULL(out);
+        TEST_ASSERT_EQUAL_DOUBLE(2 * (last % payloads.size()) * 0.25, out->GetValue());
+    }
+    for (size_t i = 0; i < numberGains; i++)
+    {
+        BaseModule::Delete("/Processors/gain" + std::to_string(i));
+    }
+    BaseModule::Delete("/Connectors/mqtt");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_receive_messages_per_second);
+    return UNITY_END();
+}
@@ -0,0 +1,192 @@
+//!
+//! @file test_main.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Native benchmark of encoding and decoding payloads per data type and encoding
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include <unity.h>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "PayloadCodec.hpp"
+
+using namespace ModelController;
+
+//!
+//! @brief Number of blocks allocated with new
+//!
+static size_t allocations = 0;
+
+//!
+//! @brief Allocate with malloc and count the block
+//!
+void* operator new(size_t size)
+{
+    void* block = malloc(size == 0 ? 1 : size);
+    if (block == nullptr)
+    {
+        abort();
+    }
+    allocations++;
+    return block;
+}
+//!
+//! @brief Free the block
+//!
+void operator delete(void* block) noexcept
+{
+    free(block);
+}
+//!
+//! @brief Free the block
+//!
+void operator delete(void* block, size_t) noexcept
+{
+    free(block);
+}
+
+//!
+//! @brief Number of encodings and decodings per value
+//!
+static constexpr size_t rounds = 20000;
+//!
+//! @brief Encodings with their names
+//!
+static const std::vector<std::pair<PayloadCodec::Encoding, std::string>> encodings =
+{
+    {PayloadCodec::Encoding::eText, "text"},
+    {PayloadCodec::Encoding::eRaw, "raw"},
+    {PayloadCodec::Encoding::eCbor, "cbor"},
+};
+//!
+//! @brief Encode and decode the values with every encoding, check the round trip and report time, size and allocations
+//!
+//! @tparam T Type of the values
+//! @param type Name of the type
+//! @param values Values to encode, exactly representable as text with 6 significant digits
+//! @return std::vector<size_t> Allocations per encoding in the order of encodings
+//!
+template<typename T>
+static std::vector<size_t> Measure(const std::string& type, const std::vector<T>& values)
+{
+    std::vector<size_t> allocated;
+    std::string payload;
+    payload.reserve(64);
+    for (const std::pair<PayloadCodec::Encoding, std::string>& encoding : encodings)
+    {
+        size_t size = 0;
+        size_t before = allocations;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rounds; i++)
+        {
+            PayloadCodec::Encode(encoding.first, values[i % values.size()], payload);
+            size += payload.size();
+        }
+        double encode = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+        size_t encodeAllocations = allocations - before;
+        // Decode payloads of all values, the payloads are encoded before
+        std::vector<std::string> payloads;
+        for (const T& value : values)
+        {
+            PayloadCodec::Encode(encoding.first, value, payload);
+            payloads.push_back(payload);
+        }
+        T decoded = T();
+        bool success = true;
+        before = allocations;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rounds; i++)
+        {
+            const std::string& encoded = payloads[i % payloads.size()];
+            success = PayloadCodec::Decode(encoding.first, encoded.data(), encoded.size(), decoded) && decoded == values[i % values.size()] && success;
+        }
+        double decode = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+        size_t decodeAllocations = allocations - before;
+        std::string message = type + " " + encoding.second + ": encode " + std::to_string(encode) + " ns, decode " + std::to_string(decode)
+            + " ns, " + std::to_string(static_cast<double>(size) / rounds) + " bytes, allocations per encode " + std::to_string(static_cast<double>(encodeAllocations) / rounds)
+            + ", per decode " + std::to_string(static_cast<double>(decodeAllocations) / rounds);
+        TEST_MESSAGE(message.c_str());
+        TEST_ASSERT_TRUE_MESSAGE(success, (type + " " + encoding.second + " round trip").c_str());
+        allocated.push_back(encodeAllocations + decodeAllocations);
+    }
+    return allocated;
+}
+//!
+//! @brief Check that no encoding allocated
+//!
+//! @param allocated Allocations per encoding
+//!
+static void CheckNoAllocations(const std::vector<size_t>& allocated)
+{
+    for (size_t i = 0; i < allocated.size(); i++)
+    {
+        TEST_ASSERT_EQUAL_MESSAGE(0, allocated[i], encodings[i].second.c_str());
+    }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+//!
+//! @brief Doubles and floats round trip in every encoding without allocating
+//!
+void test_floating_point()
+{
+    std::vector<double> doubles;
+    std::vector<float> floats;
+    for (int i = -500; i < 500; i++)
+    {
+        doubles.push_back(i * 0.125);
+        floats.push_back(static_cast<float>(i * 0.25));
+    }
+    CheckNoAllocations(Measure("double", doubles));
+    CheckNoAllocations(Measure("float", floats));
+}
+
+//!
+//! @brief Integers of all sizes (including the character types int8_t and uint8_t) round trip in every encoding without allocating
+//!
+void test_integers()
+{
+    std::vector<int8_t> int8s;
+    std::vector<uint8_t> uint8s;
+    std::vector<int32_t> int32s;
+    std::vector<uint64_t> uint64s;
+    for (int i = 0; i < 256; i++)
+    {
+        int8s.push_back(static_cast<int8_t>(i - 128));
+        uint8s.push_back(static_cast<uint8_t>(i));
+        int32s.push_back((i - 128) * 1000003);
+        uint64s.push_back(static_cast<uint64_t>(i) << 40 | i);
+    }
+    CheckNoAllocations(Measure("int8", int8s));
+    CheckNoAllocations(Measure("uint8", uint8s));
+    CheckNoAllocations(Measure("int32", int32s));
+    CheckNoAllocations(Measure("uint64", uint64s));
+}
+
+//!
+//! @brief Booleans and short strings (kept in the string object) round trip in every encoding without allocating
+//!
+void test_bool_string()
+{
+    CheckNoAllocations(Measure("bool", std::vector<bool>{false, true}));
+    CheckNoAllocations(Measure("string", std::vector<std::string>{"on", "off", "Taxi"}));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_floating_point);
+    RUN_TEST(test_integers);
+    RUN_TEST(test_bool_string);
+    return UNITY_END();
+}
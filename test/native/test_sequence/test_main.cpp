@@ -0,0 +1,637 @@
+//!
+//! @file test_main.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Native tests of the sequence table compared with a recursive evaluation of the sequence tree
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include <unity.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Sequence.hpp"
+#include "SequenceElement.hpp"
+
+using namespace ModelController;
+
+//!
+//! @brief Sequences covering nesting, repetitions, ramps, curves, infinite and zero length items
+//!
+static const char* sequences[] = {
+    "{100}",
+    "{0;1000;100}",
+    "{{100;50}{0;50}{100;50}{0;850}}",
+    "{3{10;5;20}{0;7}{50;100}}",
+    "{{1;10}inf{2;20}{3;30}}",
+    "{2{3{1;1}{2;2}}{5;3;0;inout}{7}}",
+    "{{0;100;100;in}{100;100;0;out}{0;100;100;exp}{100;100;0;inout}}",
+    "{{0;0.5;1}{1;0.25}{-2;0.125;2}}",
+    "{{5;0}{7;10}{8;0}}",
+    "{}",
+    "{{{{{{1;3}{2;5}}}}}}",
+    "{5{{1;2}{2;3}}{0;1000;1}}",
+    "{{100;50}1000{{0;1}{100;1}}}",
+};
+
+//!
+//! @brief Split the sequence string of an element into its fields
+//!
+//! @param element Element
+//! @return std::vector<std::string> Start value, duration, end value and curve (if present)
+//!
+static std::vector<std::string> GetFields(const SequenceElement* element)
+{
+    std::vector<std::string> fields;
+    std::string text = element->GetSequenceString();
+    size_t start = 0;
+    size_t end = 0;
+    do
+    {
+        end = text.find(';', start);
+        fields.push_back(text.substr(start, end == std::string::npos ? std::string::npos : end - start));
+        start = end + 1;
+    } while (end != std::string::npos);
+    return fields;
+}
+
+//!
+//! @brief Shape progress with the formula of the curve (the table interpolates it)
+//!
+static double ReferenceCurve(const std::string& name, double x)
+{
+    double y = x;
+    if (name == "in")
+    {
+        y = x * x;
+    }
+    else if (name == "out")
+    {
+        y = 1 - (1 - x) * (1 - x);
+    }
+    else if (name == "inout")
+    {
+        y = x * x * (3 - 2 * x);
+    }
+    else if (name == "exp")
+    {
+        y = (std::pow(64.0, x) - 1) / 63;
+    }
+    return y;
+}
+
+//!
+//! @brief Evaluate the tree recursively like the parser describes it, without the table
+//!
+//! @param sequence Sequence or element
+//! @param time Time since the start of the sequence in microseconds
+//! @param active Set to true, if an element is active at time
+//! @return double Value of the active element, 0 if none is active
+//!
+static double ReferenceValue(const Sequence* sequence, uint64_t time, bool& active)
+{
+    double value = 0;
+    std::optional<uint64_t> period = sequence->GetDuration(false);
+    if (period && *period > 0)
+    {
+        time %= *period;
+    }
+    if (const SequenceElement* element = dynamic_cast<const SequenceElement*>(sequence))
+    {
+        std::vector<std::string> fields = GetFields(element);
+        double from = std::stod(fields[0]);
+        double to = fields.size() > 2 ? std::stod(fields[2]) : from;
+        double progress = period && *period > 0 ? static_cast<double>(time) / *period : 0;
+        value = from + (to - from) * ReferenceCurve(fields.size() > 3 ? fields[3] : "linear", progress);
+        active = true;
+    }
+    else
+    {
+        uint64_t start = 0;
+        for (size_t i = 0; i < sequence->subsequences.size() && !active; i++)
+        {
+            std::optional<uint64_t> duration = sequence->subsequences[i]->GetDuration();
+            if (!duration || time < start + *duration)
+            {
+                value = ReferenceValue(sequence->subsequences[i], time - start, active);
+            }
+            start += duration.value_or(0);
+        }
+    }
+    return value;
+}
+
+//!
+//! @brief Largest change of a ramp in the sequence, used to scale the tolerance of curved ramps
+//!
+static double GetMaxDelta(const Sequence* sequence)
+{
+    double delta = 0;
+    if (const SequenceElement* element = dynamic_cast<const SequenceElement*>(sequence))
+    {
+        std::vector<std::string> fields = GetFields(element);
+        delta = fields.size() > 2 ? std::fabs(std::stod(fields[2]) - std::stod(fields[0])) : 0;
+    }
+    for (const Sequence* subsequence : sequence->subsequences)
+    {
+        delta = std::max(delta, GetMaxDelta(subsequence));
+    }
+    return delta;
+}
+
+//!
+//! @brief Largest absolute value of an element in the sequence, used to scale the tolerance of float
+//!
+static double GetMaxValue(const Sequence* sequence)
+{
+    double value = 0;
+    if (const SequenceElement* element = dynamic_cast<const SequenceElement*>(sequence))
+    {
+        std::vector<std::string> fields = GetFields(element);
+        value = std::fabs(std::stod(fields[0]));
+        if (fields.size() > 2)
+        {
+            value = std::max(value, std::fabs(std::stod(fields[2])));
+        }
+    }
+    for (const Sequence* subsequence : sequence->subsequences)
+    {
+        value = std::max(value, GetMaxValue(subsequence));
+    }
+    return value;
+}
+
+//!
+//! @brief Times to compare at: steps of a prime number of microseconds over three periods and random times
+//!
+static std::vector<uint64_t> GetTimes(const Sequence& sequence)
+{
+    std::vector<uint64_t> times;
+    uint64_t period = sequence.GetDuration(false).value_or(10000000);
+    uint64_t range = std::min<uint64_t>(3 * std::max<uint64_t>(period, 1), 30000000);
+    for (uint64_t time = 0; time < range; time += 997)
+    {
+        times.push_back(time);
+    }
+    srand(42);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        times.push_back((static_cast<uint64_t>(rand()) << 20) ^ rand());
+    }
+    return times;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+//!
+//! @brief Table evaluation equals the recursive evaluation of the tree (curves within the interpolation error of their table)
+//!
+void test_table_matches_tree()
+{
+    for (const char* text : sequences)
+    {
+        Sequence sequence(text);
+        TEST_ASSERT_EQUAL_STRING("", Sequence::Validate(text).c_str());
+        double tolerance = 1e-9 + 1e-3 * GetMaxDelta(&sequence);
+        for (uint64_t time : GetTimes(sequence))
+        {
+            bool active = false;
+            double expected = ReferenceValue(&sequence, time, active);
+            TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(tolerance, expected, sequence.GetValue(time), text);
+        }
+    }
+}
+
+//!
+//! @brief Duration taken from the table equals the sum over the tree
+//!
+void test_table_duration()
+{
+    TEST_ASSERT_EQUAL_UINT64(1000000, *Sequence("{{100;50}{0;50}{100;50}{0;850}}").GetDuration());
+    TEST_ASSERT_EQUAL_UINT64(3 * 5000 + 7000 + 100000, *Sequence("{3{10;5;20}{0;7}{50;100}}").GetDuration());
+    TEST_ASSERT_EQUAL_UINT64(875, *Sequence("{{0;0.5;1}{1;0.25}{-2;0.125;2}}").GetDuration());
+    TEST_ASSERT_EQUAL_UINT64(0, *Sequence("{}").GetDuration());
+    TEST_ASSERT_FALSE(Sequence("{{1;10}inf{2;20}{3;30}}").GetDuration().has_value());
+    TEST_ASSERT_FALSE(Sequence("{100}").GetDuration().has_value());
+    TEST_ASSERT_EQUAL_UINT64(2 * (3 * 1000 + 2000) + 3000, *Sequence("{2{3{1;1}{2;2}}{5;3;0;inout}}").GetDuration());
+}
+
+//!
+//! @brief Values at the borders of the elements (start value at the start, next element at the end)
+//!
+void test_table_borders()
+{
+    Sequence sequence("{{100;50}{0;50}{100;50}{0;850}}");
+    TEST_ASSERT_EQUAL_DOUBLE(100, sequence.GetValue(0));
+    TEST_ASSERT_EQUAL_DOUBLE(100, sequence.GetValue(49999));
+    TEST_ASSERT_EQUAL_DOUBLE(0, sequence.GetValue(50000));
+    TEST_ASSERT_EQUAL_DOUBLE(100, sequence.GetValue(100000));
+    TEST_ASSERT_EQUAL_DOUBLE(0, sequence.GetValue(150000));
+    TEST_ASSERT_EQUAL_DOUBLE(100, sequence.GetValue(1000000));
+    // Zero length elements are skipped
+    Sequence zero("{{5;0}{7;10}{8;0}}");
+    TEST_ASSERT_EQUAL_DOUBLE(7, zero.GetValue(0));
+    TEST_ASSERT_EQUAL_DOUBLE(7, zero.GetValue(10000));
+}
+
+//!
+//! @brief Time per evaluation of nested sequences without cursor (printed, not asserted)
+//!
+void test_benchmark_table()
+{
+    for (const char* text : {"{{100;50}{0;50}{100;50}{0;850}}", "{2{3{1;1}{2;2}}{5;3;0;inout}{7}}", "{5{{1;2}{2;3}}{0;1000;1}}"})
+    {
+        Sequence sequence(text);
+        constexpr size_t evaluations = 200000;
+        double sum = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < evaluations; i++)
+        {
+            sum += sequence.GetValue(i * 7919);
+        }
+        double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / evaluations;
+        TEST_ASSERT_TRUE(std::isfinite(sum));
+        TEST_MESSAGE((std::string(text) + ": " + std::to_string(nanoseconds) + " ns per evaluation without cursor").c_str());
+    }
+}
+
+//!
+//! @brief Evaluation with a cursor equals the search from the root for monotonic time
+//!
+void test_cursor_forward()
+{
+    for (const char* text : sequences)
+    {
+        Sequence sequence(text);
+        Sequence::Cursor cursor;
+        uint64_t range = std::min<uint64_t>(3 * std::max<uint64_t>(sequence.GetDuration(false).value_or(10000000), 1), 30000000);
+        for (uint64_t time = 0; time < range; time += 101)
+        {
+            TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(0, sequence.GetValue(time), sequence.GetValue(time, cursor), text);
+        }
+    }
+}
+
+//!
+//! @brief Cursor falls back to the search on jumps forward over nested sequences and backwards
+//!
+void test_cursor_jump()
+{
+    srand(7);
+    for (const char* text : sequences)
+    {
+        Sequence sequence(text);
+        Sequence::Cursor cursor;
+        uint64_t time = 0;
+        for (size_t i = 0; i < 5000; i++)
+        {
+            // Small steps, jumps up to 100 seconds and jumps backwards
+            int choice = rand() % 4;
+            if (choice == 0)
+            {
+                time += rand() % 100000000;
+            }
+            else if (choice == 1)
+            {
+                time -= std::min<uint64_t>(time, rand() % 1000000);
+            }
+            else
+            {
+                time += rand() % 1000;
+            }
+            TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(0, sequence.GetValue(time), sequence.GetValue(time, cursor), text);
+        }
+    }
+}
+
+//!
+//! @brief Cursor follows the wraparound of the root and nested repetitions
+//!
+void test_cursor_wrap()
+{
+    for (const char* text : {"{{100;50}{0;50}{100;50}{0;850}}", "{3{10;5;20}{0;7}{50;100}}", "{2{3{1;1}{2;2}}{5;3;0;inout}{7}}", "{{100;50}1000{{0;1}{100;1}}}"})
+    {
+        Sequence sequence(text);
+        Sequence::Cursor cursor;
+        uint64_t period = *sequence.GetDuration(false) == 0 ? 1 : *sequence.GetDuration(false);
+        for (uint64_t iteration = 1; iteration < 1000; iteration++)
+        {
+            for (uint64_t time = iteration * period - 3; time < iteration * period + 3; time++)
+            {
+                TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(0, sequence.GetValue(time), sequence.GetValue(time, cursor), text);
+            }
+        }
+    }
+}
+
+//!
+//! @brief Time per evaluation of a strobe with 200 steps with and without cursor and of a single element (printed, not asserted)
+//!
+void test_benchmark_cursor()
+{
+    std::string strobe = "{";
+    for (size_t i = 0; i < 100; i++)
+    {
+        strobe += "{100;1}{0;1}";
+    }
+    strobe += "}";
+    constexpr size_t evaluations = 200000;
+    for (std::pair<std::string, bool> benchmark : {std::make_pair(strobe, false), std::make_pair(strobe, true), std::make_pair(std::string("{{100;200}}"), true)})
+    {
+        Sequence sequence(benchmark.first);
+        Sequence::Cursor cursor;
+        double sum = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < evaluations; i++)
+        {
+            sum += benchmark.second ? sequence.GetValue(i * 100, cursor) : sequence.GetValue(i * 100);
+        }
+        double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / evaluations;
+        TEST_ASSERT_TRUE(std::isfinite(sum));
+        std::string name = benchmark.first == strobe ? "200 steps" : "single element";
+        TEST_MESSAGE((name + (benchmark.second ? " with" : " without") + " cursor: " + std::to_string(nanoseconds) + " ns per evaluation").c_str());
+    }
+}
+
+//!
+//! @brief Float and fixed point stay within their rounding error of double
+//!
+//! Fixed point rounds start and delta by half a step each and truncates the product by up to a step (2^-16).
+//! Float rounds start, delta, progress and the result by half an epsilon of the largest value each.
+//!
+void test_precision_bounds()
+{
+    constexpr double fixedBound = 2.0 / 65536;
+    for (const char* text : sequences)
+    {
+        Sequence sequence(text);
+        double floatBound = 4 * std::numeric_limits<float>::epsilon() * GetMaxValue(&sequence);
+        Sequence::Cursor doubleCursor;
+        Sequence::Cursor floatCursor;
+        Sequence::Cursor fixedCursor;
+        double floatError = 0;
+        double fixedError = 0;
+        for (uint64_t time : GetTimes(sequence))
+        {
+            double expected = sequence.GetValue(time, doubleCursor, Sequence::Precision::eDouble);
+            floatError = std::max(floatError, std::fabs(sequence.GetValue(time, floatCursor, Sequence::Precision::eFloat) - expected));
+            fixedError = std::max(fixedError, std::fabs(sequence.GetValue(time, fixedCursor, Sequence::Precision::eFixed) - expected));
+        }
+        TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(floatBound, 0, floatError, text);
+        TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(fixedBound, 0, fixedError, text);
+    }
+}
+
+//!
+//! @brief Fixed point saturates values outside of Q16.16 instead of wrapping
+//!
+void test_fixed_saturation()
+{
+    constexpr double maximum = std::numeric_limits<int32_t>::max() / 65536.0;
+    constexpr double minimum = std::numeric_limits<int32_t>::min() / 65536.0;
+    Sequence::Cursor cursor;
+    TEST_ASSERT_EQUAL_DOUBLE(maximum, Sequence("{{40000}}").GetValue(0, cursor, Sequence::Precision::eFixed));
+    cursor = Sequence::Cursor();
+    TEST_ASSERT_EQUAL_DOUBLE(minimum, Sequence("{{-40000}}").GetValue(0, cursor, Sequence::Precision::eFixed));
+    cursor = Sequence::Cursor();
+    TEST_ASSERT_EQUAL_DOUBLE(32767, Sequence("{{32767}}").GetValue(0, cursor, Sequence::Precision::eFixed));
+}
+
+//!
+//! @brief Time per evaluation of linear and curved ramps in double, float and fixed point (printed, not asserted)
+//!
+//! On the host all three use a hardware FPU, on the ESP32 double is emulated in software.
+//!
+void test_benchmark_precision()
+{
+    constexpr size_t evaluations = 200000;
+    for (const char* text : {"{{0;1000;100}}", "{{0;1000;100;inout}}"})
+    {
+        Sequence sequence(text);
+        for (Sequence::Precision precision : {Sequence::Precision::eDouble, Sequence::Precision::eFloat, Sequence::Precision::eFixed})
+        {
+            Sequence::Cursor cursor;
+            double sum = 0;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < evaluations; i++)
+            {
+                sum += sequence.GetValue(i * 7, cursor, precision);
+            }
+            double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / evaluations;
+            TEST_ASSERT_TRUE(std::isfinite(sum));
+            const char* name = precision == Sequence::Precision::eDouble ? "double" : precision == Sequence::Precision::eFloat ? "float" : "fixed";
+            TEST_MESSAGE((std::string(text) + " in " + name + ": " + std::to_string(nanoseconds) + " ns per evaluation").c_str());
+        }
+    }
+}
+
+//!
+//! @brief Canonical sequence strings parse to themselves, others are canonicalized
+//!
+void test_parse_round_trip()
+{
+    for (const char* text : sequences)
+    {
+        Sequence sequence(text);
+        TEST_ASSERT_EQUAL_STRING(text, sequence.GetSequenceString().c_str());
+        TEST_ASSERT_EQUAL_STRING("", Sequence::Validate(text).c_str());
+    }
+    const char* canonicals[][2] = {
+        {" { 2 { {1 ; 1} {2;2} } } ", "{2{{1;1}{2;2}}}"},
+        {"{{0;1000;100;linear}}", "{{0;1000;100}}"},
+        {"{1.50;2.0}", "{1.5;2}"},
+        {"{{1e2;10}}", "{{100;10}}"},
+        {"{{0.1;1}{0.2;1}}", "{{0.1;1}{0.2;1}}"},
+        {"{{100;50}1.0{{0;1}}}", "{{100;50}{1}{{0;1}}}"},
+    };
+    for (const char** canonical : canonicals)
+    {
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(canonical[1], Sequence(canonical[0]).GetSequenceString().c_str(), canonical[0]);
+    }
+}
+
+//!
+//! @brief Invalid sequence strings report the position of the error and result in an empty sequence
+//!
+void test_parse_errors()
+{
+    const char* errors[][2] = {
+        {"", "Position 0: expected '{'"},
+        {"{", "Position 1: expected '}'"},
+        {"{{1;1}", "Position 6: expected '}'"},
+        {"{{1;1}}}", "Position 7: unexpected character after sequence"},
+        {"{{x}}", "Position 2: expected value"},
+        {"{{1;}}", "Position 4: expected duration"},
+        {"{{1;-5}}", "Position 4: expected duration"},
+        {"{{1;2;}}", "Position 6: expected end value"},
+        {"{{1;2;3;foo}}", "Position 8: unknown curve"},
+        {"{{1;2};}", "Position 6: expected value"},
+        {"{99999999999{1;1}}", "Position 1: number of repetitions out of range"},
+        {"{2000000000{1;9000000000000}}", "Position 1: sequence too long"},
+        {"{{{{{{{{{{{{{{{{{{{{1}}}}}}}}}}}}}}}}}}}}", "Position 16: sequences nested too deep"},
+    };
+    for (const char** error : errors)
+    {
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(error[1], Sequence::Validate(error[0]).c_str(), error[0]);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE("{}", Sequence(error[0]).GetSequenceString().c_str(), error[0]);
+    }
+}
+
+//!
+//! @brief Deterministic fuzzing with random edits of valid sequence strings
+//!
+//! Each mutant either is rejected with a position inside the string and results in an empty sequence,
+//! or its canonical form is valid, parses to itself and can be evaluated (memory errors are caught by the sanitizers).
+//!
+void test_parse_fuzz()
+{
+    static const char alphabet[] = "{};0123456789.-+e inf";
+    srand(45);
+    size_t valid = 0;
+    constexpr size_t mutants = 20000;
+    for (size_t i = 0; i < mutants; i++)
+    {
+        std::string text = sequences[static_cast<size_t>(rand()) % (sizeof(sequences) / sizeof(sequences[0]))];
+        int edits = 1 + rand() % 3;
+        for (int edit = 0; edit < edits; edit++)
+        {
+            size_t position = static_cast<size_t>(rand()) % (text.size() + 1);
+            char character = alphabet[static_cast<size_t>(rand()) % (sizeof(alphabet) - 1)];
+            switch (rand() % 3)
+            {
+            case 0:
+                text.insert(position, 1, character);
+                break;
+            case 1:
+                text.erase(position, 1);
+                break;
+            default:
+                text.replace(position, 1, 1, character);
+                break;
+            }
+        }
+        std::string error = Sequence::Validate(text);
+        Sequence sequence(text);
+        if (error.empty())
+        {
+            std::string canonical = sequence.GetSequenceString();
+            TEST_ASSERT_EQUAL_STRING_MESSAGE("", Sequence::Validate(canonical).c_str(), text.c_str());
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(canonical.c_str(), Sequence(canonical).GetSequenceString().c_str(), text.c_str());
+            Sequence::Cursor cursor;
+            for (uint64_t time = 0; time < 100000; time += 9973)
+            {
+                sequence.GetValue(time, cursor);
+            }
+            valid++;
+        }
+        else
+        {
+            TEST_ASSERT_EQUAL_MESSAGE(0, error.compare(0, 9, "Position "), text.c_str());
+            TEST_ASSERT_LESS_OR_EQUAL(text.size(), std::strtoull(error.c_str() + 9, nullptr, 10));
+            TEST_ASSERT_EQUAL_STRING_MESSAGE("{}", sequence.GetSequenceString().c_str(), text.c_str());
+        }
+    }
+    TEST_MESSAGE((std::to_string(valid) + " of " + std::to_string(mutants) + " mutants valid").c_str());
+}
+
+//!
+//! @brief Parse throughput of a long sequence string (printed, not asserted)
+//!
+void test_benchmark_parse()
+{
+    std::string text = "{";
+    for (size_t i = 0; i < 1000; i++)
+    {
+        text += sequences[i % (sizeof(sequences) / sizeof(sequences[0]))];
+    }
+    text += "}";
+    constexpr size_t parses = 100;
+    size_t items = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < parses; i++)
+    {
+        items += Sequence(text).subsequences.size();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    TEST_ASSERT_EQUAL(1000 * parses, items);
+    TEST_MESSAGE(("Parsing: " + std::to_string(text.size() * parses / seconds / 1e6) + " MB/s").c_str());
+}
+
+//!
+//! @brief Equal sequence strings share one sequence, also if they differ in spacing or number format
+//!
+void test_cache_sharing()
+{
+    size_t size = Sequence::GetCacheSize();
+    std::shared_ptr<const Sequence> canonical = Sequence::Get("{{100;50}{0;50}}");
+    std::shared_ptr<const Sequence> spaced = Sequence::Get(" { { 100 ; 50 } { 0 ; 50 } } ");
+    std::shared_ptr<const Sequence> formatted = Sequence::Get("{{1e2;50.0}{0.0;50}}");
+    std::shared_ptr<const Sequence> other = Sequence::Get("{{100;50}{0;60}}");
+    TEST_ASSERT_EQUAL_PTR(canonical.get(), spaced.get());
+    TEST_ASSERT_EQUAL_PTR(canonical.get(), formatted.get());
+    TEST_ASSERT_TRUE(canonical.get() != other.get());
+    TEST_ASSERT_EQUAL(size + 2, Sequence::GetCacheSize());
+    TEST_ASSERT_EQUAL(3, canonical.use_count());
+    std::vector<std::shared_ptr<const Sequence>> processors(200);
+    for (std::shared_ptr<const Sequence>& processor : processors)
+    {
+        processor = Sequence::Get("{{100;50}{0;50}{100;50}{0;850}}");
+    }
+    TEST_ASSERT_EQUAL(size + 3, Sequence::GetCacheSize());
+    TEST_ASSERT_EQUAL(200, processors[0].use_count());
+}
+
+//!
+//! @brief Sequences expire with their last user and are parsed again when requested after
+//!
+void test_cache_expiry()
+{
+    size_t size = Sequence::GetCacheSize();
+    std::shared_ptr<const Sequence> first = Sequence::Get("{{7;10}{8;10}}");
+    std::shared_ptr<const Sequence> second = Sequence::Get("{{7;10}{8;10}}");
+    TEST_ASSERT_EQUAL(size + 1, Sequence::GetCacheSize());
+    first.reset();
+    TEST_ASSERT_EQUAL(size + 1, Sequence::GetCacheSize());
+    second.reset();
+    TEST_ASSERT_EQUAL(size, Sequence::GetCacheSize());
+    std::shared_ptr<const Sequence> again = Sequence::Get("{{7;10}{8;10}}");
+    TEST_ASSERT_EQUAL(size + 1, Sequence::GetCacheSize());
+    TEST_ASSERT_EQUAL_STRING("{{7;10}{8;10}}", again->GetSequenceString().c_str());
+    TEST_ASSERT_EQUAL(1, again.use_count());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_table_matches_tree);
+    RUN_TEST(test_table_duration);
+    RUN_TEST(test_table_borders);
+    RUN_TEST(test_benchmark_table);
+    RUN_TEST(test_cursor_forward);
+    RUN_TEST(test_cursor_jump);
+    RUN_TEST(test_cursor_wrap);
+    RUN_TEST(test_benchmark_cursor);
+    RUN_TEST(test_precision_bounds);
+    RUN_TEST(test_fixed_saturation);
+    RUN_TEST(test_benchmark_precision);
+    RUN_TEST(test_parse_round_trip);
+    RUN_TEST(test_parse_errors);
+    RUN_TEST(test_parse_fuzz);
+    RUN_TEST(test_benchmark_parse);
+    RUN_TEST(test_cache_sharing);
+    RUN_TEST(test_cache_expiry);
+    return UNITY_END();
+}
@@ -0,0 +1,273 @@
+//!
+//! @file test_main.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Native tests of the sequence processors evaluated on their own and by the SequenceEngine
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include <unity.h>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "BaseModule.hpp"
+#include "SequenceProcessor.hpp"
+#include "ModuleIn.hpp"
+#include "ModuleOut.hpp"
+#include "SequenceEngine.hpp"
+#include "LoopEvent.hpp"
+#include "Metrics.hpp"
+
+using namespace ModelController;
+
+//!
+//! @brief Simulated time in microseconds
+//!
+static uint64_t now = 0;
+//!
+//! @brief Number of reads of the simulated time
+//!
+static size_t clockReads = 0;
+//!
+//! @brief Source of the Clock returning the simulated time
+//!
+static uint64_t GetNow()
+{
+    clockReads++;
+    return now;
+}
+//!
+//! @brief Configs of processors covering constant values, ramps, strobes, on- and off-sequences and sync
+//!
+static const std::vector<std::string> configs =
+{
+    R"({"defaultMode": "Taxi", "on": "{0;2000;60}", "off": "{60;300;0}", "modes": {"Taxi": {"on": true, "off": true, "mode": "{60}"}}})",
+    R"({"defaultMode": "Strobe", "modes": {"Strobe": {"mode": "{{100;50}{0;50}{100;50}{0;850}}"}}})",
+    R"({"defaultMode": "Beacon", "modes": {"Beacon": {"sync": 1000, "mode": "{{0;500}{100;100}{0;400}}"}}})",
+    R"({"defaultMode": "Fade", "on": "{0;1000;100}", "off": "{100;300;0}", "modes": {"Fade": {"on": true, "off": true, "mode": "{{100;700;20}{20;300;100}}"}}})",
+    R"({"defaultMode": "Pulse", "modes": {"Pulse": {"mode": "{{0;250;100}{100;250;0}}"}}})",
+};
+//!
+//! @brief Get the output of a processor
+//!
+static ModuleOut<double>* GetOut(const std::string& name)
+{
+    return BaseModule::GetModule<ModuleOut<double>>("/Processors/" + name + "/out");
+}
+//!
+//! @brief Get the activate input of a processor
+//!
+static ModuleIn<bool>* GetActivate(const std::string& name)
+{
+    return BaseModule::GetModule<ModuleIn<bool>>("/Processors/" + name + "/activate");
+}
+//!
+//! @brief Load processors "single<i>" evaluating themselves and "batched<i>" evaluated by the engine from the configs
+//!
+//! @param indices Indices of the configs to load
+//!
+static void Load(const std::vector<size_t>& indices)
+{
+    JsonDocument doc;
+    for (size_t i : indices)
+    {
+        for (bool batch : {false, true})
+        {
+            JsonDocument processor;
+            deserializeJson(processor, configs[i]);
+            processor["type"] = "sequence";
+            processor["batch"] = batch;
+            // Processors evaluating themselves update ramps on every loop like the engine
+            processor["resolution"] = 0;
+            doc["Processors"][(batch ? "batched" : "single") + std::to_string(i)] = processor;
+        }
+    }
+    BaseModule::UpdateConfig(doc.as<JsonObject>());
+}
+//!
+//! @brief Delete the processors loaded from the configs
+//!
+//! @param indices Indices of the configs loaded
+//!
+static void Unload(const std::vector<size_t>& indices)
+{
+    for (size_t i : indices)
+    {
+        BaseModule::Delete("/Processors/single" + std::to_string(i));
+        BaseModule::Delete("/Processors/batched" + std::to_string(i));
+    }
+}
+
+//!
+//! @brief Load the processors of data/Config.json
+//!
+//! @param resolution Resolution set to the sequence processors, the default of the processor if negative
+//! @return std::vector<std::string> Names of the sequence processors
+//!
+static std::vector<std::string> LoadConfigFile(double resolution)
+{
+    std::vector<std::string> names;
+    std::ifstream file("data/Config.json");
+    std::stringstream content;
+    content << file.rdbuf();
+    JsonDocument configFile;
+    deserializeJson(configFile, content.str());
+    JsonDocument doc;
+    doc["Processors"] = configFile["Processors"];
+    for (JsonPair processor : doc["Processors"].as<JsonObject>())
+    {
+        if (processor.value()["type"].as<std::string>() == SequenceProcessor::type)
+        {
+            names.push_back(processor.key().c_str());
+            if (resolution >= 0)
+            {
+                processor.value()["resolution"] = resolution;
+            }
+        }
+    }
+    BaseModule::UpdateConfig(doc.as<JsonObject>());
+    return names;
+}
+//!
+//! @brief Switch on the sequence processors of data/Config.json and count their evaluations in loops of 100 us
+//!
+//! @param names Names of the sequence processors
+//! @param duration Time to run in microseconds
+//! @return uint64_t Number of evaluations
+//!
+static uint64_t RunConfigFile(const std::vector<std::string>& names, uint64_t duration)
+{
+    for (const std::string& name : names)
+    {
+        GetActivate(name)->SetValue(true);
+    }
+    uint64_t before = Metrics::sequenceEvaluations.Get();
+    for (uint64_t end = now + duration; now < end; now += 100)
+    {
+        LoopEvent::Raise();
+    }
+    return Metrics::sequenceEvaluations.Get() - before;
+}
+
+void setUp()
+{
+    now = 1000000;
+    Clock::SetSource(&GetNow);
+}
+
+void tearDown()
+{
+    Clock::SetSource(nullptr);
+}
+
+//!
+//! @brief Processors in the engine set the same outputs as processors evaluating themselves while they are
+//! switched on and off at times inside and outside of their pieces
+//!
+void test_engine_equals_processors()
+{
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < configs.size(); i++)
+    {
+        indices.push_back(i);
+    }
+    Load(indices);
+    TEST_ASSERT_EQUAL(configs.size(), SequenceEngine::GetSize());
+    size_t compared = 0;
+    // 20 seconds in loops of 7 ms, switched on after 0.1 s, off after 9 s and on again after 12.5 s
+    for (uint64_t loop = 0; loop < 20000 / 7; loop++)
+    {
+        uint64_t elapsed = loop * 7000;
+        for (size_t i = 0; i < configs.size(); i++)
+        {
+            bool activate = (elapsed >= 100000 && elapsed < 9000000) || elapsed >= 12500000;
+            GetActivate("single" + std::to_string(i))->SetValue(activate);
+            GetActivate("batched" + std::to_string(i))->SetValue(activate);
+        }
+        LoopEvent::Raise();
+        for (size_t i = 0; i < configs.size(); i++)
+        {
+            std::string message = "config " + std::to_string(i) + " at " + std::to_string(elapsed) + " us";
+            TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(1e-9, GetOut("single" + std::to_string(i))->GetValue(), GetOut("batched" + std::to_string(i))->GetValue(), message.c_str());
+            compared++;
+        }
+        now += 7000;
+    }
+    TEST_ASSERT_EQUAL(configs.size() * (20000 / 7), compared);
+    Unload(indices);
+    TEST_ASSERT_EQUAL(0, SequenceEngine::GetSize());
+}
+
+//!
+//! @brief Engine without ramping lanes sleeps until the next piece ends and is woken by inputs
+//!
+void test_engine_sleeps_between_pieces()
+{
+    Load({1});
+    ModuleIn<bool>* activate = GetActivate("batched1");
+    // Only the processor in the engine is switched on
+    activate->SetValue(true);
+    LoopEvent::Raise();
+    uint64_t before = Metrics::sequenceEvaluations.Get();
+    clockReads = 0;
+    // One second in loops of 1 ms, the strobe has four pieces per second
+    for (size_t loop = 0; loop < 1000; loop++)
+    {
+        LoopEvent::Raise();
+        now += 1000;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(5, Metrics::sequenceEvaluations.Get() - before);
+    // Sleeping listeners only check the time, the engine is only called at the ends of the pieces
+    // (an engine called on every loop reads the time 6000 times)
+    TEST_ASSERT_LESS_OR_EQUAL(4 * 1000 + 2 * 5, clockReads);
+    // Switching off is evaluated on the next loop, not at the end of the actual piece
+    activate->SetValue(false);
+    before = Metrics::sequenceEvaluations.Get();
+    LoopEvent::Raise();
+    TEST_ASSERT_EQUAL(1, Metrics::sequenceEvaluations.Get() - before);
+    Unload({1});
+}
+
+//!
+//! @brief Processors of data/Config.json only wake for changes of their output: the two ramps of the on-sequences
+//! in steps of the default resolution and the pieces of the strobes, instead of on every loop
+//!
+void test_config_file_evaluations()
+{
+    constexpr uint64_t second = 1000000;
+    std::vector<std::string> names = LoadConfigFile(0);
+    TEST_ASSERT_EQUAL(7, names.size());
+    uint64_t everyMicrosecond = RunConfigFile(names, 10 * second);
+    for (const std::string& name : names)
+    {
+        BaseModule::Delete("/Processors/" + name);
+    }
+    BaseModule::Delete("/Processors/Gain1");
+    names = LoadConfigFile(-1);
+    // The ramps of the on-sequences (2 s to 60 % and 1 s to 100 %) take 600 and 1000 steps of 0.1 %
+    uint64_t ramps = RunConfigFile(names, 2 * second);
+    // Afterwards the beacon and the strobes change 3, 4 and 2 times per second, the constant processors sleep
+    uint64_t steady = RunConfigFile(names, 8 * second);
+    std::string message = "Evaluations of data/Config.json in 10 s at 100 us per loop: " + std::to_string(ramps + steady)
+        + " (ramps " + std::to_string(ramps) + ", steady " + std::to_string(steady) + "), resolution 0: " + std::to_string(everyMicrosecond)
+        + ", evaluated on every loop: " + std::to_string(names.size() * 100000);
+    TEST_MESSAGE(message.c_str());
+    TEST_ASSERT_LESS_OR_EQUAL(600 + 1000 + 2 * (3 + 4 + 2) + 20, ramps);
+    TEST_ASSERT_LESS_OR_EQUAL(8 * (3 + 4 + 2) + 10, steady);
+    TEST_ASSERT_LESS_OR_EQUAL(everyMicrosecond / 10, ramps + steady);
+    for (const std::string& name : names)
+    {
+        BaseModule::Delete("/Processors/" + name);
+    }
+    BaseModule::Delete("/Processors/Gain1");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_engine_equals_processors);
+    RUN_TEST(test_engine_sleeps_between_pieces);
+    RUN_TEST(test_config_file_evaluations);
+    return UNITY_END();
+}
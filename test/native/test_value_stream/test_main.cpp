@@ -0,0 +1,186 @@
+//!
+//! @file test_main.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Native load tests of the ValueStream with 20 subscribers on the WebSocket of the stub server
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include <unity.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ValueStream.hpp"
+#include "ModuleOut.hpp"
+#include "LoopEvent.hpp"
+
+using namespace ModelController;
+
+//!
+//! @brief Simulated time in microseconds
+//!
+static uint64_t now = 0;
+//!
+//! @brief Source of the Clock returning the simulated time
+//!
+static uint64_t GetNow()
+{
+    return now;
+}
+//!
+//! @brief Server the ValueStream is added to
+//!
+static AsyncWebServer server(80);
+//!
+//! @brief Number of outputs changing on every loop
+//!
+static constexpr size_t numberOutputs = 10;
+//!
+//! @brief Outputs "/value<i>" changing on every loop
+//!
+static std::vector<std::unique_ptr<ModuleOut<double>>> outputs;
+//!
+//! @brief Get the WebSocket of the ValueStream
+//!
+static AsyncWebSocket& GetSocket()
+{
+    return *server.handlers[0];
+}
+//!
+//! @brief Run loops of 1 ms, changing all outputs on every loop if change is set
+//!
+//! @param duration Time to run in milliseconds
+//! @param change True to change the outputs
+//!
+static void Run(uint64_t duration, bool change)
+{
+    for (uint64_t loop = 0; loop < duration; loop++)
+    {
+        for (size_t i = 0; i < outputs.size() && change; i++)
+        {
+            outputs[i]->SetValue(static_cast<double>(now / 1000 + i));
+        }
+        LoopEvent::Raise();
+        now += 1000;
+    }
+}
+//!
+//! @brief Check that the last message to the client has the latest values of the outputs
+//!
+//! @param client Client to check
+//! @param indices Indices of the outputs the client subscribed to
+//!
+static void CheckLatest(AsyncWebSocketClient* client, const std::vector<size_t>& indices)
+{
+    JsonDocument frame;
+    TEST_ASSERT_FALSE(client->messages.empty());
+    TEST_ASSERT_FALSE(deserializeJson(frame, client->messages.back()));
+    for (size_t i : indices)
+    {
+        std::string path = "/value" + std::to_string(i);
+        TEST_ASSERT_TRUE_MESSAGE(frame[path].is<double>(), path.c_str());
+        TEST_ASSERT_EQUAL_DOUBLE(outputs[i]->GetValue(), frame[path].as<double>());
+    }
+}
+
+void setUp()
+{
+    now = 1000000;
+    Clock::SetSource(&GetNow);
+}
+
+void tearDown()
+{
+    Clock::SetSource(nullptr);
+}
+
+//!
+//! @brief 20 subscribers with two prefixes each and intervals of 20 to 39 ms get at most one frame per interval,
+//! only with their paths and the latest values after the changes stop
+//!
+void test_twenty_subscribers()
+{
+    std::vector<AsyncWebSocketClient*> clients;
+    for (size_t i = 0; i < 20; i++)
+    {
+        clients.push_back(GetSocket().Connect());
+        std::string message = "{\"subscribe\": [\"/value" + std::to_string(i % numberOutputs) + "\", \"/value" + std::to_string((i + 1) % numberOutputs)
+            + "\"], \"interval\": " + std::to_string(20 + i) + "}";
+        GetSocket().Receive(clients[i]->id(), message);
+    }
+    Run(1, false);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Run(5000, true);
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    size_t frames = 0;
+    for (size_t i = 0; i < clients.size(); i++)
+    {
+        // One frame per interval, the first one right after the subscription
+        TEST_ASSERT_LESS_OR_EQUAL(5000 / (20 + i) + 1, clients[i]->messages.size());
+        TEST_ASSERT_GREATER_OR_EQUAL(5000 / (20 + i) - 1, clients[i]->messages.size());
+        frames += clients[i]->messages.size();
+        JsonDocument frame;
+        deserializeJson(frame, clients[i]->messages.front());
+        TEST_ASSERT_EQUAL(2, frame.as<JsonObject>().size());
+    }
+    std::string message = "20 subscribers, " + std::to_string(numberOutputs) + " outputs changing every 1 ms: " + std::to_string(elapsed / 5000)
+        + " us per loop, " + std::to_string(frames / 5) + " frames/s";
+    TEST_MESSAGE(message.c_str());
+    Run(40, false);
+    for (size_t i = 0; i < clients.size(); i++)
+    {
+        CheckLatest(clients[i], {i % numberOutputs, (i + 1) % numberOutputs});
+        GetSocket().Disconnect(clients[i]->id());
+    }
+    Run(1, false);
+}
+
+//!
+//! @brief A subscriber without space in its queue doesn't stall the others and gets the latest values once it catches up
+//!
+void test_slow_subscriber()
+{
+    AsyncWebSocketClient* slow = GetSocket().Connect();
+    AsyncWebSocketClient* fast = GetSocket().Connect();
+    GetSocket().Receive(slow->id(), R"({"subscribe": [""], "interval": 20})");
+    GetSocket().Receive(fast->id(), R"({"subscribe": [""], "interval": 20})");
+    Run(1, false);
+    slow->writable = false;
+    Run(2000, true);
+    TEST_ASSERT_EQUAL(0, slow->messages.size());
+    TEST_ASSERT_GREATER_OR_EQUAL(99, fast->messages.size());
+    // One frame waits in the outbox, at most eight more are queued (older ones are merged)
+    slow->writable = true;
+    Run(100, false);
+    TEST_ASSERT_LESS_OR_EQUAL(1 + 8 + 1, slow->messages.size());
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < numberOutputs; i++)
+    {
+        indices.push_back(i);
+    }
+    CheckLatest(slow, indices);
+    CheckLatest(fast, indices);
+    // Frames of a disconnected client are dropped
+    uint32_t id = slow->id();
+    slow->writable = false;
+    Run(100, true);
+    GetSocket().Disconnect(id);
+    GetSocket().Disconnect(fast->id());
+    Run(1, true);
+    TEST_ASSERT_NULL(GetSocket().client(id));
+}
+
+int main()
+{
+    ValueStream::Initialize(server);
+    for (size_t i = 0; i < numberOutputs; i++)
+    {
+        outputs.push_back(std::make_unique<ModuleOut<double>>("value" + std::to_string(i)));
+    }
+    UNITY_BEGIN();
+    RUN_TEST(test_twenty_subscribers);
+    RUN_TEST(test_slow_subscriber);
+    int failures = UNITY_END();
+    outputs.clear();
+    return failures;
+}
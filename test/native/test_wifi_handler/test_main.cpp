@@ -0,0 +1,164 @@
+//!
+//! @file test_main.cpp
+//! @author Marius Roggenbuck (roggenbuckmarius@gmail.com)
+//! @brief Native tests of the WiFiHandler against the recording WiFi driver: fast connect, fallback to scan, reconnects and AP
+//!
+//! @copyright Copyright (c) 2024
+//!
+#include <unity.h>
+#include <LittleFS.h>
+#include "WiFiHandler.hpp"
+#include "Metrics.hpp"
+
+using namespace ModelController;
+
+//!
+//! @brief Simulated time in microseconds
+//!
+static uint64_t now = 0;
+//!
+//! @brief Source of the Clock returning the simulated time
+//!
+static uint64_t GetNow()
+{
+    return now;
+}
+//!
+//! @brief Call Check() every millisecond like the loop
+//!
+//! @param duration Time to run in milliseconds
+//! @return int Number of calls to WiFi.begin() meanwhile
+//!
+static int Run(uint64_t duration)
+{
+    int begins = WiFi.begins;
+    for (uint64_t end = now + duration * 1000; now < end; now += 1000)
+    {
+        WiFiHandler::Check();
+    }
+    return WiFi.begins - begins;
+}
+//!
+//! @brief Set the station config, which begins the STA
+//!
+//! @param ssid SSID of the station
+//!
+static void Configure(const char* ssid)
+{
+    JsonDocument config;
+    config["ssid"] = ssid;
+    config["password"] = "password";
+    WiFiHandler::SetConfig(config.as<JsonObject>());
+}
+
+void setUp()
+{
+    Clock::SetSource(&GetNow);
+}
+
+void tearDown()
+{
+    Clock::SetSource(nullptr);
+}
+
+//!
+//! @brief Without cache the first attempt scans, the connection is cached and a lost link is reconnected to the cached access point
+//!
+void test_connect_and_cache()
+{
+    now = 1000000;
+    LittleFS.files.clear();
+    Configure("station");
+    TEST_ASSERT_EQUAL(WiFiHandler::State::eConnecting, WiFiHandler::GetState());
+    TEST_ASSERT_EQUAL(1, WiFi.begins);
+    TEST_ASSERT_EQUAL(0, WiFi.beginChannel);
+    TEST_ASSERT_FALSE(WiFi.beginBSSID);
+    // Link is up after 1.2 s, the handler only reads the stored event until then
+    TEST_ASSERT_EQUAL(0, Run(1200));
+    WiFi.Raise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    TEST_ASSERT_TRUE(WiFiHandler::Check());
+    TEST_ASSERT_TRUE(WiFiHandler::IsConnected());
+    TEST_ASSERT_EQUAL(1200, Metrics::wifiAttemptTime.Get());
+    TEST_ASSERT_TRUE(LittleFS.exists("/wifi.cache"));
+    // Lost link is reconnected to the cached BSSID and channel
+    uint64_t disconnects = Metrics::wifiDisconnects.Get();
+    WiFi.Raise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    TEST_ASSERT_EQUAL(1, Run(1));
+    TEST_ASSERT_EQUAL(disconnects + 1, Metrics::wifiDisconnects.Get());
+    TEST_ASSERT_EQUAL(WiFiHandler::State::eConnecting, WiFiHandler::GetState());
+    TEST_ASSERT_EQUAL(WiFi.apChannel, WiFi.beginChannel);
+    TEST_ASSERT_TRUE(WiFi.beginBSSID);
+    TEST_ASSERT_EQUAL(0, Run(299));
+    WiFi.Raise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    Run(1);
+    TEST_ASSERT_TRUE(WiFiHandler::IsConnected());
+    // Attempt started on the loop the link was lost
+    TEST_ASSERT_EQUAL(300, Metrics::wifiConnectTime.Get());
+    TEST_ASSERT_EQUAL(300, Metrics::wifiAttemptTime.Get());
+}
+
+//!
+//! @brief A cached access point, which doesn't answer, falls back to a scan without counting as reconnect,
+//! failing scans are retried after the timeout and the AP is started after the last reconnect
+//!
+void test_fallback_reconnects_ap()
+{
+    uint64_t fastFailed = Metrics::wifiFastConnectFailed.Get();
+    int softAPs = WiFi.softAPs;
+    WiFi.Raise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    TEST_ASSERT_EQUAL(1, Run(1));
+    TEST_ASSERT_TRUE(WiFi.beginBSSID);
+    // Cached access point doesn't answer within the timeout of 5 s
+    TEST_ASSERT_EQUAL(0, Run(5000));
+    TEST_ASSERT_EQUAL(1, Run(1));
+    TEST_ASSERT_EQUAL(fastFailed + 1, Metrics::wifiFastConnectFailed.Get());
+    TEST_ASSERT_EQUAL(0, WiFi.beginChannel);
+    TEST_ASSERT_FALSE(WiFi.beginBSSID);
+    // Five reconnects with scans, one per timeout, then the AP
+    TEST_ASSERT_EQUAL(5, Run(6 * 5001 - 1));
+    TEST_ASSERT_EQUAL(WiFiHandler::State::eConnecting, WiFiHandler::GetState());
+    TEST_ASSERT_EQUAL(softAPs, WiFi.softAPs);
+    Run(1);
+    TEST_ASSERT_EQUAL(WiFiHandler::State::eAccessPoint, WiFiHandler::GetState());
+    TEST_ASSERT_EQUAL(softAPs + 1, WiFi.softAPs);
+    TEST_ASSERT_EQUAL(WIFI_AP, WiFi.currentMode);
+    TEST_ASSERT_TRUE(WiFiHandler::Check());
+    TEST_ASSERT_FALSE(WiFiHandler::IsConnected());
+    // AP stays up, the driver isn't called anymore
+    TEST_ASSERT_EQUAL(0, Run(60000));
+    TEST_ASSERT_EQUAL(softAPs + 1, WiFi.softAPs);
+    TEST_ASSERT_EQUAL(fastFailed + 1, Metrics::wifiFastConnectFailed.Get());
+}
+
+//!
+//! @brief The config restarts the STA from the AP, the cache of another SSID isn't used and is replaced after the connection
+//!
+void test_cache_other_ssid()
+{
+    Configure("other");
+    TEST_ASSERT_EQUAL(WiFiHandler::State::eConnecting, WiFiHandler::GetState());
+    TEST_ASSERT_EQUAL(WIFI_STA, WiFi.currentMode);
+    TEST_ASSERT_EQUAL(0, WiFi.beginChannel);
+    TEST_ASSERT_FALSE(WiFi.beginBSSID);
+    WiFi.apChannel = 11;
+    WiFi.Raise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    Run(1);
+    TEST_ASSERT_TRUE(WiFiHandler::IsConnected());
+    // Cache follows the connected access point
+    WiFi.Raise(ARDUINO_EVENT_WIFI_STA_LOST_IP);
+    Run(1);
+    TEST_ASSERT_EQUAL(11, WiFi.beginChannel);
+    TEST_ASSERT_TRUE(WiFi.beginBSSID);
+    WiFi.Raise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    Run(1);
+    TEST_ASSERT_EQUAL(WiFiHandler::State::eConnected, WiFiHandler::GetState());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_connect_and_cache);
+    RUN_TEST(test_fallback_reconnects_ap);
+    RUN_TEST(test_cache_other_ssid);
+    return UNITY_END();
+}